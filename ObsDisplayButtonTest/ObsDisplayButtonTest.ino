@@ -7,12 +7,17 @@
  * - black on white when the button is pressed
  * along with some unicode symbols.
  * 
+ * The time it takes to transfer a frame to the display is printed on the serial (115200 baud); on the ESP32, the
+ * software I2C and hardware I2C transfer is compared at startup.
+ * The button is read by an edge interrupt (debounced, with the time of each edge), so that the latency from the
+ * button edge until the frame has been sent can be measured; its distribution is printed every few edges.
+ *
  * Make sure your hardware and the display operate on compatible voltage levels!
  * The OBS logo bitmap has been taken from https://github.com/openbikesensor/OpenBikeSensorFirmware/blob/b4db7c662f48321e686d175fd6e9fc4e9c56afd5/src/logo.h#L31.
  */
 
 #include <U8g2lib.h>
-//#include <Wire.h> //I2C did not seem to work
+#include <Wire.h>
 
 // Make sure that the button pin is pulled-down via a hardware resistor (as a pressed button will connect to VCC on the OBS display module);
 // otherwise the input pin will float around and the display may show garbage.
@@ -20,10 +25,48 @@
 // No problem on Arduino UNO (except the voltage levels!)
 #define BUTTON_PIN  2 // pin IO2 is also used on the OBS PCB for the button (ESP32-based board)
 
+// Use hardware I2C (the microcontroller's I2C peripheral) instead of software I2C (bit-banged by the CPU)
+#ifndef DISPLAY_HW_I2C
+#define DISPLAY_HW_I2C 1
+#endif
+#define I2C_BUS_CLOCK 400000 // SSD1306 fast mode (hardware I2C only)
+#define NUM_TIMED_FRAMES 16 // frames sent per backend for the startup comparison
+
+#define DEBOUNCE_US 20000 // edges within this time after a (debounced) edge are bounces
+#define EDGE_QUEUE_SIZE 8 // debounced edges not yet handled by loop()
+#if defined(ESP32)
+#define NUM_LATENCY_SAMPLES 64 // the latest edges taken into account for the latency distribution
+#define BUTTON_ISR_ATTR IRAM_ATTR
+#else
+#define NUM_LATENCY_SAMPLES 16 // little RAM next to the frame buffer
+#define BUTTON_ISR_ATTR
+#endif
+#define LATENCY_REPORT_EDGES 8 // print the latency distribution after this many edges
+
+typedef struct
+{
+  unsigned long time_us; // micros() of the edge
+  bool pressed;
+} button_edge_t;
+
 // Choosing a specific U8g2 constructor for our display
 // (The complete list is available here: https://github.com/olikraus/u8g2/wiki/u8g2setupcpp)
+// Note: the HW_I2C constructors take the reset pin first (unlike SW_I2C), passing the pins in SW_I2C order was the
+// reason why hardware I2C "did not seem to work".
+#if DISPLAY_HW_I2C
+U8G2_SSD1306_128X64_NONAME_F_HW_I2C u8g2(U8G2_R0, /* reset=*/ U8X8_PIN_NONE, /* clock=*/ SCL, /* data=*/ SDA);
+#else
 U8G2_SSD1306_128X64_NONAME_F_SW_I2C u8g2(U8G2_R0, /* clock=*/ SCL, /* data=*/ SDA, /* reset=*/ U8X8_PIN_NONE);
-//U8G2_SSD1306_128X64_NONAME_F_HW_I2C u8g2(U8G2_R0, /* clock=*/ SCL, /* data=*/ SDA, /* reset=*/ U8X8_PIN_NONE); // does not seem to work
+#endif
+
+#if defined(ESP32)
+// enough RAM for a second frame buffer: the other backend, for comparing the transfer time at startup
+#if DISPLAY_HW_I2C
+U8G2_SSD1306_128X64_NONAME_F_SW_I2C u8g2Other(U8G2_R0, /* clock=*/ SCL, /* data=*/ SDA, /* reset=*/ U8X8_PIN_NONE);
+#else
+U8G2_SSD1306_128X64_NONAME_F_HW_I2C u8g2Other(U8G2_R0, /* reset=*/ U8X8_PIN_NONE, /* clock=*/ SCL, /* data=*/ SDA);
+#endif
+#endif
 
 #define OBSLogo_width 128
 #define OBSLogo_height 64
@@ -117,48 +160,269 @@ const unsigned char OBSLogo [] PROGMEM = {
   0x00, 0x00, 0x00, 0x00
 };
 
-void draw_display(bool button_pressed)
+// debounced button edges, from the interrupt to loop()
+volatile button_edge_t edge_queue[EDGE_QUEUE_SIZE];
+volatile uint8_t edge_head = 0; // next to write
+volatile uint8_t edge_tail = 0; // next to read
+volatile bool stable_pressed = false; // button state after debouncing
+volatile unsigned long last_edge_us = 0; // time of the last debounced edge
+volatile unsigned int edges_dropped = 0;
+#if defined(ESP32)
+// noInterrupts() does nothing on the ESP32 (and would not keep out the other core): a spinlock section instead
+portMUX_TYPE edge_mux = portMUX_INITIALIZER_UNLOCKED;
+#define EDGE_LOCK_ISR() portENTER_CRITICAL_ISR(&edge_mux)
+#define EDGE_UNLOCK_ISR() portEXIT_CRITICAL_ISR(&edge_mux)
+#define EDGE_LOCK() portENTER_CRITICAL(&edge_mux)
+#define EDGE_UNLOCK() portEXIT_CRITICAL(&edge_mux)
+#else
+#define EDGE_LOCK_ISR() // interrupts are disabled in the ISR on AVR
+#define EDGE_UNLOCK_ISR()
+#define EDGE_LOCK() noInterrupts()
+#define EDGE_UNLOCK() interrupts()
+#endif
+
+// latency (us) of the latest edges: until loop() starts drawing, and until the frame has been sent
+unsigned long dispatch_latency_us[NUM_LATENCY_SAMPLES];
+unsigned long frame_latency_us[NUM_LATENCY_SAMPLES];
+uint8_t num_latency_samples = 0;
+uint8_t next_latency_sample = 0;
+unsigned int num_edges = 0;
+
+void BUTTON_ISR_ATTR take_edge()
+{
+  // debouncing: the first edge wins, further ones within DEBOUNCE_US are bounces;
+  // called by the interrupt and (to catch up with an edge swallowed as a bounce) by loop(), both within the edge lock
+  unsigned long now_us = micros();
+  bool pressed = (digitalRead(BUTTON_PIN) == HIGH);
+  if(pressed == stable_pressed || (now_us - last_edge_us) < DEBOUNCE_US)
+  {
+    return;
+  }
+  stable_pressed = pressed;
+  last_edge_us = now_us;
+
+  uint8_t next = (edge_head + 1) % EDGE_QUEUE_SIZE;
+  if(next == edge_tail)
+  {
+    edges_dropped++;
+    return;
+  }
+  edge_queue[edge_head].time_us = now_us;
+  edge_queue[edge_head].pressed = pressed;
+  edge_head = next;
+}
+
+void BUTTON_ISR_ATTR button_isr()
+{
+  EDGE_LOCK_ISR();
+  take_edge();
+  EDGE_UNLOCK_ISR();
+}
+
+bool get_button_edge(button_edge_t *edge)
+{
+  // returns the oldest debounced edge not handled yet (false if there is none)
+  bool available;
+  EDGE_LOCK();
+  take_edge();
+  available = (edge_tail != edge_head);
+  if(available)
+  {
+    edge->time_us = edge_queue[edge_tail].time_us;
+    edge->pressed = edge_queue[edge_tail].pressed;
+    edge_tail = (edge_tail + 1) % EDGE_QUEUE_SIZE;
+  }
+  EDGE_UNLOCK();
+  return available;
+}
+
+void setup_button()
+{
+  pinMode(BUTTON_PIN, INPUT);
+  stable_pressed = (digitalRead(BUTTON_PIN) == HIGH);
+  last_edge_us = micros();
+  attachInterrupt(digitalPinToInterrupt(BUTTON_PIN), button_isr, CHANGE);
+}
+
+void sort_samples(unsigned long *samples, uint8_t num)
+{
+  // insertion sort, there are only a few samples
+  for(uint8_t i = 1; i < num; i++)
+  {
+    unsigned long sample = samples[i];
+    uint8_t j = i;
+    while(j > 0 && samples[j - 1] > sample)
+    {
+      samples[j] = samples[j - 1];
+      j--;
+    }
+    samples[j] = sample;
+  }
+}
+
+void print_distribution(const char *name, const unsigned long *samples, uint8_t num)
+{
+  static unsigned long sorted[NUM_LATENCY_SAMPLES];
+  memcpy(sorted, samples, num * sizeof(unsigned long));
+  sort_samples(sorted, num);
+
+  Serial.print(name);
+  Serial.print(F(" (us): min "));
+  Serial.print(sorted[0]);
+  Serial.print(F(", median "));
+  Serial.print(sorted[num / 2]);
+  Serial.print(F(", p99 "));
+  Serial.print(sorted[(num * 99) / 100]);
+  Serial.print(F(", max "));
+  Serial.println(sorted[num - 1]);
+}
+
+void add_latency(unsigned long dispatch_us, unsigned long frame_us)
 {
-  u8g2.clearBuffer();
+  dispatch_latency_us[next_latency_sample] = dispatch_us;
+  frame_latency_us[next_latency_sample] = frame_us;
+  next_latency_sample = (next_latency_sample + 1) % NUM_LATENCY_SAMPLES;
+  if(num_latency_samples < NUM_LATENCY_SAMPLES)
+  {
+    num_latency_samples++;
+  }
+
+  if(++num_edges % LATENCY_REPORT_EDGES == 0)
+  {
+    Serial.print(F("Latency of the last "));
+    Serial.print(num_latency_samples);
+    Serial.print(F(" edges ("));
+    Serial.print(edges_dropped);
+    Serial.println(F(" dropped):"));
+    print_distribution("  edge to drawing", dispatch_latency_us, num_latency_samples);
+    print_distribution("  edge to frame sent", frame_latency_us, num_latency_samples);
+  }
+}
+
+const char* backend_name(bool hw_i2c)
+{
+  return hw_i2c ? "HW I2C" : "SW I2C";
+}
+
+void draw_frame(U8G2 &display, bool button_pressed)
+{
+  display.clearBuffer();
 
   // draw the logo (black on white or vice versa, dependent on button state)
-  u8g2.setDrawColor(button_pressed ? 0 : 1);
-  u8g2.drawXBMP(0, 0, OBSLogo_width, OBSLogo_height, OBSLogo);
+  display.setDrawColor(button_pressed ? 0 : 1);
+  display.drawXBMP(0, 0, OBSLogo_width, OBSLogo_height, OBSLogo);
 
   // print the button state as text
-  u8g2.setFont(u8g2_font_7x13_t_symbols);
-  u8g2.drawStr(66, 40, "BUTTON");
-  u8g2.drawStr(66, 53, button_pressed ? "PRESSED" : "RELEASED");
+  display.setFont(u8g2_font_7x13_t_symbols);
+  display.drawStr(66, 40, "BUTTON");
+  display.drawStr(66, 53, button_pressed ? "PRESSED" : "RELEASED");
 
   // add some nice Unicode symbols (need to switch font)
-  u8g2.setFont(u8g2_font_unifont_t_symbols);
-  u8g2.drawGlyph(86, 27, 0x25c9); // filled double-circle
+  display.setFont(u8g2_font_unifont_t_symbols);
+  display.drawGlyph(86, 27, 0x25c9); // filled double-circle
   if(button_pressed)
   {
-    u8g2.drawGlyph(86, 18, 0x21e9); // arrow down
+    display.drawGlyph(86, 18, 0x21e9); // arrow down
+  }
+}
+
+unsigned long send_frame(U8G2 &display)
+{
+  // returns the transfer time in microseconds
+  unsigned long start = micros();
+  display.sendBuffer();
+  return micros() - start;
+}
+
+void setup_display(U8G2 &display, bool hw_i2c)
+{
+  if(hw_i2c)
+  {
+    display.setBusClock(I2C_BUS_CLOCK);
   }
+  display.begin();
+  display.setBitmapMode(false /* solid */);
+  display.setFlipMode(1); // rotate display content by 180 degrees
+}
+
+void time_transfer(U8G2 &display, bool hw_i2c)
+{
+  // sends a number of full frames and prints min/average/max of the transfer time
+  unsigned long min_us = 0xFFFFFFFF;
+  unsigned long max_us = 0;
+  unsigned long sum_us = 0;
+
+  for(uint8_t i = 0; i < NUM_TIMED_FRAMES; i++)
+  {
+    draw_frame(display, /*button_pressed=*/(i % 2) == 1);
+    unsigned long us = send_frame(display);
+    if(us < min_us)
+    {
+      min_us = us;
+    }
+    if(us > max_us)
+    {
+      max_us = us;
+    }
+    sum_us += us;
+  }
+
+  Serial.print(backend_name(hw_i2c));
+  Serial.print(F(" frame transfer (us): min "));
+  Serial.print(min_us);
+  Serial.print(F(", avg "));
+  Serial.print(sum_us / NUM_TIMED_FRAMES);
+  Serial.print(F(", max "));
+  Serial.println(max_us);
+}
 
-  u8g2.sendBuffer();
+unsigned long draw_display(bool button_pressed)
+{
+  // returns micros() when the frame has been sent (before the transfer time is printed)
+  draw_frame(u8g2, button_pressed);
+  unsigned long us = send_frame(u8g2);
+  unsigned long sent_us = micros();
+
+  Serial.print(backend_name(DISPLAY_HW_I2C));
+  Serial.print(F(" frame transfer: "));
+  Serial.print(us);
+  Serial.println(F(" us"));
+  return sent_us;
 }
 
 void setup(void)
 {
-  pinMode(BUTTON_PIN, INPUT);
-  u8g2.begin();
-  u8g2.setBitmapMode(false /* solid */);
-  u8g2.setFlipMode(1); // rotate display content by 180 degrees
+  Serial.begin(115200);
+  setup_button();
+
+#if defined(ESP32)
+  // compare with the other backend first, the one used for the test is set up last (and keeps the pins)
+  setup_display(u8g2Other, !DISPLAY_HW_I2C);
+  time_transfer(u8g2Other, !DISPLAY_HW_I2C);
+#if !DISPLAY_HW_I2C
+  Wire.end(); // hand the pins back for bit-banging
+#endif
+#endif
+
+  setup_display(u8g2, DISPLAY_HW_I2C);
+#if defined(ESP32)
+  time_transfer(u8g2, DISPLAY_HW_I2C);
+#endif
+
+  draw_display(stable_pressed);
 }
 
 void loop(void)
 {
-  draw_display(/*button_pressed=*/false);
-
-  // wait until button is pressed
-  while( digitalRead(BUTTON_PIN) == LOW );
+  button_edge_t edge;
 
-  draw_display(/*button_pressed=*/true);
-  delay(100);
+  if(!get_button_edge(&edge))
+  {
+    delay(1); // nothing to do (no busy-waiting on the pin); counts into the latency until drawing
+    return;
+  }
 
-  // wait until button is no longer pressed
-  while( digitalRead(BUTTON_PIN) == HIGH );
+  unsigned long start_us = micros();
+  unsigned long sent_us = draw_display(edge.pressed);
+  add_latency(start_us - edge.time_us, sent_us - edge.time_us);
 }
@@ -0,0 +1,243 @@
+#include "Benchmark.h"
+#include "GpsSerial.h"
+
+#if defined(ARDUINO_HOST_BUILD)
+#include <chrono>
+#endif
+
+namespace
+{
+  int compareTicks(const void* a, const void* b)
+  {
+    uint32_t ticksA = *(const uint32_t*)a;
+    uint32_t ticksB = *(const uint32_t*)b;
+    return (ticksA > ticksB) - (ticksA < ticksB);
+  }
+
+  size_t appendNmeaSentence(char* pBuf, size_t size, size_t len, const char* pBody)
+  {
+    // adds "$<body>*<checksum>\r\n" to the buffer (if it fits)
+    uint8_t checksum = 0;
+    for(const char* p=pBody; *p != '\0'; p++)
+    {
+      checksum ^= (uint8_t)*p;
+    }
+    int n = snprintf(pBuf + len, size - len, "$%s*%02X\r\n", pBody, checksum);
+    return (n > 0 && (size_t)n < size - len) ? len + n : len;
+  }
+
+  size_t finishUbxFrame(uint8_t* pBuf, uint8_t msgClass, uint8_t msgId, uint16_t payloadLen)
+  {
+    // sync chars, header and checksum around the payload that is in place already (at offset 6)
+    size_t frameLen = 2 + GpsSoftwareSerial::UBX_FRAME_HEADER_LEN + payloadLen + 2;
+    pBuf[0] = 0xB5;
+    pBuf[1] = 0x62;
+    pBuf[2] = msgClass;
+    pBuf[3] = msgId;
+    pBuf[4] = payloadLen & 0xFF;
+    pBuf[5] = payloadLen >> 8;
+    uint16_t checksum = GpsSoftwareSerial::calcFletcherChecksum(&pBuf[2], GpsSoftwareSerial::UBX_FRAME_HEADER_LEN + payloadLen);
+    pBuf[frameLen - 2] = checksum >> 8;
+    pBuf[frameLen - 1] = checksum & 0xFF;
+    return frameLen;
+  }
+}
+
+BenchSampler::BenchSampler(const char* name) :
+    mName(name),
+    mStart(0),
+    mNumSamples(0),
+    mSorted(false)
+{
+}
+
+uint32_t BenchSampler::now()
+{
+#if defined(ARDUINO_HOST_BUILD)
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+  return ESP.getCycleCount();
+#endif
+}
+
+uint32_t BenchSampler::ticksPerUs()
+{
+#if defined(ARDUINO_HOST_BUILD)
+  return 1000;
+#else
+  return getCpuFrequencyMhz();
+#endif
+}
+
+const char* BenchSampler::tickUnit()
+{
+#if defined(ARDUINO_HOST_BUILD)
+  return "ns";
+#else
+  return "cycles";
+#endif
+}
+
+void BenchSampler::stop()
+{
+  uint32_t ticks = now() - mStart; // wraps around correctly
+  if(mNumSamples < BENCH_MAX_SAMPLES)
+  {
+    mSamples[mNumSamples++] = ticks;
+    mSorted = false;
+  }
+}
+
+uint32_t BenchSampler::getPercentile(uint8_t percent)
+{
+  if(mNumSamples == 0)
+  {
+    return 0;
+  }
+  if(!mSorted)
+  {
+    qsort(mSamples, mNumSamples, sizeof(mSamples[0]), compareTicks);
+    mSorted = true;
+  }
+  return mSamples[((uint32_t)(mNumSamples - 1) * percent + 50) / 100];
+}
+
+void BenchSampler::print(Print& out, const char* unitName, uint32_t unitsPerSample)
+{
+  static const uint8_t percentiles[] = {0, 50, 90, 99, 100};
+  static const char* const labels[] = {"min", "p50", "p90", "p99", "max"};
+
+  out.print(mName);
+  out.print(F(" ("));
+  out.print(mNumSamples);
+  out.print(F(" samples, "));
+  out.print(tickUnit());
+  out.print(F(")"));
+  for(uint8_t i=0; i<sizeof(percentiles); i++)
+  {
+    out.print(F(" "));
+    out.print(labels[i]);
+    out.print(F(": "));
+    out.print(getPercentile(percentiles[i]));
+  }
+  if(unitsPerSample > 0)
+  {
+    // median normalized to one unit (byte, call, frame, ...)
+    out.print(F(" -> "));
+    out.print((double)getPercentile(50) * 1000.0 / ticksPerUs() / unitsPerSample, 1);
+    out.print(F(" ns/"));
+    out.print(unitName);
+  }
+  out.println();
+}
+
+uint32_t benchRandom(uint32_t* pState)
+{
+  // xorshift32
+  uint32_t x = *pState;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *pState = x;
+  return x;
+}
+
+uint8_t benchMakeSats(bench_sat_t* pSats, uint8_t numSats, uint32_t* pState)
+{
+  // distinct PRNs 1..32 (GPS), spread over the sky; a few without position (as seen right after startup)
+  uint32_t usedPrns = 0;
+  for(uint8_t i=0; i<numSats && i<32; i++)
+  {
+    uint8_t prn;
+    do
+    {
+      prn = 1 + benchRandom(pState) % 32;
+    } while(usedPrns & (1UL << (prn - 1)));
+    usedPrns |= 1UL << (prn - 1);
+
+    pSats[i].no = prn;
+    bool hasPosition = (benchRandom(pState) % 8) != 0;
+    pSats[i].elevation = hasPosition ? benchRandom(pState) % 91 : 0;
+    pSats[i].azimuth = hasPosition ? benchRandom(pState) % 360 : 0;
+    pSats[i].snr = benchRandom(pState) % 50;
+  }
+  return numSats;
+}
+
+size_t benchMakeGsvSentence(char* pBuf, size_t size, const bench_sat_t* pSats, uint8_t numSats, uint8_t msgNumber)
+{
+  char body[96];
+  uint8_t numMsgs = (numSats + 3) / 4;
+  int len = snprintf(body, sizeof(body), "GPGSV,%d,%d,%02d", numMsgs, msgNumber, numSats);
+  for(uint8_t i=(msgNumber - 1) * 4; i<numSats && i<msgNumber * 4 && len > 0 && (size_t)len < sizeof(body); i++)
+  {
+    len += snprintf(body + len, sizeof(body) - len, ",%02d,%02d,%03d,%02d", pSats[i].no, pSats[i].elevation,
+                    pSats[i].azimuth, pSats[i].snr);
+  }
+  return appendNmeaSentence(pBuf, size, 0, body);
+}
+
+size_t benchMakeNmeaEpoch(char* pBuf, size_t size, const bench_sat_t* pSats, uint8_t numSats, uint32_t timeOfDaySec)
+{
+  char body[96];
+  size_t len = 0;
+  unsigned int hour = (timeOfDaySec / 3600) % 24;
+  unsigned int minute = (timeOfDaySec / 60) % 60;
+  unsigned int second = timeOfDaySec % 60;
+
+  snprintf(body, sizeof(body), "GPRMC,%02u%02u%02u.00,A,5231.012,N,01324.567,E,0.021,,170326,,,A", hour, minute, second);
+  len = appendNmeaSentence(pBuf, size, len, body);
+  snprintf(body, sizeof(body), "GPGGA,%02u%02u%02u.00,5231.012,N,01324.567,E,1,%02d,0.98,41.3,M,44.1,M,,", hour, minute,
+           second, numSats);
+  len = appendNmeaSentence(pBuf, size, len, body);
+
+  for(uint8_t msg=1; msg<=(numSats + 3) / 4; msg++)
+  {
+    len += benchMakeGsvSentence(pBuf + len, size - len, pSats, numSats, msg);
+  }
+  return len;
+}
+
+size_t benchMakeUbxFrame(uint8_t* pBuf, size_t size, uint8_t msgClass, uint8_t msgId, uint16_t payloadLen, uint32_t* pState)
+{
+  size_t frameLen = 2 + GpsSoftwareSerial::UBX_FRAME_HEADER_LEN + payloadLen + 2;
+  if(frameLen > size)
+  {
+    return 0;
+  }
+  for(uint16_t i=0; i<payloadLen; i++)
+  {
+    pBuf[6 + i] = benchRandom(pState) & 0xFF;
+  }
+  return finishUbxFrame(pBuf, msgClass, msgId, payloadLen);
+}
+
+size_t benchMakeSvInfoFrame(uint8_t* pBuf, size_t size, const bench_sat_t* pSats, uint8_t numSats, uint32_t iTow)
+{
+  uint16_t payloadLen = 8 + numSats * 12;
+  if((size_t)(2 + GpsSoftwareSerial::UBX_FRAME_HEADER_LEN + payloadLen + 2) > size)
+  {
+    return 0;
+  }
+  uint8_t* pPayload = &pBuf[6];
+  memset(pPayload, 0, payloadLen);
+  for(uint8_t i=0; i<4; i++)
+  {
+    pPayload[i] = (iTow >> (8 * i)) & 0xFF;
+  }
+  pPayload[4] = numSats; // one channel per satellite
+  for(uint8_t i=0; i<numSats; i++)
+  {
+    uint8_t* pBlock = &pPayload[8 + i * 12];
+    pBlock[0] = i; // channel
+    pBlock[1] = pSats[i].no; // GPS: UBX numbering = PRN
+    pBlock[2] = (pSats[i].snr > 0) ? 0x01 : 0x00; // used for navigation
+    pBlock[3] = (pSats[i].snr > 0) ? 0x07 : 0x01; // quality: code and carrier locked, or searching
+    pBlock[4] = pSats[i].snr;
+    pBlock[5] = pSats[i].elevation;
+    pBlock[6] = pSats[i].azimuth & 0xFF;
+    pBlock[7] = pSats[i].azimuth >> 8;
+  }
+  return finishUbxFrame(pBuf, GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_SVINFO, payloadLen);
+}
@@ -0,0 +1,61 @@
+#ifndef Benchmark_h
+#define Benchmark_h
+
+#include <Arduino.h>
+
+// Micro-benchmark helpers: a sampler that collects the duration of repeated calls and prints percentiles, and
+// generators for synthetic (but well-formed) NMEA/UBX traffic. On the device, durations are CPU cycles; on the host
+// build they are nanoseconds.
+
+static const uint16_t BENCH_MAX_SAMPLES = 256;
+
+typedef struct
+{
+  uint8_t no; // PRN
+  uint8_t elevation;
+  uint16_t azimuth;
+  uint8_t snr;
+} bench_sat_t;
+
+class BenchSampler {
+  public:
+    BenchSampler(const char* name);
+
+    static uint32_t now();
+    static uint32_t ticksPerUs();
+    static const char* tickUnit();
+
+    void start() { mStart = now(); }
+    void stop();
+    uint16_t getNumSamples() { return mNumSamples; }
+    uint32_t getPercentile(uint8_t percent); // in ticks per sample (sorts the samples)
+
+    // prints min/p50/p90/p99/max per sample and, normalized by `unitsPerSample`, the median in ns per unit
+    void print(Print& out, const char* unitName, uint32_t unitsPerSample);
+  private:
+    const char* mName;
+    uint32_t mStart;
+    uint32_t mSamples[BENCH_MAX_SAMPLES];
+    uint16_t mNumSamples;
+    bool mSorted;
+};
+
+// pseudo-random numbers for the synthetic data (reproducible, no dependency on the platform's random())
+uint32_t benchRandom(uint32_t* pState);
+
+// fills `pSats` with `numSats` satellites at random positions and signal strengths, returns `numSats`
+uint8_t benchMakeSats(bench_sat_t* pSats, uint8_t numSats, uint32_t* pState);
+
+// writes one NMEA epoch ($GPRMC, $GPGGA and the $GPGSV cycle for `pSats`) to `pBuf`, returns its length
+size_t benchMakeNmeaEpoch(char* pBuf, size_t size, const bench_sat_t* pSats, uint8_t numSats, uint32_t timeOfDaySec);
+
+// writes a single $GPGSV sentence (message `msgNumber` of the cycle for `pSats`) to `pBuf`, returns its length
+size_t benchMakeGsvSentence(char* pBuf, size_t size, const bench_sat_t* pSats, uint8_t numSats, uint8_t msgNumber);
+
+// writes a complete UBX frame with random payload to `pBuf`, returns its length (0 when it does not fit)
+size_t benchMakeUbxFrame(uint8_t* pBuf, size_t size, uint8_t msgClass, uint8_t msgId, uint16_t payloadLen, uint32_t* pState);
+
+// writes a UBX NAV-SVINFO frame (one channel per satellite of `pSats`) to `pBuf`, returns its length (0 when it does not fit)
+size_t benchMakeSvInfoFrame(uint8_t* pBuf, size_t size, const bench_sat_t* pSats, uint8_t numSats, uint32_t iTow);
+
+#endif
@@ -0,0 +1,71 @@
+#include "Button.h"
+
+Button::Button(uint8_t pin, uint32_t debounceUs, uint8_t pressedLevel) :
+    mPin(pin),
+    mDebounceUs(debounceUs),
+    mPressedLevel(pressedLevel),
+    mStableLevel(!pressedLevel),
+    mLastEdgeUs(0)
+#if !defined(ARDUINO_HOST_BUILD)
+    ,
+    mMux(portMUX_INITIALIZER_UNLOCKED)
+#endif
+{
+}
+
+void Button::begin()
+{
+  pinMode(mPin, INPUT); // the OBS display module has a hardware pull-down resistor
+  mStableLevel = digitalRead(mPin);
+  mLastEdgeUs = micros();
+  attachInterruptArg(digitalPinToInterrupt(mPin), isr, this, CHANGE);
+}
+
+void IRAM_ATTR Button::isr(void* pArg)
+{
+  Button* pThis = (Button*)pArg;
+  pThis->onEdge(true);
+}
+
+void IRAM_ATTR Button::onEdge(bool fromIsr)
+{
+#if !defined(ARDUINO_HOST_BUILD)
+  if(fromIsr)
+  {
+    portENTER_CRITICAL_ISR(&mMux);
+  }
+  else
+  {
+    portENTER_CRITICAL(&mMux);
+  }
+#endif
+  // a change of the debounced level, unless it is a bounce of the edge before (time and level are taken within the
+  // critical section, so that the last edge cannot be newer than `nowUs`)
+  uint32_t nowUs = micros();
+  uint8_t level = digitalRead(mPin);
+  if(level != mStableLevel && (uint32_t)(nowUs - mLastEdgeUs) >= mDebounceUs)
+  {
+    mStableLevel = level;
+    mLastEdgeUs = nowUs;
+    button_event_t event = { nowUs, level == mPressedLevel };
+    mEvents.push(event);
+  }
+#if !defined(ARDUINO_HOST_BUILD)
+  if(fromIsr)
+  {
+    portEXIT_CRITICAL_ISR(&mMux);
+  }
+  else
+  {
+    portEXIT_CRITICAL(&mMux);
+  }
+#endif
+}
+
+bool Button::getEvent(button_event_t* pEvent)
+{
+  // catch up with an edge that came within the debounce time of the one before (there will be no further interrupt
+  // when the pin has settled meanwhile)
+  onEdge(false);
+  return mEvents.pop(*pEvent);
+}
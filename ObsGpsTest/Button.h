@@ -0,0 +1,44 @@
+#ifndef Button_h
+#define Button_h
+
+#include <Arduino.h>
+#include "SpscRing.h"
+
+// Interrupt-driven push button: the pin's edges are taken in the GPIO interrupt and debounced right there (the first
+// edge wins, further edges within the debounce time are bounces), each debounced edge is queued with its timestamp
+// for loop() -- nothing needs to poll the pin, and the timestamp is the moment the button actually moved.
+// An edge that is swallowed within the debounce time (e.g. a very short tap) is caught up by getEvent() from the pin
+// level once the debounce time is over; such an event carries the time it was detected instead.
+
+class Button {
+  public:
+    typedef struct
+    {
+      uint32_t timeUs; // micros() of the edge
+      bool pressed; // pressed or released
+    } button_event_t;
+
+    Button(uint8_t pin, uint32_t debounceUs, uint8_t pressedLevel = HIGH);
+
+    void begin(); // configures the pin and attaches the interrupt; the current state does not generate an event
+    bool getEvent(button_event_t* pEvent); // next debounced edge (oldest first), false when there is none
+    bool isPressed() { return mStableLevel == mPressedLevel; } // debounced
+    unsigned int getDropCount() { return mEvents.getDropCount(); } // events lost as loop() did not pick them up
+  private:
+    static const size_t EVENT_QUEUE_SIZE = 8;
+
+    static void isr(void* pArg);
+    void onEdge(bool fromIsr);
+
+    uint8_t mPin;
+    uint32_t mDebounceUs;
+    uint8_t mPressedLevel;
+    volatile uint8_t mStableLevel; // pin level after debouncing
+    volatile uint32_t mLastEdgeUs; // time of the last debounced edge
+    SpscRing<button_event_t, EVENT_QUEUE_SIZE> mEvents; // pushed from the interrupt (or getEvent()), popped by getEvent()
+#if !defined(ARDUINO_HOST_BUILD)
+    portMUX_TYPE mMux; // the interrupt and the catch-up in getEvent() take turns as producer
+#endif
+};
+
+#endif
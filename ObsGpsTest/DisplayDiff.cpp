@@ -0,0 +1,209 @@
+#include "DisplayDiff.h"
+
+namespace
+{
+  const uint8_t TILE_BYTES = 8; // 8 columns of one page
+  const uint32_t TRANSFER_TASK_STACK_SIZE = 2048;
+}
+
+DisplayDiff::DisplayDiff(U8G2& display) :
+    mDisplay(display),
+    mShadowValid(false),
+    mFrameSize(0),
+    mNumRuns(0),
+    mFrameCount(0),
+    mBytesSent(0),
+    mLastFrameBytes(0),
+    mLastTransferUs(0),
+    mMaxTransferUs(0)
+#if !defined(ARDUINO_HOST_BUILD)
+    ,
+    mTransferTask(nullptr),
+    mIdle(nullptr)
+#endif
+{
+}
+
+bool DisplayDiff::beginAsync(uint8_t priority, int8_t core)
+{
+#if !defined(ARDUINO_HOST_BUILD)
+  if(mTransferTask != nullptr)
+  {
+    return true;
+  }
+  mIdle = xSemaphoreCreateBinary();
+  if(mIdle == nullptr)
+  {
+    return false;
+  }
+  xSemaphoreGive(mIdle);
+  if(xTaskCreatePinnedToCore(transferTask, "display", TRANSFER_TASK_STACK_SIZE, this, priority, &mTransferTask, core) != pdPASS)
+  {
+    vSemaphoreDelete(mIdle);
+    mIdle = nullptr;
+    mTransferTask = nullptr;
+    return false;
+  }
+  return true;
+#else
+  return false; // the host build has no display bus to wait for
+#endif
+}
+
+bool DisplayDiff::isBusy()
+{
+#if !defined(ARDUINO_HOST_BUILD)
+  return (mTransferTask != nullptr) && (uxSemaphoreGetCount(mIdle) == 0);
+#else
+  return false;
+#endif
+}
+
+void DisplayDiff::waitIdle()
+{
+#if !defined(ARDUINO_HOST_BUILD)
+  if(mTransferTask != nullptr)
+  {
+    xSemaphoreTake(mIdle, portMAX_DELAY);
+    xSemaphoreGive(mIdle);
+  }
+#endif
+}
+
+size_t DisplayDiff::sendBuffer()
+{
+  const uint8_t* pBuffer = mDisplay.getBufferPtr();
+  uint8_t tileWidth = mDisplay.getBufferTileWidth();
+  uint8_t tileHeight = mDisplay.getBufferTileHeight();
+  mFrameSize = (size_t)tileWidth * tileHeight * TILE_BYTES;
+  size_t bytes = 0;
+
+  if(mFrameSize > sizeof(mShadow))
+  {
+    // a display too large for the shadow buffer: send everything, the usual way
+    waitIdle();
+    uint32_t start = micros();
+    mDisplay.sendBuffer();
+    mLastTransferUs = micros() - start;
+    bytes = mFrameSize;
+  }
+  else
+  {
+#if !defined(ARDUINO_HOST_BUILD)
+    if(mTransferTask != nullptr)
+    {
+      // the shadow buffer and the runs belong to the transfer task until it is done with the previous frame
+      xSemaphoreTake(mIdle, portMAX_DELAY);
+    }
+#endif
+    // buffer layout: one page (8 pixel rows) after another, a tile column being 8 consecutive bytes of a page
+    mNumRuns = 0;
+    for(uint8_t ty=0; ty<tileHeight; ty++)
+    {
+      size_t pageOffs = (size_t)ty * tileWidth * TILE_BYTES;
+      if(!mShadowValid)
+      {
+        // nothing to compare with: the complete page
+        memcpy(&mShadow[pageOffs], &pBuffer[pageOffs], (size_t)tileWidth * TILE_BYTES);
+        addRun(0, ty, tileWidth);
+        continue;
+      }
+      uint8_t tx = 0;
+      while(tx < tileWidth)
+      {
+        // skip unchanged tiles, then take the run of changed ones at once
+        while(tx < tileWidth && memcmp(&mShadow[pageOffs + tx * TILE_BYTES], &pBuffer[pageOffs + tx * TILE_BYTES], TILE_BYTES) == 0)
+        {
+          tx++;
+        }
+        uint8_t runStart = tx;
+        while(tx < tileWidth && memcmp(&mShadow[pageOffs + tx * TILE_BYTES], &pBuffer[pageOffs + tx * TILE_BYTES], TILE_BYTES) != 0)
+        {
+          memcpy(&mShadow[pageOffs + tx * TILE_BYTES], &pBuffer[pageOffs + tx * TILE_BYTES], TILE_BYTES);
+          tx++;
+        }
+        if(tx > runStart)
+        {
+          addRun(runStart, ty, tx - runStart);
+        }
+      }
+    }
+    mShadowValid = true;
+    for(uint8_t i=0; i<mNumRuns; i++)
+    {
+      bytes += (size_t)mRuns[i].tw * TILE_BYTES;
+    }
+
+#if !defined(ARDUINO_HOST_BUILD)
+    if(mTransferTask != nullptr)
+    {
+      xTaskNotifyGive(mTransferTask); // gives mIdle back when done
+    }
+    else
+#endif
+    {
+      transferRuns();
+    }
+  }
+
+  ++mFrameCount;
+  mBytesSent += bytes;
+  mLastFrameBytes = bytes;
+  return bytes;
+}
+
+void DisplayDiff::addRun(uint8_t tx, uint8_t ty, uint8_t tw)
+{
+  if(mNumRuns < MAX_RUNS)
+  {
+    mRuns[mNumRuns++] = { tx, ty, tw };
+  }
+  else
+  {
+    // cannot happen with alternating runs; merge with the last run to be on the safe side
+    tile_run_t& last = mRuns[mNumRuns - 1];
+    if(last.ty == ty)
+    {
+      last.tw = tx + tw - last.tx;
+    }
+  }
+}
+
+void DisplayDiff::transferRuns()
+{
+  uint32_t start = micros();
+#if !defined(ARDUINO_HOST_BUILD)
+  // from the shadow buffer: the frame buffer may already be drawn anew in the meantime
+  uint8_t tileWidth = mDisplay.getBufferTileWidth();
+  for(uint8_t i=0; i<mNumRuns; i++)
+  {
+    size_t offs = ((size_t)mRuns[i].ty * tileWidth + mRuns[i].tx) * TILE_BYTES;
+    u8x8_DrawTile(mDisplay.getU8x8(), mRuns[i].tx, mRuns[i].ty, mRuns[i].tw, &mShadow[offs]);
+  }
+#else
+  for(uint8_t i=0; i<mNumRuns; i++)
+  {
+    mDisplay.updateDisplayArea(mRuns[i].tx, mRuns[i].ty, mRuns[i].tw, 1);
+  }
+#endif
+  mLastTransferUs = micros() - start;
+  if(mLastTransferUs > mMaxTransferUs)
+  {
+    mMaxTransferUs = mLastTransferUs;
+  }
+}
+
+void DisplayDiff::transferTask(void* pParameters)
+{
+  DisplayDiff* pThis = (DisplayDiff*)pParameters;
+#if !defined(ARDUINO_HOST_BUILD)
+  while(true)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    pThis->transferRuns();
+    xSemaphoreGive(pThis->mIdle);
+  }
+#else
+  (void)pThis;
+#endif
+}
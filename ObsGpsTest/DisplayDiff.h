@@ -0,0 +1,66 @@
+#ifndef DisplayDiff_h
+#define DisplayDiff_h
+
+#include <Arduino.h>
+#include <U8g2lib.h>
+
+// Partial display updates for U8g2 full frame buffers: instead of sending the whole buffer, the frame is compared
+// with the one sent before, tile by tile (8x8 pixels, i.e. 8 bytes of one page), and only runs of changed tiles are
+// transferred. Frames are drawn as usual (clearBuffer(), draw..., then sendBuffer() of this class instead of U8G2's).
+// Keeps count of the bytes sent per frame and of the transfer time.
+//
+// After beginAsync() (ESP32 only), the transfer runs in a task of its own: sendBuffer() takes over the changed tiles
+// into the shadow buffer, hands them to the task and returns right away, so the next frame can be drawn while the
+// bus is busy. Only the transfer task talks to the display from then on (call waitIdle() before anything else that
+// does, e.g. setFlipMode()).
+
+class DisplayDiff {
+  public:
+    static const size_t MAX_BUFFER_SIZE = 128 * 64 / 8;
+
+    DisplayDiff(U8G2& display);
+
+    bool beginAsync(uint8_t priority, int8_t core); // false when not supported (the transfer stays synchronous)
+    size_t sendBuffer(); // sends (or hands over) the changed tiles of the frame buffer, returns the number of bytes
+    void invalidate() { mShadowValid = false; } // the next frame is sent completely (e.g. after the display was reset)
+    bool isBusy(); // a frame transfer is in progress
+    void waitIdle(); // blocks until the frame transfer (if any) has completed
+
+    unsigned int getFrameCount() { return mFrameCount; }
+    unsigned long getBytesSent() { return mBytesSent; }
+    size_t getLastFrameBytes() { return mLastFrameBytes; }
+    size_t getFrameSize() { return mFrameSize; } // bytes of a full frame
+    uint32_t getLastTransferMicros() { return mLastTransferUs; }
+    uint32_t getMaxTransferMicros() { return mMaxTransferUs; }
+  private:
+    typedef struct
+    {
+      uint8_t tx; // first tile column
+      uint8_t ty; // page
+      uint8_t tw; // number of tiles
+    } tile_run_t;
+
+    static const uint8_t MAX_RUNS = MAX_BUFFER_SIZE / 8 / 2; // changed and unchanged tiles alternating
+
+    void addRun(uint8_t tx, uint8_t ty, uint8_t tw);
+    void transferRuns();
+    static void transferTask(void* pParameters);
+
+    U8G2& mDisplay;
+    uint8_t mShadow[MAX_BUFFER_SIZE]; // the frame buffer as sent last (and what the transfer task sends from)
+    bool mShadowValid;
+    size_t mFrameSize;
+    tile_run_t mRuns[MAX_RUNS]; // tiles to transfer for the current frame
+    uint8_t mNumRuns;
+    unsigned int mFrameCount;
+    unsigned long mBytesSent;
+    size_t mLastFrameBytes;
+    volatile uint32_t mLastTransferUs;
+    volatile uint32_t mMaxTransferUs;
+#if !defined(ARDUINO_HOST_BUILD)
+    TaskHandle_t mTransferTask;
+    SemaphoreHandle_t mIdle; // available while no transfer is in progress
+#endif
+};
+
+#endif
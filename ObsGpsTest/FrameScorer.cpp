@@ -0,0 +1,172 @@
+#include "FrameScorer.h"
+
+FrameScorer::FrameScorer()
+{
+  reset();
+}
+
+void FrameScorer::reset()
+{
+  mState = SCAN;
+  mNmeaCk = 0;
+  mNmeaLen = 0;
+  mNmeaCkRx = 0;
+  mUbxHeaderIdx = 0;
+  mUbxLen = 0;
+  mUbxIdx = 0;
+  mUbxCkA = 0;
+  mUbxCkB = 0;
+  mUbxCkARx = 0;
+  mValidNmea = 0;
+  mValidUbx = 0;
+  mErrors = 0;
+  mByteCount = 0;
+}
+
+int8_t FrameScorer::hexValue(uint8_t c)
+{
+  if(c >= '0' && c <= '9')
+  {
+    return c - '0';
+  }
+  if(c >= 'A' && c <= 'F')
+  {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+void FrameScorer::fail()
+{
+  ++mErrors;
+  mState = SCAN;
+}
+
+void FrameScorer::scan(uint8_t c)
+{
+  if(c == '$')
+  {
+    mNmeaCk = 0;
+    mNmeaLen = 1;
+    mState = NMEA_BODY;
+  }
+  else if(c == 0xB5)
+  {
+    mState = UBX_SYNC2;
+  }
+}
+
+void FrameScorer::feed(const uint8_t* pBuf, size_t len)
+{
+  mByteCount += len;
+  for(size_t i=0; i<len; i++)
+  {
+    uint8_t c = pBuf[i];
+    switch(mState)
+    {
+      case SCAN:
+        scan(c);
+        break;
+      case NMEA_BODY:
+        if(c == '*')
+        {
+          mState = NMEA_CK_HI;
+        }
+        else if(c < 0x20 || c > 0x7E || ++mNmeaLen > NMEA_MAX_LEN - 3)
+        {
+          fail();
+          scan(c); // may already be the start of the next frame
+        }
+        else
+        {
+          mNmeaCk ^= c;
+        }
+        break;
+      case NMEA_CK_HI:
+        if(hexValue(c) < 0)
+        {
+          fail();
+          scan(c);
+        }
+        else
+        {
+          mNmeaCkRx = hexValue(c) << 4;
+          mState = NMEA_CK_LO;
+        }
+        break;
+      case NMEA_CK_LO:
+        if(hexValue(c) >= 0 && (mNmeaCkRx | hexValue(c)) == mNmeaCk)
+        {
+          ++mValidNmea;
+          mState = SCAN;
+        }
+        else
+        {
+          fail();
+          scan(c);
+        }
+        break;
+      case UBX_SYNC2:
+        if(c == 0x62)
+        {
+          mUbxHeaderIdx = 0;
+          mUbxCkA = 0;
+          mUbxCkB = 0;
+          mState = UBX_HEADER;
+        }
+        else
+        {
+          mState = SCAN; // a lone 0xB5 is no frame yet
+          scan(c);
+        }
+        break;
+      case UBX_HEADER:
+        mUbxCkA += c;
+        mUbxCkB += mUbxCkA;
+        if(mUbxHeaderIdx == 2)
+        {
+          mUbxLen = c;
+        }
+        else if(mUbxHeaderIdx == 3)
+        {
+          mUbxLen |= (uint16_t)c << 8;
+        }
+        if(++mUbxHeaderIdx == 4)
+        {
+          if(mUbxLen > UBX_MAX_PAYLOAD_LEN)
+          {
+            fail();
+          }
+          else
+          {
+            mUbxIdx = 0;
+            mState = (mUbxLen == 0) ? UBX_CK_A : UBX_PAYLOAD;
+          }
+        }
+        break;
+      case UBX_PAYLOAD:
+        mUbxCkA += c;
+        mUbxCkB += mUbxCkA;
+        if(++mUbxIdx == mUbxLen)
+        {
+          mState = UBX_CK_A;
+        }
+        break;
+      case UBX_CK_A:
+        mUbxCkARx = c;
+        mState = UBX_CK_B;
+        break;
+      case UBX_CK_B:
+        if(mUbxCkARx == mUbxCkA && c == mUbxCkB)
+        {
+          ++mValidUbx;
+          mState = SCAN;
+        }
+        else
+        {
+          fail();
+        }
+        break;
+    }
+  }
+}
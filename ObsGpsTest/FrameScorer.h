@@ -0,0 +1,60 @@
+#ifndef FrameScorer_h
+#define FrameScorer_h
+
+#include <Arduino.h>
+
+// Framing check of a raw byte stream, e.g. to tell whether the UART runs at the GPS module's baudrate: counts NMEA
+// sentences ('$' to "*hh", printable characters only) and UBX frames (sync chars to CK_B) with a valid checksum, and
+// the ones that broke off or failed their checksum. At a wrong baudrate the bytes are garbage, valid checksums are
+// then next to impossible, so the number of valid frames is a reliable score.
+
+class FrameScorer {
+  public:
+    static const uint8_t NMEA_MAX_LEN = 82; // '$' to the end of the checksum (NMEA 0183)
+    static const uint16_t UBX_MAX_PAYLOAD_LEN = 1024;
+
+    FrameScorer();
+
+    void reset();
+    void feed(const uint8_t* pBuf, size_t len);
+
+    unsigned int getValidCount() { return mValidNmea + mValidUbx; }
+    unsigned int getValidNmeaCount() { return mValidNmea; }
+    unsigned int getValidUbxCount() { return mValidUbx; }
+    unsigned int getErrorCount() { return mErrors; } // checksum errors and broken-off frames
+    unsigned int getByteCount() { return mByteCount; }
+    int getScore() { return (int)getValidCount() * 4 - (int)mErrors; } // valid frames, minus the noise
+  private:
+    enum ScorerState : uint8_t {
+      SCAN, // looking for '$' or 0xB5
+      NMEA_BODY, // after '$', XOR-ing up to '*'
+      NMEA_CK_HI,
+      NMEA_CK_LO,
+      UBX_SYNC2,
+      UBX_HEADER, // class, ID, length
+      UBX_PAYLOAD,
+      UBX_CK_A,
+      UBX_CK_B
+    };
+
+    void scan(uint8_t c);
+    void fail();
+    static int8_t hexValue(uint8_t c);
+
+    ScorerState mState;
+    uint8_t mNmeaCk; // XOR of the characters between '$' and '*'
+    uint8_t mNmeaLen;
+    uint8_t mNmeaCkRx;
+    uint8_t mUbxHeaderIdx;
+    uint16_t mUbxLen;
+    uint16_t mUbxIdx;
+    uint8_t mUbxCkA;
+    uint8_t mUbxCkB;
+    uint8_t mUbxCkARx;
+    unsigned int mValidNmea;
+    unsigned int mValidUbx;
+    unsigned int mErrors;
+    unsigned int mByteCount;
+};
+
+#endif
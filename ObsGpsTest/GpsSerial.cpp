@@ -1,197 +1,456 @@
 #include "GpsSerial.h"
 
-#define DEBUG_PRINTLN(msg)  Serial.println(msg);
-#define DEBUG_PRINT(msg)  Serial.print(msg);
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
-GpsSoftwareSerial::GpsSoftwareSerial(uint8_t receivePin, uint8_t transmitPin) :
+constexpr GpsSoftwareSerial::UbxMessageInfo GpsSoftwareSerial::UBX_MESSAGES[];
+const uint32_t GpsSoftwareSerial::AUTOBAUD_RATES[AUTOBAUD_NUM_RATES] = {
+  9600, 115200, 38400, 4800, 19200, 57600, 230400, 460800, 921600
+};
+
+namespace
+{
+  // direct (class, ID) -> UbxMessage lookup, generated from the message registry at compile time (so that it stays in
+  // flash); RX classification is then two indexed loads instead of a chain of branches
+  const uint8_t NO_SLOT = 0xFF;
+  constexpr uint8_t VALID_CLASSES[] = {
+    GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_CLASS_RXM, GpsSoftwareSerial::UBX_MSG_CLASS_INF,
+    GpsSoftwareSerial::UBX_MSG_CLASS_ACK, GpsSoftwareSerial::UBX_MSG_CLASS_CFG, GpsSoftwareSerial::UBX_MSG_CLASS_MON,
+    GpsSoftwareSerial::UBX_MSG_CLASS_AID, GpsSoftwareSerial::UBX_MSG_CLASS_TIM, GpsSoftwareSerial::UBX_MSG_CLASS_ESF
+  };
+  const uint8_t NUM_CLASS_SLOTS = sizeof(VALID_CLASSES);
+
+  constexpr uint8_t findClassSlot(uint8_t msgClass, uint8_t slot)
+  {
+    return (slot == NUM_CLASS_SLOTS) ? NO_SLOT :
+           (VALID_CLASSES[slot] == msgClass) ? slot : findClassSlot(msgClass, slot + 1);
+  }
+
+  constexpr uint8_t findUbxMessage(uint8_t msgClass, uint8_t msgId, uint8_t i)
+  {
+    return (i == GpsSoftwareSerial::UBX_MSG_NUM) ? (uint8_t)GpsSoftwareSerial::UBX_MSG_NUM :
+           (GpsSoftwareSerial::UBX_MESSAGES[i].msgClass == msgClass && GpsSoftwareSerial::UBX_MESSAGES[i].msgId == msgId) ?
+           i : findUbxMessage(msgClass, msgId, i + 1);
+  }
+
+#define UBX_LOOKUP_4(entry, row, col) entry(row, col), entry(row, (col) + 1), entry(row, (col) + 2), entry(row, (col) + 3)
+#define UBX_LOOKUP_16(entry, row, col) UBX_LOOKUP_4(entry, row, col), UBX_LOOKUP_4(entry, row, (col) + 4), \
+                                       UBX_LOOKUP_4(entry, row, (col) + 8), UBX_LOOKUP_4(entry, row, (col) + 12)
+#define UBX_LOOKUP_64(entry, row, col) UBX_LOOKUP_16(entry, row, col), UBX_LOOKUP_16(entry, row, (col) + 16), \
+                                       UBX_LOOKUP_16(entry, row, (col) + 32), UBX_LOOKUP_16(entry, row, (col) + 48)
+#define UBX_LOOKUP_256(entry, row, col) UBX_LOOKUP_64(entry, row, col), UBX_LOOKUP_64(entry, row, (col) + 64), \
+                                        UBX_LOOKUP_64(entry, row, (col) + 128), UBX_LOOKUP_64(entry, row, (col) + 192)
+#define UBX_CLASS_SLOT_ENTRY(row, msgClass) findClassSlot(msgClass, 0)
+#define UBX_MSG_ENTRY(slot, msgId) findUbxMessage(VALID_CLASSES[slot], msgId, 0)
+#define UBX_MSG_ROW(slot) { UBX_LOOKUP_256(UBX_MSG_ENTRY, slot, 0) }
+
+  // message class -> row in UBX_MSG_LOOKUP (NO_SLOT for classes that are not valid)
+  constexpr uint8_t UBX_CLASS_SLOT[256] = { UBX_LOOKUP_256(UBX_CLASS_SLOT_ENTRY, 0, 0) };
+
+  // message ID -> UbxMessage (UBX_MSG_NUM for unknown messages), one row per valid class
+  static_assert(NUM_CLASS_SLOTS == 9, "one UBX_MSG_LOOKUP row per valid class");
+  constexpr uint8_t UBX_MSG_LOOKUP[NUM_CLASS_SLOTS][256] = {
+    UBX_MSG_ROW(0), UBX_MSG_ROW(1), UBX_MSG_ROW(2), UBX_MSG_ROW(3), UBX_MSG_ROW(4),
+    UBX_MSG_ROW(5), UBX_MSG_ROW(6), UBX_MSG_ROW(7), UBX_MSG_ROW(8)
+  };
+
+#undef UBX_MSG_ROW
+#undef UBX_MSG_ENTRY
+#undef UBX_CLASS_SLOT_ENTRY
+#undef UBX_LOOKUP_256
+#undef UBX_LOOKUP_64
+#undef UBX_LOOKUP_16
+#undef UBX_LOOKUP_4
+
+  // each registry message is found under its class and ID: its class is a valid one, and no other message has the same
+  // class and ID
+  constexpr bool isUbxLookupComplete(uint8_t i)
+  {
+    return (i == GpsSoftwareSerial::UBX_MSG_NUM) ||
+           (UBX_CLASS_SLOT[GpsSoftwareSerial::UBX_MESSAGES[i].msgClass] != NO_SLOT &&
+            UBX_MSG_LOOKUP[UBX_CLASS_SLOT[GpsSoftwareSerial::UBX_MESSAGES[i].msgClass]][GpsSoftwareSerial::UBX_MESSAGES[i].msgId] == i &&
+            isUbxLookupComplete(i + 1));
+  }
+
+  static_assert(isUbxLookupComplete(0), "UBX message registry: unknown class (add it to VALID_CLASSES) or duplicate message");
+
+  // payloads of the poll requests that need one (lengths as in the message registry)
+  const uint8_t CFG_MSG_POLL_PAYLOAD[2] = { 0xF0, 0x03 }; // the output rate of NMEA GSV (class, ID)
+  const uint8_t CFG_INF_POLL_PAYLOAD[1] = { 0x01 }; // the information messages of the NMEA protocol (protocol ID)
+
+  const char* const NMEA_SENTENCE_NAMES[GpsSoftwareSerial::NMEA_NUM] = {
+#define NMEA_SENTENCE_NAME_ENTRY(type) #type,
+    NMEA_SENTENCE_REGISTRY(NMEA_SENTENCE_NAME_ENTRY)
+#undef NMEA_SENTENCE_NAME_ENTRY
+    "other"
+  };
+
+  int8_t hexValue(int c)
+  {
+    if(c >= '0' && c <= '9')
+    {
+      return c - '0';
+    }
+    if(c >= 'A' && c <= 'F')
+    {
+      return c - 'A' + 10;
+    }
+    return -1;
+  }
+
+  bool isNmeaAddressChar(int c)
+  {
+    return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+  }
+}
+
+GpsSoftwareSerial::GpsSoftwareSerial(HardwareSerial& port, uint8_t receivePin, uint8_t transmitPin) :
+    mPort(port),
     mSeenUbx(false),
     mSeenNmea(false),
     mRxState(IDLE),
     mRxCount(0),
+    mRxOverflowCount(0),
+    mRxOverflowsSeen(0),
+    mRxHighWater(0),
     mLastMsgClass(UBX_MSG_CLASS_INVALID),
-    mUbxMsgStatus{0},
+    mUbxPayloadLen(0),
+    mUbxFrameIdx(0),
+    mUbxCkA(0),
+    mNmeaAddressLen(0),
+    mNmeaLen(0),
+    mNmeaChecksum(0),
+    mNmeaChecksumRx(0),
+    mNumUbxHandlers(0),
+    mRxPin(receivePin),
     mTxPin(transmitPin),
-    mRxPin(receivePin)
+    mBaudRate(0),
+    mAutobaudState(AUTOBAUD_OFF),
+    mAutobaudNumRates(0),
+    mAutobaudStep(0),
+    mAutobaudNumTried(0),
+    mAutobaudDwellMs(0),
+    mAutobaudStartMs(0),
+    mAutobaudStepMs(0),
+    mAutobaudMs(0),
+    mUpshiftSpeed(0),
+    mUpshiftResult(UPSHIFT_NONE),
+    mUpshiftThroughput(0),
+    mCfgPrtRxed(false)
+{
+  for(uint8_t i=0; i<UBX_MSG_NUM; i++)
+  {
+    mUbxMsgStatus[i].store(0);
+  }
+}
+
+GpsSoftwareSerial::GpsSoftwareSerial(uint8_t uartNum, uint8_t receivePin, uint8_t transmitPin) :
+    GpsSoftwareSerial(getUart(uartNum), receivePin, transmitPin)
 {
-  memset(mRxStartupMem, 0, RX_STARTUP_MEM_LEN);
 }
 
-GpsSoftwareSerial::~GpsSoftwareSerial()
+HardwareSerial& GpsSoftwareSerial::getUart(uint8_t uartNum)
 {
-  ~SoftwareSerial();
+  switch(uartNum)
+  {
+    case 0:
+#if ARDUINO_USB_CDC_ON_BOOT
+      return Serial0; // `Serial` is the USB CDC port then
+#else
+      return Serial; // shared w/ the debug serial
+#endif
+    case 1:
+      return Serial1;
+    default:
+      return Serial2;
+  }
 }
 
 void GpsSoftwareSerial::begin(long speed)
 {
-  Serial2.begin(speed, SERIAL_8N1, mRxPin, mTxPin);
+  mBaudRate = speed;
+  mPort.setRxBufferSize(RX_BUFFER_SIZE); // needs to be set before begin()
+  mPort.begin(speed, SERIAL_8N1, mRxPin, mTxPin);
+#if defined(ESP_ARDUINO_VERSION_VAL)
+#if ESP_ARDUINO_VERSION >= ESP_ARDUINO_VERSION_VAL(2, 0, 4)
+  // count bytes dropped by the hardware FIFO or the driver's RX buffer (i.e. when we did not read fast enough)
+  mPort.onReceiveError([this](hardwareSerial_error_t error) {
+    if(error == UART_FIFO_OVF_ERROR || error == UART_BUFFER_FULL_ERROR)
+    {
+      mRxOverflowCount.fetch_add(1);
+    }
+  });
+#endif
+#endif
 }
 
-bool GpsSoftwareSerial::isValidMessageClass(uint8_t c)
+void GpsSoftwareSerial::beginAutobaud(long firstSpeed, uint32_t dwellMs, long upshiftSpeed)
 {
-  return (c == UBX_MSG_CLASS_NAV || c == UBX_MSG_CLASS_RXM || c == UBX_MSG_CLASS_INF || c == UBX_MSG_CLASS_ACK || 
-          c == UBX_MSG_CLASS_CFG || c == UBX_MSG_CLASS_MON || c == UBX_MSG_CLASS_AID || c == UBX_MSG_CLASS_TIM || c == UBX_MSG_CLASS_ESF);
+  mAutobaudOrder[0] = firstSpeed;
+  mAutobaudNumRates = 1;
+  for(uint8_t i=0; i<AUTOBAUD_NUM_RATES; i++)
+  {
+    if(AUTOBAUD_RATES[i] != (uint32_t)firstSpeed)
+    {
+      mAutobaudOrder[mAutobaudNumRates++] = AUTOBAUD_RATES[i];
+    }
+  }
+  mAutobaudDwellMs = dwellMs;
+  mUpshiftSpeed = upshiftSpeed;
+  mUpshiftResult = UPSHIFT_NONE;
+  mAutobaudStep = 0;
+  mAutobaudStartMs = millis();
+  mAutobaudState = AUTOBAUD_SEARCHING;
+  addUbxHandler(UBX_MSG_CLASS_CFG, UBX_MSG_ID_CFG_PRT, onCfgPrt, this);
+
+  begin(firstSpeed);
+  startAutobaudStep();
 }
 
-bool GpsSoftwareSerial::recordUbxTxMessage(UbxMessageClass msgClass, UbxMessageId msgId)
+void GpsSoftwareSerial::onCfgPrt(uint8_t msgClass, uint8_t msgId, const uint8_t* pPayload, uint16_t len, void* pContext)
 {
-  return recordUbxMessage(msgClass, msgId, false);
+  // the settings of UART1 (port ID 1), i.e. the port the OBS is connected to
+  GpsSoftwareSerial* pThis = (GpsSoftwareSerial*)pContext;
+  if(len == CFG_PRT_UART_LEN && pPayload[0] == 1 && !pThis->mCfgPrtRxed)
+  {
+    memcpy(pThis->mCfgPrt, pPayload, CFG_PRT_UART_LEN);
+    pThis->mCfgPrtRxed = true;
+  }
 }
 
-bool GpsSoftwareSerial::recordUbxRxMessage(UbxMessageClass msgClass, UbxMessageId msgId)
+void GpsSoftwareSerial::switchBaudRate(long speed)
 {
-  return recordUbxMessage(msgClass, msgId, true);
+  mPort.updateBaudRate(speed);
+  mBaudRate = speed;
+  // whatever came in before is not worth scoring
+  uint8_t rxBuffer[64];
+  while(mPort.available() > 0 && mPort.read(rxBuffer, sizeof(rxBuffer)) > 0)
+  {
+  }
+  mScorer.reset();
 }
 
-bool GpsSoftwareSerial::rxedMessage(UbxMessage msg)
+void GpsSoftwareSerial::startAutobaudStep()
 {
-  return (mUbxMsgStatus[msg] & UBX_MSG_STATUS_RX_FLAG) ? true : false;
+  if(mAutobaudStep > 0)
+  {
+    switchBaudRate(mAutobaudOrder[mAutobaudStep]);
+  }
+  mScorer.reset();
+  mAutobaudNumTried = mAutobaudStep + 1;
+  mAutobaudStepMs = millis();
+  // the poll answer (and its ACK) are enough to lock for modules that do not talk on their own
+  writeUbxFrame(UBX_MSG_CLASS_CFG, UBX_MSG_ID_CFG_PRT, nullptr, 0);
 }
 
-bool GpsSoftwareSerial::polledMessage(UbxMessage msg)
+size_t GpsSoftwareSerial::readToScorer()
 {
-  return (mUbxMsgStatus[msg] & UBX_MSG_STATUS_POLL_FLAG) ? true : false;
+  // while the rate is not known, the bytes are only scored (they do not count as received)
+  uint8_t rxBuffer[128];
+  size_t total = 0;
+  int pending;
+  while((pending = mPort.available()) > 0)
+  {
+    size_t rxLen = mPort.read(rxBuffer, ((size_t)pending < sizeof(rxBuffer)) ? (size_t)pending : sizeof(rxBuffer));
+    mScorer.feed(rxBuffer, rxLen);
+    total += rxLen;
+  }
+  return total;
 }
 
-bool GpsSoftwareSerial::recordUbxMessage(UbxMessageClass msgClass, UbxMessageId msgId, bool rxedNotPoll)
+void GpsSoftwareSerial::lockAutobaud(uint8_t step)
 {
-  bool success = true;
-  // TODO: realize as critical section (multiple contexts may want to write flags!)
-  uint8_t UBX_MSG_STATUS_FLAG = rxedNotPoll ? UBX_MSG_STATUS_RX_FLAG : UBX_MSG_STATUS_POLL_FLAG;
+  if(step != mAutobaudStep)
+  {
+    switchBaudRate(mAutobaudOrder[step]);
+  }
+  else if(mRxCount < UINT_MAX - mScorer.getByteCount())
+  {
+    mRxCount += mScorer.getByteCount(); // what was scored at the right rate has been received after all
+  }
+  mAutobaudStep = step;
+  if(mUpshiftSpeed > mBaudRate)
+  {
+    // the port settings are needed as they are, only the baudrate is changed
+    mCfgPrtRxed = false;
+    const uint8_t portId = 1;
+    writeUbxFrame(UBX_MSG_CLASS_CFG, UBX_MSG_ID_CFG_PRT, &portId, 1);
+    mAutobaudStepMs = millis();
+    mAutobaudState = AUTOBAUD_UPSHIFT_POLL;
+  }
+  else
+  {
+    finishAutobaud(AUTOBAUD_LOCKED);
+  }
+}
 
-  if(msgClass == UBX_MSG_CLASS_INVALID)
+void GpsSoftwareSerial::finishAutobaud(AutobaudState state)
+{
+  if(state == AUTOBAUD_FAILED)
   {
-    DEBUG_PRINTLN("UBX_MSG_CLASS_INVALID: ");
-    DEBUG_PRINT("  ID: "); DEBUG_PRINTLN(msgId);
-    return false;
+    switchBaudRate(mAutobaudOrder[0]);
   }
+  mAutobaudMs = millis() - mAutobaudStartMs;
+  mAutobaudState = state;
+}
 
-  switch(msgClass)
+bool GpsSoftwareSerial::updateAutobaud()
+{
+  uint32_t now = millis();
+  switch(mAutobaudState)
   {
-    case UBX_MSG_CLASS_NAV:
-      switch(msgId)
+    case AUTOBAUD_SEARCHING:
+    {
+      readToScorer();
+      bool garbage = mScorer.getByteCount() >= AUTOBAUD_GARBAGE_LEN && mScorer.getValidCount() == 0;
+      mAutobaudScores[mAutobaudStep] = mScorer.getScore();
+      if(mScorer.getValidCount() >= AUTOBAUD_LOCK_COUNT)
       {
-        case UBX_MSG_ID_NAV_POSECEF:
-          mUbxMsgStatus[UBX_MSG_NAV_POSECEF] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_NAV_POSLLH:
-          mUbxMsgStatus[UBX_MSG_NAV_POSLLH] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_NAV_STATUS:
-          mUbxMsgStatus[UBX_MSG_NAV_STATUS] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_NAV_DOP:
-          mUbxMsgStatus[UBX_MSG_NAV_DOP] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_NAV_SOL:
-          mUbxMsgStatus[UBX_MSG_NAV_SOL] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_NAV_VELECEF:
-          mUbxMsgStatus[UBX_MSG_NAV_VELECEF] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_NAV_VELNED:
-          mUbxMsgStatus[UBX_MSG_NAV_VELNED] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_NAV_TIMEGPS:
-          mUbxMsgStatus[UBX_MSG_NAV_TIMEGPS] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_NAV_TIMEUTC:
-          mUbxMsgStatus[UBX_MSG_NAV_TIMEUTC] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_NAV_CLOCK:
-          mUbxMsgStatus[UBX_MSG_NAV_CLOCK] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_NAV_SVINFO:
-          mUbxMsgStatus[UBX_MSG_NAV_SVINFO] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_NAV_DGPS:
-          mUbxMsgStatus[UBX_MSG_NAV_DGPS] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_NAV_SBAS:
-          mUbxMsgStatus[UBX_MSG_NAV_SBAS] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_NAV_EFKSTATUS:
-          mUbxMsgStatus[UBX_MSG_NAV_EFKSTATUS] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_NAV_AOPSTATUS:
-          mUbxMsgStatus[UBX_MSG_NAV_AOPSTATUS] |= UBX_MSG_STATUS_FLAG;
-          break;
-        default:
-          DEBUG_PRINTLN("UBX_MSG_CLASS_NAV: ");
-          DEBUG_PRINT("  CLASS: "); DEBUG_PRINTLN(msgClass);
-          DEBUG_PRINT("  ID: "); DEBUG_PRINTLN(msgId);
-          success = false;
+        lockAutobaud(mAutobaudStep);
+      }
+      else if(garbage || now - mAutobaudStepMs >= mAutobaudDwellMs)
+      {
+        if(++mAutobaudStep < mAutobaudNumRates)
+        {
+          startAutobaudStep();
           break;
+        }
+        // a complete round w/o a clear winner: take the best one, if any
+        uint8_t best = 0;
+        for(uint8_t i=1; i<mAutobaudNumRates; i++)
+        {
+          if(mAutobaudScores[i] > mAutobaudScores[best])
+          {
+            best = i;
+          }
+        }
+        mAutobaudStep = mAutobaudNumRates - 1; // the rate set right now
+        if(mAutobaudScores[best] > 0)
+        {
+          lockAutobaud(best);
+        }
+        else
+        {
+          finishAutobaud(AUTOBAUD_FAILED);
+        }
       }
       break;
-    case UBX_MSG_CLASS_ACK:
-      switch(msgId)
+    }
+    case AUTOBAUD_UPSHIFT_POLL:
+    case AUTOBAUD_UPSHIFT_SWITCH:
+    {
+      // still at the rate found: the bytes count as received
+      uint8_t rxBuffer[128];
+      while(readBytes(rxBuffer, sizeof(rxBuffer)) > 0)
       {
-        case UBX_MSG_ID_ACK_NAK:
-          mUbxMsgStatus[UBX_MSG_ACK_NAK] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_ACK_ACK:
-          mUbxMsgStatus[UBX_MSG_ACK_ACK] |= UBX_MSG_STATUS_FLAG;
-          break;
-        default:
-          DEBUG_PRINTLN("UBX_MSG_CLASS_ACK: ");
-          DEBUG_PRINT("  CLASS: "); DEBUG_PRINTLN(msgClass);
-          DEBUG_PRINT("  ID: "); DEBUG_PRINTLN(msgId);
-          success = false;
-          break;
+      }
+      if(mAutobaudState == AUTOBAUD_UPSHIFT_SWITCH)
+      {
+        // the frame (28 bytes) has to be out before the UART changes its rate; the module switches right after it
+        if(now - mAutobaudStepMs > 28 * 10 * 1000 / mBaudRate + 10)
+        {
+          switchBaudRate(mUpshiftSpeed);
+          writeUbxFrame(UBX_MSG_CLASS_CFG, UBX_MSG_ID_CFG_PRT, nullptr, 0); // something to answer at the new rate
+          mAutobaudStepMs = now;
+          mAutobaudState = AUTOBAUD_UPSHIFT_CONFIRM;
+        }
+      }
+      else if(mCfgPrtRxed)
+      {
+        // same settings, new baudrate (little endian at offset 8)
+        uint8_t cfgPrt[CFG_PRT_UART_LEN];
+        memcpy(cfgPrt, mCfgPrt, CFG_PRT_UART_LEN);
+        for(uint8_t i=0; i<4; i++)
+        {
+          cfgPrt[8 + i] = (mUpshiftSpeed >> (8 * i)) & 0xFF;
+        }
+        writeUbxFrame(UBX_MSG_CLASS_CFG, UBX_MSG_ID_CFG_PRT, cfgPrt, CFG_PRT_UART_LEN);
+        mAutobaudStepMs = now;
+        mAutobaudState = AUTOBAUD_UPSHIFT_SWITCH;
+      }
+      else if(now - mAutobaudStepMs >= AUTOBAUD_UPSHIFT_TIMEOUT_MS)
+      {
+        mUpshiftResult = UPSHIFT_NO_ANSWER;
+        finishAutobaud(AUTOBAUD_LOCKED);
       }
       break;
-    case UBX_MSG_CLASS_CFG:
-      switch(msgId)
+    }
+    case AUTOBAUD_UPSHIFT_CONFIRM:
+      readToScorer();
+      if(mScorer.getValidCount() >= AUTOBAUD_LOCK_COUNT)
       {
-        case UBX_MSG_ID_CFG_PRT:
-          mUbxMsgStatus[UBX_MSG_CFG_PRT] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_CFG_MSG:
-          mUbxMsgStatus[UBX_MSG_CFG_MSG] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_CFG_INF:
-          mUbxMsgStatus[UBX_MSG_CFG_INF] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_CFG_DAT:
-          mUbxMsgStatus[UBX_MSG_CFG_DAT] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_CFG_TP:
-          mUbxMsgStatus[UBX_MSG_CFG_TP] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_CFG_RATE:
-          mUbxMsgStatus[UBX_MSG_CFG_RATE] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_CFG_FXN:
-          mUbxMsgStatus[UBX_MSG_CFG_FXN] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_CFG_RXM:
-          mUbxMsgStatus[UBX_MSG_CFG_RXM] |= UBX_MSG_STATUS_FLAG;
-          break;
-        case UBX_MSG_ID_CFG_EKF:
-          mUbxMsgStatus[UBX_MSG_CFG_EKF] |= UBX_MSG_STATUS_FLAG;
-          break;
-        default:
-          DEBUG_PRINTLN("UBX_MSG_CLASS_CFG: ");
-          DEBUG_PRINT("  CLASS: "); DEBUG_PRINTLN(msgClass);
-          DEBUG_PRINT("  ID: "); DEBUG_PRINTLN(msgId);
-          success = false;
-          break;
+        uint32_t elapsedMs = now - mAutobaudStepMs;
+        mUpshiftThroughput = (elapsedMs > 0) ? mScorer.getByteCount() * 1000 / elapsedMs : 0;
+        mUpshiftResult = UPSHIFT_DONE;
+        finishAutobaud(AUTOBAUD_LOCKED);
+      }
+      else if(now - mAutobaudStepMs >= AUTOBAUD_UPSHIFT_TIMEOUT_MS)
+      {
+        switchBaudRate(mAutobaudOrder[mAutobaudStep]);
+        mUpshiftResult = UPSHIFT_NOT_CONFIRMED;
+        finishAutobaud(AUTOBAUD_LOCKED);
       }
       break;
     default:
-      DEBUG_PRINTLN("UBX_MSG_CLASS_INVALID: ");
-      DEBUG_PRINT("  CLASS: "); DEBUG_PRINTLN(msgClass);
-      DEBUG_PRINT("  ID: "); DEBUG_PRINTLN(msgId);
-      success = false;
-      break;
+      return false;
+  }
+  return mAutobaudState != AUTOBAUD_LOCKED && mAutobaudState != AUTOBAUD_FAILED;
+}
+
+bool GpsSoftwareSerial::isValidMessageClass(uint8_t c)
+{
+  return UBX_CLASS_SLOT[c] != NO_SLOT;
+}
+
+GpsSoftwareSerial::UbxMessage GpsSoftwareSerial::lookupUbxMessage(uint8_t msgClass, uint8_t msgId)
+{
+  uint8_t slot = UBX_CLASS_SLOT[msgClass];
+  return (slot == NO_SLOT) ? UBX_MSG_NUM : (UbxMessage)UBX_MSG_LOOKUP[slot][msgId];
+}
+
+bool GpsSoftwareSerial::recordUbxTxMessage(UbxMessageClass msgClass, UbxMessageId msgId)
+{
+  return recordUbxMessage(msgClass, msgId, false);
+}
+
+bool GpsSoftwareSerial::recordUbxRxMessage(UbxMessageClass msgClass, UbxMessageId msgId)
+{
+  return recordUbxMessage(msgClass, msgId, true);
+}
+
+bool GpsSoftwareSerial::rxedMessage(UbxMessage msg)
+{
+  return (mUbxMsgStatus[msg] & UBX_MSG_STATUS_RX_FLAG) ? true : false;
+}
+
+bool GpsSoftwareSerial::polledMessage(UbxMessage msg)
+{
+  return (mUbxMsgStatus[msg] & UBX_MSG_STATUS_POLL_FLAG) ? true : false;
+}
+
+bool GpsSoftwareSerial::recordUbxMessage(UbxMessageClass msgClass, UbxMessageId msgId, bool rxedNotPoll)
+{
+  uint8_t UBX_MSG_STATUS_FLAG = rxedNotPoll ? UBX_MSG_STATUS_RX_FLAG : UBX_MSG_STATUS_POLL_FLAG;
+
+  UbxMessage msg = lookupUbxMessage(msgClass, msgId);
+  if(msg == UBX_MSG_NUM)
+  {
+    // not in the registry (received ones are counted under UBX_MSG_NUM); no printing, this may be the RX context
+    return false;
   }
 
-  return success;
+  mUbxMsgStatus[msg].fetch_or(UBX_MSG_STATUS_FLAG); // atomic, as RX and poll context may set flags concurrently
+  return true;
 }
 
 void GpsSoftwareSerial::inspect(int c)
 {
-  // There's no guarantee to identify UBX and NMEA protocols by checking two or three consecutive bytes, but it's a start...
+  // UBX frames are decoded completely (sync chars, class, ID, length, payload and checksum) before they count as seen;
+  // NMEA sentences are framed and checked for the metrics, but count as seen by their first three characters already
+  // (TinyGPSPlus does the actual decoding)
   switch(mRxState)
   {
     case IDLE:
@@ -201,7 +460,10 @@ void GpsSoftwareSerial::inspect(int c)
       }
       else if(c == '$')
       {
-        mRxState = NMEA_CANDIDATE_1;
+        mNmeaAddressLen = 0;
+        mNmeaLen = 1;
+        mNmeaChecksum = 0;
+        mRxState = NMEA_ADDRESS;
       }
       break;
     case UBX_CANDIDATE:
@@ -211,7 +473,7 @@ void GpsSoftwareSerial::inspect(int c)
       }
       else
       {
-        mRxState = IDLE;
+        resync(c);
       }
       break;
     case UBX_MAGIC_MATCH:
@@ -219,112 +481,370 @@ void GpsSoftwareSerial::inspect(int c)
       if(isValidMessageClass(c))
       {
         mLastMsgClass = (UbxMessageClass)c;
+        mUbxFrame[0] = c;
         mRxState = UBX_VALID_MSG_CLASS;
       }
       else
       {
         mLastMsgClass = UBX_MSG_CLASS_INVALID;
-        mRxState = IDLE;
+        resync(c);
       }
       break;
     case UBX_VALID_MSG_CLASS:
-      // already have message class, now check message ID
-//      Serial.print("Message class: ");
-//      Serial.print(mLastMsgClass, HEX);
-//      Serial.print(", ID: ");
-//      Serial.println(c, HEX);
-      if(recordUbxRxMessage(mLastMsgClass, (UbxMessageId)c))
+      // already have message class, now store the message ID
+      mUbxFrame[1] = c;
+      mRxState = UBX_MSG_ID;
+      break;
+    case UBX_MSG_ID:
+      mUbxFrame[2] = c;
+      mRxState = UBX_LENGTH_LSB;
+      break;
+    case UBX_LENGTH_LSB:
+      mUbxFrame[3] = c;
+      mUbxPayloadLen = (uint16_t)mUbxFrame[2] | ((uint16_t)c << 8);
+      if(mUbxPayloadLen > UBX_MAX_PAYLOAD_LEN)
+      {
+        // cannot be framed with our buffer (or the length field is garbage): drop it and look for the next sync chars
+        mUbxLengthErrorCount.add();
+        mRecorder.trigger(RxRecorder::TRIGGER_UBX_LENGTH);
+        mRxState = IDLE;
+      }
+      else
+      {
+        mUbxFrameIdx = UBX_FRAME_HEADER_LEN;
+        mRxState = (mUbxPayloadLen == 0) ? UBX_PAYLOAD_DONE : UBX_PAYLOAD;
+      }
+      break;
+    case UBX_PAYLOAD:
+      mUbxFrame[mUbxFrameIdx++] = c;
+      if(mUbxFrameIdx == UBX_FRAME_HEADER_LEN + mUbxPayloadLen)
       {
-        mSeenUbx = true; // if we ever get here, asue that UBX is alive
+        mRxState = UBX_PAYLOAD_DONE;
       }
+      break;
+    case UBX_PAYLOAD_DONE:
+      mUbxCkA = c;
+      mRxState = UBX_CHECKSUM_A;
+      break;
+    case UBX_CHECKSUM_A:
+      processUbxFrame(c);
       mRxState = IDLE; // always return to IDLE
       break;
-    case NMEA_CANDIDATE_1:
-      if(c == 'G')
+    case NMEA_ADDRESS:
+      if(mNmeaLen >= NMEA_MAX_LEN - 3 || !(isNmeaAddressChar(c) || (c == ',' && mNmeaAddressLen > 0)))
+      {
+        resync(c);
+        break;
+      }
+      mNmeaChecksum ^= c;
+      mNmeaLen++;
+      if(c == ',')
+      {
+        mRxState = NMEA_BODY;
+        break;
+      }
+      if(mNmeaAddressLen < sizeof(mNmeaAddress))
+      {
+        mNmeaAddress[mNmeaAddressLen] = c;
+      }
+      mNmeaAddressLen++;
+      if(mNmeaAddressLen == 2 && mNmeaAddress[0] == 'G' && (c == 'P' || c == 'N'))
+      {
+        mSeenNmea = true; // "$GP"/"$GN"
+      }
+      break;
+    case NMEA_BODY:
+      if(c == '*')
       {
-        mRxState = NMEA_CANDIDATE_2;
+        mRxState = NMEA_CHECKSUM_HI;
+      }
+      else if(c < 0x20 || c > 0x7E || c == '$' || mNmeaLen >= NMEA_MAX_LEN - 3)
+      {
+        resync(c);
       }
       else
       {
-        mRxState = IDLE;
+        mNmeaChecksum ^= c;
+        mNmeaLen++;
+      }
+      break;
+    case NMEA_CHECKSUM_HI:
+      if(hexValue(c) < 0)
+      {
+        resync(c);
+      }
+      else
+      {
+        mNmeaChecksumRx = hexValue(c) << 4;
+        mRxState = NMEA_CHECKSUM_LO;
       }
       break;
-    case NMEA_CANDIDATE_2:
-      if(c == 'P' || c == 'N')
+    case NMEA_CHECKSUM_LO:
+      if(hexValue(c) < 0)
       {
-        mSeenNmea = true;
-        mRxState = NMEA_MAGIC_MATCH;
+        resync(c);
       }
       else
       {
+        processNmeaSentence(mNmeaChecksumRx | hexValue(c));
         mRxState = IDLE;
       }
       break;
     default:
-      mRxState = IDLE;
+      resync(c);
       break;
   }
 }
 
+void GpsSoftwareSerial::resync(int c)
+{
+  // the byte that broke a candidate sequence may already be the start of the next one
+  mResyncCount.add();
+  mRxState = IDLE;
+  inspect(c);
+}
+
+void GpsSoftwareSerial::processUbxFrame(uint8_t ckB)
+{
+  // the checksum covers class, ID, length and payload, which are stored contiguously in the frame buffer
+  uint16_t checksum = calcFletcherChecksum(mUbxFrame, UBX_FRAME_HEADER_LEN + mUbxPayloadLen);
+  if(checksum != (((uint16_t)mUbxCkA << 8) | (uint16_t)ckB))
+  {
+    mUbxChecksumErrorCount.add();
+    mRecorder.trigger(RxRecorder::TRIGGER_UBX_CHECKSUM);
+    return;
+  }
+
+  mUbxFrameCount.add();
+  mUbxCounts[lookupUbxMessage(mUbxFrame[0], mUbxFrame[1])].add(); // UBX_MSG_NUM: not in the registry
+  mSeenUbx = true; // a frame with valid checksum is proof enough that UBX is alive
+  recordUbxRxMessage(mLastMsgClass, (UbxMessageId)mUbxFrame[1]);
+
+  // hand over the payload in place (no copy)
+  for(uint8_t i=0; i<mNumUbxHandlers; i++)
+  {
+    const UbxHandlerSlot& slot = mUbxHandlers[i];
+    if((slot.msgClass == UBX_ANY || slot.msgClass == mUbxFrame[0]) &&
+       (slot.msgId == UBX_ANY || slot.msgId == mUbxFrame[1]))
+    {
+      slot.handler(mUbxFrame[0], mUbxFrame[1], &mUbxFrame[UBX_FRAME_HEADER_LEN], mUbxPayloadLen, slot.pContext);
+    }
+  }
+}
+
+void GpsSoftwareSerial::processNmeaSentence(uint8_t checksum)
+{
+  if(checksum != mNmeaChecksum)
+  {
+    mNmeaChecksumErrorCount.add();
+    return;
+  }
+  mNmeaSentenceCount.add();
+
+  // talker ID (2 characters) and sentence formatter (3 characters); proprietary sentences start with 'P'
+  NmeaSentence type = NMEA_OTHER;
+  if(mNmeaAddressLen == sizeof(mNmeaAddress) && mNmeaAddress[0] != 'P')
+  {
+    for(uint8_t i=0; i<NMEA_OTHER; i++)
+    {
+      if(memcmp(&mNmeaAddress[2], NMEA_SENTENCE_NAMES[i], 3) == 0)
+      {
+        type = (NmeaSentence)i;
+        break;
+      }
+    }
+  }
+  mNmeaCounts[type].add();
+}
+
+const char* GpsSoftwareSerial::getNmeaSentenceName(NmeaSentence type)
+{
+  return (type < NMEA_NUM) ? NMEA_SENTENCE_NAMES[type] : "";
+}
+
+bool GpsSoftwareSerial::addUbxHandler(uint8_t msgClass, uint8_t msgId, UbxPayloadHandler handler, void* pContext)
+{
+  if(handler == nullptr || mNumUbxHandlers >= UBX_MAX_HANDLERS)
+  {
+    return false;
+  }
+  mUbxHandlers[mNumUbxHandlers].msgClass = msgClass;
+  mUbxHandlers[mNumUbxHandlers].msgId = msgId;
+  mUbxHandlers[mNumUbxHandlers].handler = handler;
+  mUbxHandlers[mNumUbxHandlers].pContext = pContext;
+  ++mNumUbxHandlers;
+  return true;
+}
+
 bool GpsSoftwareSerial::pollUbxMessage(UbxMessageClass msgClass, UbxMessageId msgId)
 {
-  bool txSuccess = true;
-  // send an UBX (binar protocol) message
-  // (and implicitely expect an ACK-* message back; please note that the RX side is not covered within this function)
-  uint8_t ubxTxMsg[8] = {
-    0xB5, // 1st sync char
-    0x62, // 2nd sync char
-    (uint8_t)msgClass, // message class
-    (uint8_t)msgId, // message ID
-    0x00, // 1st length byte
-    0x00, // 2nd length byte
-    0xDE, // 1st checksum byte 'CK_A' (to be calculated)
-    0xAD, // 2nd checksum byte 'CK_B' (to be calculated)
-  };
+  // send an UBX (binary protocol) poll request, i.e. the message w/o payload
+  // (and implicitely expect the message or an ACK-* message back; please note that the RX side is not covered within
+  // this function, see UbxEngine for that)
+  return sendUbxMessage(msgClass, msgId, nullptr, 0);
+}
 
-  uint16_t checksum = calcFletcherChecksum(&ubxTxMsg[2], /*len=*/4); // calculate checksum (start at the class field, i.e. at offset +2)
-  ubxTxMsg[6] = (checksum >> 8) & 0x00FF; // update CK_A
-  ubxTxMsg[7] = checksum & 0x00FF; // update CK_B
+bool GpsSoftwareSerial::pollUbxMessage(UbxMessage msg)
+{
+  if(msg >= UBX_MSG_NUM)
+  {
+    return false;
+  }
+  return sendUbxMessage(UBX_MESSAGES[msg].msgClass, UBX_MESSAGES[msg].msgId, getPollPayload(msg),
+                        UBX_MESSAGES[msg].pollPayloadLen);
+}
 
-  // send those message bytes!
-  for(size_t i=0; i<sizeof(ubxTxMsg)/sizeof(ubxTxMsg[0]); i++)
+const uint8_t* GpsSoftwareSerial::getPollPayload(UbxMessage msg)
+{
+  switch(msg)
   {
-    write(ubxTxMsg[i]);
+    case UBX_MSG_CFG_MSG:
+      return CFG_MSG_POLL_PAYLOAD;
+    case UBX_MSG_CFG_INF:
+      return CFG_INF_POLL_PAYLOAD;
+    default:
+      return nullptr;
   }
+}
 
-  txSuccess = recordUbxTxMessage(msgClass, msgId);
+bool GpsSoftwareSerial::sendUbxMessage(uint8_t msgClass, uint8_t msgId, const uint8_t* pPayload, uint16_t len)
+{
+  if(!writeUbxFrame(msgClass, msgId, pPayload, len))
+  {
+    return false;
+  }
 
-  return txSuccess;
+  // messages that are not in the registry are sent all the same, they are only not recorded
+  if(lookupUbxMessage(msgClass, msgId) != UBX_MSG_NUM)
+  {
+    recordUbxTxMessage((UbxMessageClass)msgClass, (UbxMessageId)msgId);
+  }
+  return true;
+}
+
+bool GpsSoftwareSerial::writeUbxFrame(uint8_t msgClass, uint8_t msgId, const uint8_t* pPayload, uint16_t len)
+{
+  if(len > UBX_MAX_TX_PAYLOAD_LEN || (len > 0 && pPayload == nullptr))
+  {
+    return false;
+  }
+
+  // sync chars, class, ID, length (little endian), payload and the checksum over class to payload
+  uint8_t ubxTxMsg[2 + UBX_FRAME_HEADER_LEN + UBX_MAX_TX_PAYLOAD_LEN + 2];
+  ubxTxMsg[0] = 0xB5; // 1st sync char
+  ubxTxMsg[1] = 0x62; // 2nd sync char
+  ubxTxMsg[2] = msgClass;
+  ubxTxMsg[3] = msgId;
+  ubxTxMsg[4] = len & 0xFF;
+  ubxTxMsg[5] = len >> 8;
+  if(len > 0)
+  {
+    memcpy(&ubxTxMsg[6], pPayload, len);
+  }
+  uint16_t checksum = calcFletcherChecksum(&ubxTxMsg[2], UBX_FRAME_HEADER_LEN + len);
+  ubxTxMsg[6 + len] = (checksum >> 8) & 0x00FF; // CK_A
+  ubxTxMsg[7 + len] = checksum & 0x00FF; // CK_B
+
+  // send those message bytes at once
+  return mPort.write(ubxTxMsg, 8 + len) == (size_t)(8 + len);
 }
 
 int GpsSoftwareSerial::read()
 {
-  int character = Serial2.read();
+  int character = mPort.read();
   if(character != -1)
   {
-    inspect(character);
+    uint8_t c = character;
+    mRecorder.record(&c, 1);
+    mRxByteCount.add();
+    recordRxByte(c);
+  }
+  return character;
+}
+
+size_t GpsSoftwareSerial::readBytes(uint8_t* pBuf, size_t len)
+{
+  // non-blocking bulk read: get whatever is pending (up to `len` bytes) and inspect the whole chunk
+  int pending = mPort.available();
+  if(pending <= 0)
+  {
+    return 0;
+  }
+  if((size_t)pending > mRxHighWater)
+  {
+    mRxHighWater = pending;
+  }
+  unsigned int overflows = mRxOverflowCount.load();
+  if(overflows != mRxOverflowsSeen)
+  {
+    mRxOverflowsSeen = overflows;
+    mRecorder.trigger(RxRecorder::TRIGGER_OVERFLOW); // the bytes lost were before this chunk
+  }
+
+  size_t rxLen = mPort.read(pBuf, ((size_t)pending < len) ? (size_t)pending : len);
+  feed(pBuf, rxLen);
+  return rxLen;
+}
 
-    if(mRxCount < RX_STARTUP_MEM_LEN)
+void GpsSoftwareSerial::feed(const uint8_t* pBuf, size_t len)
+{
+  mRecorder.record(pBuf, len);
+  mRxByteCount.add(len);
+
+  // same result as inspect() byte by byte, but between frames it skips to the next sync char (the bytes in between
+  // do not change the state) and UBX payloads are copied in one go
+  const uint8_t* p = pBuf;
+  const uint8_t* pEnd = pBuf + len;
+  while(p < pEnd)
+  {
+    if(mRxState == IDLE)
     {
-      mRxStartupMem[mRxCount] = character; // memorize for later analysis
+      p = findSyncChar(p, pEnd - p);
+      if(p == nullptr)
+      {
+        break;
+      }
     }
-    
-    if(mRxCount < UINT_MAX) // saturate to prevent roll-over
+    else if(mRxState == UBX_PAYLOAD)
     {
-      ++mRxCount;
+      size_t chunkLen = UBX_FRAME_HEADER_LEN + mUbxPayloadLen - mUbxFrameIdx;
+      if(chunkLen > (size_t)(pEnd - p))
+      {
+        chunkLen = pEnd - p;
+      }
+      memcpy(&mUbxFrame[mUbxFrameIdx], p, chunkLen);
+      mUbxFrameIdx += chunkLen;
+      p += chunkLen;
+      if(mUbxFrameIdx == UBX_FRAME_HEADER_LEN + mUbxPayloadLen)
+      {
+        mRxState = UBX_PAYLOAD_DONE;
+      }
+      continue;
     }
+    inspect(*p++);
+  }
+
+  mRxCount = (len < UINT_MAX - mRxCount) ? mRxCount + len : UINT_MAX; // saturate to prevent roll-over
+}
+
+void GpsSoftwareSerial::recordRxByte(uint8_t c)
+{
+  inspect(c);
+
+  if(mRxCount < UINT_MAX) // saturate to prevent roll-over
+  {
+    ++mRxCount;
   }
-  return character;
 }
 
 size_t GpsSoftwareSerial::write(uint8_t b)
 {
-  return Serial2.write(b);
+  return mPort.write(b);
 }
 
 int GpsSoftwareSerial::available()
 {
-  return Serial2.available();
+  return mPort.available();
 }
 
 bool GpsSoftwareSerial::hasSeenUbx()
@@ -342,7 +862,34 @@ unsigned int GpsSoftwareSerial::getRxCount()
   return mRxCount;
 }
 
-uint16_t GpsSoftwareSerial::calcFletcherChecksum(uint8_t* pData, size_t len)
+uint16_t GpsSoftwareSerial::calcFletcherChecksum(const uint8_t* pData, size_t len)
+{
+  // 8 bit Fletcher algorithm, four bytes per step: after bytes b0..b3, CK_A has grown by their sum and CK_B by four
+  // times the previous CK_A plus 4*b0 + 3*b1 + 2*b2 + b3; both are kept in 32 bits and truncated only at the end (no
+  // masking per byte, and as 2^32 is a multiple of 256, wrapping around does not change the result)
+  uint32_t ckA = 0;
+  uint32_t ckB = 0;
+  const uint8_t* pEnd4 = pData + (len & ~(size_t)3);
+  while(pData < pEnd4)
+  {
+    uint32_t b0 = pData[0];
+    uint32_t b1 = pData[1];
+    uint32_t b2 = pData[2];
+    uint32_t b3 = pData[3];
+    ckB += 4 * ckA + 4 * b0 + 3 * b1 + 2 * b2 + b3;
+    ckA += b0 + b1 + b2 + b3;
+    pData += 4;
+  }
+  for(size_t i=0; i<(len & 3); i++)
+  {
+    ckA += *pData;
+    ckB += ckA;
+    pData++;
+  }
+  return ((ckA & 0xFF) << 8) | (ckB & 0xFF);
+}
+
+uint16_t GpsSoftwareSerial::calcFletcherChecksumScalar(const uint8_t* pData, size_t len)
 {
   // calculate checksum using 8 bit Fletcher algorithm
   uint8_t ckA = 0;
@@ -355,3 +902,76 @@ uint16_t GpsSoftwareSerial::calcFletcherChecksum(uint8_t* pData, size_t len)
   }
   return ((uint16_t)ckA << 8) | (uint16_t)ckB;
 }
+
+const uint8_t* GpsSoftwareSerial::findSyncChar(const uint8_t* pData, size_t len)
+{
+#if defined(__SSE2__) || defined(__ARM_NEON)
+  // 16 bytes per compare (unaligned loads), the block w/ a hit is searched byte by byte
+  const uint8_t* pEnd = pData + len;
+  while(pEnd - pData >= 16)
+  {
+#if defined(__SSE2__)
+    __m128i v = _mm_loadu_si128((const __m128i*)pData);
+    __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8((char)0xB5)), _mm_cmpeq_epi8(v, _mm_set1_epi8('$')));
+    if(_mm_movemask_epi8(hits) != 0)
+#else
+    uint8x16_t v = vld1q_u8(pData);
+    uint64x2_t hits = vreinterpretq_u64_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8(0xB5)), vceqq_u8(v, vdupq_n_u8('$'))));
+    if((vgetq_lane_u64(hits, 0) | vgetq_lane_u64(hits, 1)) != 0)
+#endif
+    {
+      return findSyncCharScalar(pData, 16);
+    }
+    pData += 16;
+  }
+  return findSyncCharScalar(pData, pEnd - pData);
+#else
+  return findSyncCharSwar(pData, len);
+#endif
+}
+
+const uint8_t* GpsSoftwareSerial::findSyncCharSwar(const uint8_t* pData, size_t len)
+{
+  // SIMD within a register: x ^ 0xB5B5B5B5 has a zero byte where x has 0xB5, and (y - 0x01010101) & ~y & 0x80808080
+  // is not 0 iff y has a zero byte; the word w/ a hit is searched byte by byte. Word loads are aligned (the ESP32
+  // faults on unaligned ones), the bytes up to the first word boundary are checked one by one.
+  size_t headLen = (size_t)(-(uintptr_t)pData & 3);
+  if(headLen > len)
+  {
+    headLen = len;
+  }
+  const uint8_t* pHit = findSyncCharScalar(pData, headLen);
+  if(pHit != nullptr)
+  {
+    return pHit;
+  }
+  pData += headLen;
+  len -= headLen;
+
+  while(len >= 4)
+  {
+    uint32_t word;
+    memcpy(&word, __builtin_assume_aligned(pData, 4), 4); // a single aligned load, w/o breaking strict aliasing
+    uint32_t x = word ^ 0xB5B5B5B5;
+    uint32_t y = word ^ 0x24242424; // '$'
+    if((((x - 0x01010101) & ~x) | ((y - 0x01010101) & ~y)) & 0x80808080)
+    {
+      return findSyncCharScalar(pData, 4);
+    }
+    pData += 4;
+    len -= 4;
+  }
+  return findSyncCharScalar(pData, len);
+}
+
+const uint8_t* GpsSoftwareSerial::findSyncCharScalar(const uint8_t* pData, size_t len)
+{
+  for(size_t i=0; i<len; i++)
+  {
+    if(pData[i] == 0xB5 || pData[i] == '$')
+    {
+      return &pData[i];
+    }
+  }
+  return nullptr;
+}
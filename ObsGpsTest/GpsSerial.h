@@ -1,21 +1,104 @@
 #ifndef GpsSoftwareSerial_h
 #define GpsSoftwareSerial_h
 
-#include <SoftwareSerial.h>
+#include <Arduino.h>
+#include <atomic>
+#include "FrameScorer.h"
+#include "RxRecorder.h"
+#include "MetricCounter.h"
+
+// UBX message registry: one line per message known to the test (dense index name, class, ID, display name, poll payload length, flags);
+// the UbxMessage enum, the RX lookup table, the polls and the status pages are all derived from this list
+// (please note that the polls are sent in this order, CFG-PRT is the one Techtotop modules answer to, so it goes last)
+#define UBX_MESSAGE_REGISTRY(X) \
+  X(NAV_POSECEF,   NAV, 0x01, "NAV-POSECEF",   0, UBX_MSG_FLAG_POLL) \
+  X(NAV_POSLLH,    NAV, 0x02, "NAV-POSLLH",    0, UBX_MSG_FLAG_POLL) \
+  X(NAV_STATUS,    NAV, 0x03, "NAV-STATUS",    0, UBX_MSG_FLAG_POLL) \
+  X(NAV_DOP,       NAV, 0x04, "NAV-DOP",       0, UBX_MSG_FLAG_POLL) \
+  X(NAV_SOL,       NAV, 0x06, "NAV-SOL",       0, UBX_MSG_FLAG_POLL) \
+  X(NAV_VELECEF,   NAV, 0x11, "NAV-VELECEF",   0, UBX_MSG_FLAG_POLL) \
+  X(NAV_VELNED,    NAV, 0x12, "NAV-VELNED",    0, UBX_MSG_FLAG_POLL) \
+  X(NAV_TIMEGPS,   NAV, 0x20, "NAV-TIMEGPS",   0, UBX_MSG_FLAG_POLL) \
+  X(NAV_TIMEUTC,   NAV, 0x21, "NAV-TIMEUTC",   0, UBX_MSG_FLAG_POLL) \
+  X(NAV_CLOCK,     NAV, 0x22, "NAV-CLOCK",     0, UBX_MSG_FLAG_POLL) \
+  X(NAV_SVINFO,    NAV, 0x30, "NAV-SVINFO",    0, UBX_MSG_FLAG_POLL) \
+  X(NAV_DGPS,      NAV, 0x31, "NAV-DGPS",      0, UBX_MSG_FLAG_POLL) \
+  X(NAV_SBAS,      NAV, 0x32, "NAV-SBAS",      0, UBX_MSG_FLAG_POLL) \
+  X(NAV_EFKSTATUS, NAV, 0x40, "NAV-EFKSTATUS", 0, UBX_MSG_FLAG_POLL) \
+  X(NAV_AOPSTATUS, NAV, 0x60, "NAV-AOPSTATUS", 0, UBX_MSG_FLAG_POLL) \
+  X(CFG_MSG,       CFG, 0x01, "CFG-MSG",       2, UBX_MSG_FLAG_POLL) \
+  X(CFG_INF,       CFG, 0x02, "CFG-INF",       1, UBX_MSG_FLAG_POLL) \
+  X(CFG_DAT,       CFG, 0x06, "CFG-DAT",       0, UBX_MSG_FLAG_POLL) \
+  X(CFG_TP,        CFG, 0x07, "CFG-TP",        0, UBX_MSG_FLAG_POLL) \
+  X(CFG_RATE,      CFG, 0x08, "CFG-RATE",      0, UBX_MSG_FLAG_POLL) \
+  X(CFG_FXN,       CFG, 0x0E, "CFG-FXN",       0, UBX_MSG_FLAG_POLL) \
+  X(CFG_RXM,       CFG, 0x11, "CFG-RXM",       0, UBX_MSG_FLAG_POLL) \
+  X(CFG_EKF,       CFG, 0x12, "CFG-EKF",       0, UBX_MSG_FLAG_POLL) \
+  X(CFG_PRT,       CFG, 0x00, "CFG-PRT",       0, UBX_MSG_FLAG_POLL) \
+  X(ACK_NAK,       ACK, 0x00, "ACK-NAK",       0, 0) \
+  X(ACK_ACK,       ACK, 0x01, "ACK-ACK",       0, 0)
+
+// NMEA sentences counted by type (sentence formatter, i.e. the address field w/o the talker ID); all others, including
+// the proprietary ones, are counted as NMEA_OTHER
+#define NMEA_SENTENCE_REGISTRY(X) \
+  X(GGA) \
+  X(GLL) \
+  X(GSA) \
+  X(GSV) \
+  X(RMC) \
+  X(VTG) \
+  X(ZDA) \
+  X(TXT)
 
 
 class GpsSoftwareSerial {
   public:
-    static const unsigned int RX_STARTUP_MEM_LEN = 64;
+    static const size_t RX_BUFFER_SIZE = 1024; // size of the UART driver's RX buffer (default would be 256 bytes)
+    static const uint16_t UBX_FRAME_HEADER_LEN = 4; // class, ID and two length bytes (i.e. the part covered by the checksum before the payload)
+    static const uint16_t UBX_MAX_PAYLOAD_LEN = 512; // longer frames are dropped (NAV-SVINFO w/ 32 channels has 8 + 32 * 12 bytes)
+    static const uint16_t UBX_MAX_TX_PAYLOAD_LEN = 64; // of the frames sent (the longest CFG message used is CFG-PRT w/ 20 bytes)
+    static const uint8_t UBX_MAX_HANDLERS = 8;
+    static const uint8_t UBX_ANY = 0xFF; // wildcard for message class and/or ID when registering a handler
+    static const uint8_t AUTOBAUD_NUM_RATES = 9;
+    static const uint32_t AUTOBAUD_RATES[AUTOBAUD_NUM_RATES]; // in the order they are tried (the common ones first)
+    static const uint8_t AUTOBAUD_LOCK_COUNT = 2; // valid frames at one rate to lock onto it right away
+    static const unsigned int AUTOBAUD_GARBAGE_LEN = 256; // bytes w/o a single valid frame to give up on a rate early
+    static const uint32_t AUTOBAUD_UPSHIFT_TIMEOUT_MS = 1000; // for the CFG-PRT answer and for the confirmation each
+
+    // handler for validated UBX frames; the payload points into the receive buffer and is only valid during the call
+    typedef void (*UbxPayloadHandler)(uint8_t msgClass, uint8_t msgId, const uint8_t* pPayload, uint16_t len, void* pContext);
 
     enum GpsRxState {
       IDLE,
       UBX_CANDIDATE, // 1st sync byte rx'ed (0xB5)
       UBX_MAGIC_MATCH, // 2nd sync byte rx'ed (0x62)
       UBX_VALID_MSG_CLASS, // 3rd UBX byte rx'ed and found within the expected set
-      NMEA_CANDIDATE_1, // 1st byte is '$' (start of sequence)
-      NMEA_CANDIDATE_2, // 2nd byte is 'G'
-      NMEA_MAGIC_MATCH // 3rd byte is 'N' or 'P' (i.e. received "$GP"/"$GN")
+      UBX_MSG_ID, // 4th UBX byte (message ID) rx'ed
+      UBX_LENGTH_LSB, // 5th UBX byte (1st length byte, little endian) rx'ed
+      UBX_PAYLOAD, // 6th UBX byte (2nd length byte) rx'ed, now receiving the payload
+      UBX_PAYLOAD_DONE, // all payload bytes rx'ed (or none expected)
+      UBX_CHECKSUM_A, // 1st checksum byte 'CK_A' rx'ed (the next one completes the frame)
+      NMEA_ADDRESS, // '$' rx'ed (start of sequence), now receiving the address field up to the first ','
+      NMEA_BODY, // receiving the data fields up to '*'
+      NMEA_CHECKSUM_HI, // '*' rx'ed, the next two hex digits are the checksum
+      NMEA_CHECKSUM_LO
+    };
+
+    enum AutobaudState {
+      AUTOBAUD_OFF, // fixed baudrate, see begin()
+      AUTOBAUD_SEARCHING, // trying one rate after the other
+      AUTOBAUD_UPSHIFT_POLL, // locked, waiting for the module's port settings (CFG-PRT)
+      AUTOBAUD_UPSHIFT_SWITCH, // CFG-PRT w/ the higher baudrate sent, waiting for it to go out
+      AUTOBAUD_UPSHIFT_CONFIRM, // at the higher baudrate, waiting for valid frames
+      AUTOBAUD_LOCKED, // done: see getBaudRate() and getUpshiftResult()
+      AUTOBAUD_FAILED // done: no rate scored, back at the first one
+    };
+
+    enum UpshiftResult {
+      UPSHIFT_NONE, // not requested (or not higher than the rate found)
+      UPSHIFT_DONE,
+      UPSHIFT_NO_ANSWER, // the module did not answer the CFG-PRT poll (e.g. does not speak UBX)
+      UPSHIFT_NOT_CONFIRMED // no valid frames at the higher rate, back at the rate found
     };
 
     // UBX message classes (ignoring "proprietary" ones)
@@ -76,72 +159,189 @@ class GpsSoftwareSerial {
     const uint8_t UBX_MSG_STATUS_RX_FLAG = 0x10;
     const uint8_t UBX_MSG_STATUS_POLL_FLAG = 0x01;
 
-    // UBX message classes (w/o UBX related IDs, continuous 0-based integer range)
+    // flags of the UBX message registry
+    static const uint8_t UBX_MSG_FLAG_POLL = 0x01; // polled by the test (and therefore shown on the status pages)
+
+    // UBX messages (w/o UBX related IDs, continuous 0-based integer range), generated from UBX_MESSAGE_REGISTRY
     enum UbxMessage {
-      UBX_MSG_NAV_POSECEF,
-      UBX_MSG_NAV_POSLLH,
-      UBX_MSG_NAV_STATUS,
-      UBX_MSG_NAV_DOP,
-      UBX_MSG_NAV_SOL,
-      UBX_MSG_NAV_VELECEF,
-      UBX_MSG_NAV_VELNED,
-      UBX_MSG_NAV_TIMEGPS,
-      UBX_MSG_NAV_TIMEUTC,
-      UBX_MSG_NAV_CLOCK,
-      UBX_MSG_NAV_SVINFO,
-      UBX_MSG_NAV_DGPS,
-      UBX_MSG_NAV_SBAS,
-      UBX_MSG_NAV_EFKSTATUS,
-      UBX_MSG_NAV_AOPSTATUS,
-
-      UBX_MSG_ACK_NAK,
-      UBX_MSG_ACK_ACK,
-
-      UBX_MSG_CFG_PRT,
-      UBX_MSG_CFG_MSG,
-      UBX_MSG_CFG_INF,
-      UBX_MSG_CFG_DAT,
-      UBX_MSG_CFG_TP,
-      UBX_MSG_CFG_RATE,
-      UBX_MSG_CFG_FXN,
-      UBX_MSG_CFG_RXM,
-      UBX_MSG_CFG_EKF,
+#define UBX_MSG_ENUM_ENTRY(msg, msgClass, msgId, name, pollPayloadLen, flags) UBX_MSG_##msg,
+      UBX_MESSAGE_REGISTRY(UBX_MSG_ENUM_ENTRY)
+#undef UBX_MSG_ENUM_ENTRY
 
       UBX_MSG_NUM
     };
 
-    GpsSoftwareSerial(uint8_t receivePin, uint8_t transmitPin);
-    ~GpsSoftwareSerial();
+    // NMEA sentence types, generated from NMEA_SENTENCE_REGISTRY
+    enum NmeaSentence {
+#define NMEA_SENTENCE_ENUM_ENTRY(type) NMEA_##type,
+      NMEA_SENTENCE_REGISTRY(NMEA_SENTENCE_ENUM_ENTRY)
+#undef NMEA_SENTENCE_ENUM_ENTRY
+
+      NMEA_OTHER,
+      NMEA_NUM
+    };
+
+    static const uint8_t NMEA_MAX_LEN = 82; // '$' to the end of the checksum (NMEA 0183)
+
+    struct UbxMessageInfo {
+      uint8_t msgClass;
+      uint8_t msgId;
+      const char* name; // display name
+      uint8_t pollPayloadLen; // payload length of the poll request (see getPollPayload())
+      uint8_t flags;
+    };
+
+    static constexpr UbxMessageInfo UBX_MESSAGES[UBX_MSG_NUM] = {
+#define UBX_MSG_INFO_ENTRY(msg, msgClass, msgId, name, pollPayloadLen, flags) { UBX_MSG_CLASS_##msgClass, msgId, name, pollPayloadLen, flags },
+      UBX_MESSAGE_REGISTRY(UBX_MSG_INFO_ENTRY)
+#undef UBX_MSG_INFO_ENTRY
+    };
+
+    // the module is connected to `port` (any of the ESP32's UARTs, the pins are routed there by begin()), or to the
+    // UART with that number
+    GpsSoftwareSerial(HardwareSerial& port, uint8_t receivePin, uint8_t transmitPin);
+    GpsSoftwareSerial(uint8_t uartNum, uint8_t receivePin, uint8_t transmitPin);
+    static HardwareSerial& getUart(uint8_t uartNum); // UART0..2 (UART0: the debug serial, unless that's USB CDC)
     void begin(long speed);
+    // automatic baudrate detection (instead of begin()): the rates are tried one after the other, starting with
+    // `firstSpeed`, each for up to `dwellMs` while scoring the framing of what comes in (see FrameScorer; a CFG-PRT
+    // poll is sent at each rate to wake up modules that only talk when asked); the first rate w/ enough valid frames
+    // wins, otherwise the best one after a complete round. When `upshiftSpeed` is higher, the module is moved there
+    // with CFG-PRT afterwards, which has to be confirmed by valid frames at the new rate (or it is taken back).
+    // Non-blocking: call updateAutobaud() (instead of reading) until it returns false.
+    void beginAutobaud(long firstSpeed, uint32_t dwellMs, long upshiftSpeed = 0);
+    bool updateAutobaud();
+    AutobaudState getAutobaudState() { return mAutobaudState; }
+    long getBaudRate() { return mBaudRate; }
+    uint32_t getAutobaudMs() { return mAutobaudMs; } // search (and upshift) duration
+    uint8_t getAutobaudNumTried() { return mAutobaudNumTried; }
+    uint32_t getAutobaudRate(uint8_t step) { return mAutobaudOrder[step]; } // step < getAutobaudNumTried()
+    int getAutobaudScore(uint8_t step) { return mAutobaudScores[step]; }
+    UpshiftResult getUpshiftResult() { return mUpshiftResult; }
+    uint32_t getUpshiftThroughput() { return mUpshiftThroughput; } // bytes/s that came in at the new rate while confirming
     int read();
+    size_t readBytes(uint8_t* pBuf, size_t len);
+    void feed(const uint8_t* pBuf, size_t len); // inspect bytes that have been received elsewhere (e.g. benchmarks)
     int available();
     size_t write(uint8_t b);
 
     bool hasSeenUbx();
     bool hasSeenNmea();
     unsigned int getRxCount();
-    unsigned int getRxStartupMemLen() { return RX_STARTUP_MEM_LEN; }
-    int* getRxStartupMem() { return mRxStartupMem; }
+    unsigned int getRxOverflowCount() { return mRxOverflowCount; }
+    size_t getRxHighWater() { return mRxHighWater; }
+    size_t getRxBufferSize() { return RX_BUFFER_SIZE; }
+    RxRecorder& getRecorder() { return mRecorder; } // raw RX capture (recording once begun, see RxRecorder::begin())
     bool isValidMessageClass(uint8_t c);
     bool pollUbxMessage(UbxMessageClass msgClass, UbxMessageId msgId);
+    bool pollUbxMessage(UbxMessage msg);
+    bool sendUbxMessage(uint8_t msgClass, uint8_t msgId, const uint8_t* pPayload, uint16_t len); // any UBX frame
+    static const uint8_t* getPollPayload(UbxMessage msg); // payload of the poll request (`pollPayloadLen` bytes)
+    static UbxMessage lookupUbxMessage(uint8_t msgClass, uint8_t msgId);
     bool rxedMessage(UbxMessage msg);
     bool polledMessage(UbxMessage msg);
+    bool addUbxHandler(uint8_t msgClass, uint8_t msgId, UbxPayloadHandler handler, void* pContext = nullptr);
+    unsigned int getUbxFrameCount() { return mUbxFrameCount.get(); }
+    unsigned int getUbxChecksumErrorCount() { return mUbxChecksumErrorCount.get(); }
+    unsigned int getUbxLengthErrorCount() { return mUbxLengthErrorCount.get(); }
+
+    // protocol metrics (written in the RX context, wrapping, see MetricCounter): bytes received, sentences and frames
+    // by type (UBX: by UbxMessage, UBX_MSG_NUM for messages not in the registry), errors and framing resyncs, i.e.
+    // frames broken off by an unexpected byte
+    uint32_t getRxByteCount() { return mRxByteCount.get(); }
+    uint32_t getNmeaSentenceCount() { return mNmeaSentenceCount.get(); }
+    uint32_t getNmeaChecksumErrorCount() { return mNmeaChecksumErrorCount.get(); }
+    uint32_t getNmeaCount(NmeaSentence type) { return mNmeaCounts[type].get(); }
+    uint32_t getUbxCount(UbxMessage msg) { return mUbxCounts[msg].get(); } // msg <= UBX_MSG_NUM
+    uint32_t getResyncCount() { return mResyncCount.get(); }
+    static const char* getNmeaSentenceName(NmeaSentence type);
+    static uint16_t calcFletcherChecksum(const uint8_t* pData, size_t len); // returns CK_A << 8 | CK_B
+    static uint16_t calcFletcherChecksumScalar(const uint8_t* pData, size_t len); // reference: one byte per step
+
+    // first UBX/NMEA sync char (0xB5 or '$') in `pData`, nullptr if there is none; 16 bytes at a time on hosts w/
+    // SSE2/NEON, a word at a time elsewhere, so that the framing state machine only runs from candidates on
+    static const uint8_t* findSyncChar(const uint8_t* pData, size_t len);
+    static const uint8_t* findSyncCharSwar(const uint8_t* pData, size_t len); // a 32 bit word at a time (device)
+    static const uint8_t* findSyncCharScalar(const uint8_t* pData, size_t len); // reference: one byte per step
   private:
+    struct UbxHandlerSlot {
+      uint8_t msgClass;
+      uint8_t msgId;
+      UbxPayloadHandler handler;
+      void* pContext;
+    };
+
+    static void onCfgPrt(uint8_t msgClass, uint8_t msgId, const uint8_t* pPayload, uint16_t len, void* pContext);
+    bool writeUbxFrame(uint8_t msgClass, uint8_t msgId, const uint8_t* pPayload, uint16_t len);
+    size_t readToScorer();
+    void switchBaudRate(long speed);
+    void startAutobaudStep();
+    void lockAutobaud(uint8_t step);
+    void finishAutobaud(AutobaudState state);
     void inspect(int c);
+    void resync(int c);
+    void recordRxByte(uint8_t c);
+    void processNmeaSentence(uint8_t checksum);
+    void processUbxFrame(uint8_t ckB);
     bool recordUbxRxMessage(UbxMessageClass msgClass, UbxMessageId msgId);
     bool recordUbxTxMessage(UbxMessageClass msgClass, UbxMessageId msgId);
     bool recordUbxMessage(UbxMessageClass msgClass, UbxMessageId msgId, bool rxedNotPoll);
-    uint16_t calcFletcherChecksum(uint8_t* pData, size_t len);
 
-    bool mSeenUbx;
-    bool mSeenNmea;
+    HardwareSerial& mPort;
+
+    // status flags may be written from the RX context (receiving) and the UI context (polling) at the same time
+    std::atomic<bool> mSeenUbx;
+    std::atomic<bool> mSeenNmea;
     GpsRxState mRxState;
     unsigned int mRxCount;
-    int mRxStartupMem[RX_STARTUP_MEM_LEN];
+    std::atomic<unsigned int> mRxOverflowCount; // written from the UART driver's event task
+    unsigned int mRxOverflowsSeen; // by readBytes(), a change triggers the recorder
+    size_t mRxHighWater; // max. number of bytes found waiting in the RX buffer
+    RxRecorder mRecorder;
     UbxMessageClass mLastMsgClass;
-    uint8_t mUbxMsgStatus[UBX_MSG_NUM];
+    std::atomic<uint8_t> mUbxMsgStatus[UBX_MSG_NUM];
+    uint8_t mUbxFrame[UBX_FRAME_HEADER_LEN + UBX_MAX_PAYLOAD_LEN]; // class, ID, length and payload of the frame in reception
+    uint16_t mUbxPayloadLen;
+    uint16_t mUbxFrameIdx;
+    uint8_t mUbxCkA;
+    MetricCounter mUbxFrameCount;
+    MetricCounter mUbxChecksumErrorCount;
+    MetricCounter mUbxLengthErrorCount;
+    MetricCounter mUbxCounts[UBX_MSG_NUM + 1];
+    char mNmeaAddress[5]; // of the sentence in reception (talker ID and sentence formatter)
+    uint8_t mNmeaAddressLen;
+    uint8_t mNmeaLen;
+    uint8_t mNmeaChecksum; // XOR of the characters between '$' and '*'
+    uint8_t mNmeaChecksumRx;
+    MetricCounter mNmeaSentenceCount;
+    MetricCounter mNmeaChecksumErrorCount;
+    MetricCounter mNmeaCounts[NMEA_NUM];
+    MetricCounter mRxByteCount;
+    MetricCounter mResyncCount;
+    UbxHandlerSlot mUbxHandlers[UBX_MAX_HANDLERS];
+    uint8_t mNumUbxHandlers;
     int mRxPin;
     int mTxPin;
+
+    // baudrate detection and upshift
+    static const uint8_t CFG_PRT_UART_LEN = 20;
+    long mBaudRate;
+    AutobaudState mAutobaudState;
+    FrameScorer mScorer;
+    uint32_t mAutobaudOrder[AUTOBAUD_NUM_RATES + 1]; // the first rate plus all others
+    int16_t mAutobaudScores[AUTOBAUD_NUM_RATES + 1];
+    uint8_t mAutobaudNumRates;
+    uint8_t mAutobaudStep; // rate being tried, the one locked onto when done
+    uint8_t mAutobaudNumTried;
+    uint32_t mAutobaudDwellMs;
+    uint32_t mAutobaudStartMs;
+    uint32_t mAutobaudStepMs; // start of the current step (rate or upshift state)
+    uint32_t mAutobaudMs;
+    long mUpshiftSpeed;
+    UpshiftResult mUpshiftResult;
+    uint32_t mUpshiftThroughput;
+    std::atomic<bool> mCfgPrtRxed;
+    uint8_t mCfgPrt[CFG_PRT_UART_LEN]; // port settings of the UART, as answered by the module
 };
 
 #endif
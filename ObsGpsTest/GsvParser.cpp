@@ -0,0 +1,429 @@
+#include "GsvParser.h"
+
+namespace
+{
+  const uint8_t NO_CYCLE = 0xFF;
+  const uint8_t TALKER_INDEX_GN = GsvParser::GNSS_NUM; // cycle key for the combined talker
+  const uint8_t LAST_FIELD_IDX = 3 + 4 * GsvParser::GSV_SATS_PER_SENTENCE + 1; // header, satellites, signal ID
+
+  int8_t hexValue(char c)
+  {
+    if(c >= '0' && c <= '9')
+    {
+      return c - '0';
+    }
+    if(c >= 'A' && c <= 'F')
+    {
+      return c - 'A' + 10;
+    }
+    return -1;
+  }
+}
+
+GsvParser::GsvParser() :
+    mState(WAIT_START),
+    mAddressLen(0),
+    mChecksum(0),
+    mRxChecksum(0),
+    mTalkerSystem(GNSS_UNKNOWN),
+    mTalkerIndex(0),
+    mFieldIdx(0),
+    mFieldValue(0),
+    mFieldHasDigits(false),
+    mFieldFraction(false),
+    mFieldFirstChar('\0'),
+    mSignalId(0),
+    mNumMsgs(0),
+    mMsgNumber(0),
+    mSatsInView(0),
+    mNumSats(0),
+    mNumCycles(0),
+    mCyclesDone(0),
+    mNumExpected(0),
+    mSentenceCount(0),
+    mChecksumErrorCount(0)
+{
+}
+
+uint8_t GsvParser::encode(char c)
+{
+  if(c == '$')
+  {
+    // (re)start, whatever came before
+    mState = ADDRESS;
+    mAddressLen = 0;
+    mChecksum = 0;
+    return 0;
+  }
+
+  switch(mState)
+  {
+    case ADDRESS:
+      if(c == ',')
+      {
+        mChecksum ^= c;
+        return endAddress();
+      }
+      if(c < ' ' || c == '*')
+      {
+        mState = WAIT_START; // sentence without any fields
+      }
+      else
+      {
+        if(mAddressLen < sizeof(mAddress))
+        {
+          mAddress[mAddressLen] = c;
+        }
+        if(mAddressLen < UINT8_MAX)
+        {
+          ++mAddressLen;
+        }
+        mChecksum ^= c;
+      }
+      break;
+    case FIELDS:
+      if(c >= '0' && c <= '9')
+      {
+        if(!mFieldHasDigits && !mFieldFraction)
+        {
+          mFieldFirstChar = c;
+        }
+        if(!mFieldFraction)
+        {
+          // converted as the digits arrive; saturates instead of wrapping around
+          mFieldValue = (mFieldValue < 6553) ? mFieldValue * 10 + (c - '0') : UINT16_MAX;
+          mFieldHasDigits = true;
+        }
+      }
+      else if(c == ',')
+      {
+        endField();
+        mFieldFirstChar = '\0';
+        if(++mFieldIdx > LAST_FIELD_IDX)
+        {
+          mState = WAIT_START; // too many fields for a GSV sentence
+          break;
+        }
+      }
+      else if(c == '*')
+      {
+        endField();
+        mState = CHECKSUM_1;
+        break;
+      }
+      else if(c == '.')
+      {
+        mFieldFraction = true;
+      }
+      else if(c >= 'A' && c <= 'F' && !mFieldHasDigits && mFieldFirstChar == '\0')
+      {
+        mFieldFirstChar = c; // signal ID (hex digit) of NMEA 4.10 and newer
+      }
+      else
+      {
+        mState = WAIT_START; // garbage
+        break;
+      }
+      mChecksum ^= c;
+      break;
+    case CHECKSUM_1:
+      if(hexValue(c) < 0)
+      {
+        mState = WAIT_START;
+        break;
+      }
+      mRxChecksum = hexValue(c) << 4;
+      mState = CHECKSUM_2;
+      break;
+    case CHECKSUM_2:
+      mState = WAIT_START;
+      if(hexValue(c) < 0)
+      {
+        break;
+      }
+      mRxChecksum |= hexValue(c);
+      if(mRxChecksum != mChecksum)
+      {
+        ++mChecksumErrorCount;
+        break;
+      }
+      return endSentence();
+    default:
+      // WAIT_START, SKIP: nothing to do until the next sentence starts
+      break;
+  }
+  return 0;
+}
+
+uint8_t GsvParser::endAddress()
+{
+  if(mAddressLen != 5 || mAddress[2] != 'G' || mAddress[3] != 'S' || mAddress[4] != 'V')
+  {
+    // any other sentence ends a GSV block: the epoch is complete when there's one pending
+    mState = SKIP;
+    if(mNumCycles > 0)
+    {
+      closeEpoch();
+      return GSV_EVENT_EPOCH_BEFORE;
+    }
+    return 0;
+  }
+
+  char t0 = mAddress[0];
+  char t1 = mAddress[1];
+  if(t0 == 'G' && t1 == 'P')
+  {
+    mTalkerSystem = GNSS_GPS;
+  }
+  else if(t0 == 'G' && t1 == 'L')
+  {
+    mTalkerSystem = GNSS_GLONASS;
+  }
+  else if(t0 == 'G' && t1 == 'A')
+  {
+    mTalkerSystem = GNSS_GALILEO;
+  }
+  else if((t0 == 'G' && t1 == 'B') || (t0 == 'B' && t1 == 'D'))
+  {
+    mTalkerSystem = GNSS_BEIDOU;
+  }
+  else if((t0 == 'G' && t1 == 'Q') || (t0 == 'Q' && t1 == 'Z'))
+  {
+    mTalkerSystem = GNSS_QZSS;
+  }
+  else if(t0 == 'G' && t1 == 'N')
+  {
+    mTalkerSystem = GNSS_UNKNOWN; // system follows from the satellite ID
+  }
+  else
+  {
+    mState = SKIP; // GSV of a system we do not know (e.g. NavIC)
+    return 0;
+  }
+  mTalkerIndex = (mTalkerSystem == GNSS_UNKNOWN) ? TALKER_INDEX_GN : mTalkerSystem;
+
+  mState = FIELDS;
+  mFieldIdx = 1;
+  mFieldValue = 0;
+  mFieldHasDigits = false;
+  mFieldFraction = false;
+  mFieldFirstChar = '\0';
+  return 0;
+}
+
+void GsvParser::endField()
+{
+  uint16_t value = mFieldHasDigits ? mFieldValue : 0; // empty fields (e.g. SNR of a satellite not tracked) are 0
+
+  if(mFieldIdx == 1)
+  {
+    mNumMsgs = (value > UINT8_MAX) ? UINT8_MAX : value;
+  }
+  else if(mFieldIdx == 2)
+  {
+    mMsgNumber = (value > UINT8_MAX) ? UINT8_MAX : value;
+  }
+  else if(mFieldIdx == 3)
+  {
+    mSatsInView = (value > UINT8_MAX) ? UINT8_MAX : value;
+  }
+  else
+  {
+    uint8_t sat = (mFieldIdx - 4) / 4;
+    if(sat < GSV_SATS_PER_SENTENCE)
+    {
+      gsv_sat_t& s = mSats[sat];
+      switch((mFieldIdx - 4) % 4)
+      {
+        case 0:
+          mSatIds[sat] = value;
+          break;
+        case 1:
+          s.elevation = (value > 90) ? 90 : value;
+          break;
+        case 2:
+          s.azimuth = (value > 359) ? 0 : value;
+          break;
+        default:
+          s.snr = (value > UINT8_MAX) ? UINT8_MAX : value;
+          break;
+      }
+    }
+  }
+
+  mFieldValue = 0;
+  mFieldHasDigits = false;
+  mFieldFraction = false;
+}
+
+uint8_t GsvParser::endSentence()
+{
+  ++mSentenceCount;
+
+  // satellite records are groups of four fields; a single field left over is the signal ID
+  uint8_t numSatFields = (mFieldIdx > 3) ? mFieldIdx - 3 : 0;
+  uint8_t numRecords = numSatFields / 4;
+  mSignalId = 0;
+  if(numSatFields % 4 == 1 && hexValue(mFieldFirstChar) >= 0)
+  {
+    mSignalId = hexValue(mFieldFirstChar);
+  }
+  if(numRecords > GSV_SATS_PER_SENTENCE)
+  {
+    numRecords = GSV_SATS_PER_SENTENCE;
+  }
+
+  mNumSats = 0;
+  for(uint8_t i=0; i<numRecords; i++)
+  {
+    if(mSatIds[i] != 0 && mapSatId(mSatIds[i], &mSats[i]))
+    {
+      mSats[mNumSats++] = mSats[i];
+    }
+  }
+
+  // epoch tracking: a cycle that starts over begins a new epoch; the epoch is complete as soon as all the cycles of
+  // the previous epoch are complete (otherwise, the next sentence other than GSV completes it)
+  uint8_t events = GSV_EVENT_SENTENCE;
+  uint8_t key = (mTalkerIndex << 4) | (mSignalId & 0x0F);
+  uint8_t cycle = findCycle(key);
+  if(mMsgNumber <= 1 && cycle != NO_CYCLE)
+  {
+    closeEpoch();
+    events |= GSV_EVENT_EPOCH_BEFORE;
+    cycle = NO_CYCLE;
+  }
+  if(cycle == NO_CYCLE && mNumCycles < GSV_MAX_CYCLES)
+  {
+    cycle = mNumCycles;
+    mCycleKeys[mNumCycles++] = key;
+  }
+  if(cycle != NO_CYCLE && mMsgNumber >= mNumMsgs)
+  {
+    mCyclesDone |= 1 << cycle;
+    if(isEpochComplete())
+    {
+      closeEpoch();
+      events |= GSV_EVENT_EPOCH;
+    }
+  }
+  return events;
+}
+
+void GsvParser::closeEpoch()
+{
+  // the cycles of this epoch are the ones to wait for in the next one
+  memcpy(mExpectedKeys, mCycleKeys, mNumCycles);
+  mNumExpected = mNumCycles;
+  mNumCycles = 0;
+  mCyclesDone = 0;
+}
+
+bool GsvParser::isEpochComplete()
+{
+  if(mNumExpected == 0)
+  {
+    return false; // nothing learnt yet
+  }
+  for(uint8_t i=0; i<mNumExpected; i++)
+  {
+    uint8_t cycle = findCycle(mExpectedKeys[i]);
+    if(cycle == NO_CYCLE || !(mCyclesDone & (1 << cycle)))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint8_t GsvParser::findCycle(uint8_t key)
+{
+  for(uint8_t i=0; i<mNumCycles; i++)
+  {
+    if(mCycleKeys[i] == key)
+    {
+      return i;
+    }
+  }
+  return NO_CYCLE;
+}
+
+bool GsvParser::mapSatId(uint16_t id, gsv_sat_t* pSat)
+{
+  // talker-specific numbering (NMEA 4.10+: 1..n per system), otherwise the NMEA/u-blox ID ranges of the combined schemes
+  uint8_t system = mTalkerSystem;
+  uint16_t prn = id;
+  switch(mTalkerSystem)
+  {
+    case GNSS_GLONASS:
+      prn = (id > 64) ? id - 64 : id;
+      break;
+    case GNSS_GALILEO:
+      prn = (id > 300) ? id - 300 : id;
+      break;
+    case GNSS_BEIDOU:
+      prn = (id > 400) ? id - 400 : ((id > 200) ? id - 200 : id);
+      break;
+    case GNSS_QZSS:
+      prn = (id > 192) ? id - 192 : id;
+      break;
+    default:
+      // $GPGSV (which may contain SBAS, and QZSS with some modules) and $GNGSV
+      if(id <= 32)
+      {
+        system = GNSS_GPS;
+      }
+      else if(id <= 64)
+      {
+        system = GNSS_SBAS;
+        prn = id + 87;
+      }
+      else if(id <= 96)
+      {
+        system = GNSS_GLONASS;
+        prn = id - 64;
+      }
+      else if(id >= 120 && id <= 158)
+      {
+        system = GNSS_SBAS;
+      }
+      else if(id >= 193 && id <= 200)
+      {
+        system = GNSS_QZSS;
+        prn = id - 192;
+      }
+      else if(id >= 201 && id <= 263)
+      {
+        system = GNSS_BEIDOU;
+        prn = id - 200;
+      }
+      else if(id >= 301 && id <= 336)
+      {
+        system = GNSS_GALILEO;
+        prn = id - 300;
+      }
+      else if(id >= 401 && id <= 463)
+      {
+        system = GNSS_BEIDOU;
+        prn = id - 400;
+      }
+      else
+      {
+        return false;
+      }
+      break;
+  }
+  if(prn == 0 || prn > UINT8_MAX)
+  {
+    return false;
+  }
+  pSat->system = system;
+  pSat->prn = prn;
+  return true;
+}
+
+char GsvParser::getSystemLetter(uint8_t system)
+{
+  static const char letters[GNSS_NUM] = {'G', 'S', 'R', 'E', 'C', 'J'};
+  return (system < GNSS_NUM) ? letters[system] : '?';
+}
@@ -0,0 +1,107 @@
+#ifndef GsvParser_h
+#define GsvParser_h
+
+#include <Arduino.h>
+
+// Streaming parser for NMEA $--GSV sentences (satellites in view) of all talkers ($GPGSV, $GLGSV, $GAGSV, $GBGSV/$BDGSV,
+// $GQGSV and the combined $GNGSV): fields are converted in place as the digits arrive (no string copies, no heap),
+// a sentence only counts when its checksum matches. Satellites are identified by (system, PRN), the NMEA satellite IDs
+// of the different numbering schemes are mapped accordingly.
+// Besides the satellites of every decoded sentence, the parser reports the end of an epoch, i.e. when the GSV cycles
+// of all constellations that belong to one position fix have been received.
+
+class GsvParser {
+  public:
+    enum GnssSystem : uint8_t {
+      GNSS_GPS = 0,
+      GNSS_SBAS,
+      GNSS_GLONASS,
+      GNSS_GALILEO,
+      GNSS_BEIDOU,
+      GNSS_QZSS,
+      GNSS_NUM,
+      GNSS_UNKNOWN = 0xFF
+    };
+
+    // events returned by encode(); when several are set, handle them in this order
+    static const uint8_t GSV_EVENT_EPOCH_BEFORE = 0x01; // the epoch ended before the current sentence
+    static const uint8_t GSV_EVENT_SENTENCE = 0x02; // a GSV sentence has been decoded, see getNumSats()/getSat()
+    static const uint8_t GSV_EVENT_EPOCH = 0x04; // the epoch is complete (including the current sentence)
+
+    static const uint8_t GSV_SATS_PER_SENTENCE = 4;
+    static const uint8_t GSV_MAX_CYCLES = 8; // max. number of GSV cycles (constellation and signal) per epoch
+
+    typedef struct
+    {
+      uint8_t system; // GnssSystem
+      uint8_t prn; // within the system (SBAS: 120..158)
+      uint8_t elevation; // degrees, 0 when unknown
+      uint16_t azimuth; // degrees, 0 when unknown
+      uint8_t snr; // dBHz, 0 when not tracked
+    } gsv_sat_t;
+
+    GsvParser();
+    uint8_t encode(char c); // returns GSV_EVENT_* flags (0 most of the time)
+
+    // the sentence decoded last
+    uint8_t getNumSats() { return mNumSats; }
+    const gsv_sat_t& getSat(uint8_t i) { return mSats[i]; }
+    uint8_t getTalkerSystem() { return mTalkerSystem; } // GNSS_UNKNOWN for $GNGSV
+    uint8_t getMsgNumber() { return mMsgNumber; }
+    uint8_t getNumMsgs() { return mNumMsgs; }
+    uint8_t getSatsInView() { return mSatsInView; }
+
+    unsigned int getSentenceCount() { return mSentenceCount; }
+    unsigned int getChecksumErrorCount() { return mChecksumErrorCount; }
+
+    static char getSystemLetter(uint8_t system); // RINEX system identifier (G, S, R, E, C, J)
+  private:
+    enum ParserState : uint8_t {
+      WAIT_START,
+      ADDRESS,
+      FIELDS,
+      CHECKSUM_1,
+      CHECKSUM_2,
+      SKIP
+    };
+
+    uint8_t endAddress();
+    void endField();
+    uint8_t endSentence();
+    bool mapSatId(uint16_t id, gsv_sat_t* pSat);
+    uint8_t findCycle(uint8_t key);
+    void closeEpoch();
+    bool isEpochComplete();
+
+    ParserState mState;
+    char mAddress[5];
+    uint8_t mAddressLen;
+    uint8_t mChecksum;
+    uint8_t mRxChecksum;
+    uint8_t mTalkerSystem;
+    uint8_t mTalkerIndex; // for the cycle key (GN has no system of its own)
+    uint8_t mFieldIdx;
+    uint16_t mFieldValue;
+    bool mFieldHasDigits;
+    bool mFieldFraction; // digits after a decimal point are ignored
+    char mFieldFirstChar;
+    uint8_t mSignalId;
+    uint8_t mNumMsgs;
+    uint8_t mMsgNumber;
+    uint8_t mSatsInView;
+    uint16_t mSatIds[GSV_SATS_PER_SENTENCE]; // NMEA satellite IDs as received
+    gsv_sat_t mSats[GSV_SATS_PER_SENTENCE];
+    uint8_t mNumSats;
+
+    // epoch tracking: GSV cycles (talker and signal) seen in the current epoch and the ones seen in the previous epoch
+    uint8_t mCycleKeys[GSV_MAX_CYCLES];
+    uint8_t mNumCycles;
+    uint8_t mCyclesDone; // one bit per entry in mCycleKeys
+    uint8_t mExpectedKeys[GSV_MAX_CYCLES];
+    uint8_t mNumExpected;
+
+    unsigned int mSentenceCount;
+    unsigned int mChecksumErrorCount;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef MetricCounter_h
+#define MetricCounter_h
+
+#include <Arduino.h>
+#include <atomic>
+
+// Lock-free building blocks of the runtime metrics (see Metrics.h): each one has a single writer context (e.g. the RX
+// context), any other context may read it at any time. Counters wrap around at 2^32, readers work with differences
+// between two readings, so that only matters for intervals way longer than the ones sampled.
+
+// event or byte counter: plain load and store for the writer (no read-modify-write, which is comparably expensive on
+// the ESP32), relaxed loads for the readers
+class MetricCounter {
+  public:
+    MetricCounter() : mValue(0) {}
+
+    void add(uint32_t n = 1) { mValue.store(mValue.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+    uint32_t get() const { return mValue.load(std::memory_order_relaxed); }
+  private:
+    std::atomic<uint32_t> mValue;
+};
+
+// maximum since the last take(): the reader resets it, so both sides use compare-and-swap/exchange
+class MetricMax {
+  public:
+    MetricMax() : mValue(0) {}
+
+    void update(uint32_t value)
+    {
+      uint32_t current = mValue.load(std::memory_order_relaxed);
+      while(value > current && !mValue.compare_exchange_weak(current, value, std::memory_order_relaxed))
+      {
+      }
+    }
+    uint32_t take() { return mValue.exchange(0, std::memory_order_relaxed); }
+  private:
+    std::atomic<uint32_t> mValue;
+};
+
+// durations (e.g. of a loop() iteration): number, sum and maximum, the average follows from two readings
+class MetricDuration {
+  public:
+    void add(uint32_t us) { mCount.add(); mSumUs.add(us); mMaxUs.update(us); }
+    uint32_t getCount() const { return mCount.get(); }
+    uint32_t getSumUs() const { return mSumUs.get(); }
+    uint32_t takeMaxUs() { return mMaxUs.take(); }
+  private:
+    MetricCounter mCount;
+    MetricCounter mSumUs;
+    MetricMax mMaxUs;
+};
+
+#endif
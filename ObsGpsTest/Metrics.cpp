@@ -0,0 +1,315 @@
+#include "Metrics.h"
+
+const uint16_t GpsMetrics::JITTER_BUCKET_MS[JITTER_NUM_BUCKETS - 1] = {1, 2, 5, 10, 20, 50, 100, 200, 500};
+
+namespace
+{
+  uint16_t perSec16(uint32_t delta, uint32_t elapsedMs)
+  {
+    uint64_t rate = (elapsedMs > 0) ? (uint64_t)delta * 1000 / elapsedMs : 0;
+    return (rate > UINT16_MAX) ? UINT16_MAX : rate;
+  }
+
+  uint8_t* putU16(uint8_t* p, uint16_t value)
+  {
+    p[0] = value & 0xFF;
+    p[1] = value >> 8;
+    return p + 2;
+  }
+
+  uint8_t* putU32(uint8_t* p, uint32_t value)
+  {
+    for(uint8_t i=0; i<4; i++)
+    {
+      p[i] = (value >> (8 * i)) & 0xFF;
+    }
+    return p + 4;
+  }
+
+  uint16_t getU16(const uint8_t*& p)
+  {
+    uint16_t value = (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+    p += 2;
+    return value;
+  }
+
+  uint32_t getU32(const uint8_t*& p)
+  {
+    uint32_t value = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    p += 4;
+    return value;
+  }
+
+  const char* getUbxTypeName(uint8_t type)
+  {
+    return (type < GpsSoftwareSerial::UBX_MSG_NUM) ? GpsSoftwareSerial::UBX_MESSAGES[type].name : "UBX-other";
+  }
+}
+
+GpsMetrics::GpsMetrics(GpsSoftwareSerial& gs, uint8_t module) :
+    mGs(gs),
+    mModule(module),
+    mLastEpochUs(0),
+    mLastIntervalUs(0)
+{
+  memset(&mPrev, 0, sizeof(mPrev));
+  memset(&mLast, 0, sizeof(mLast));
+  mLast.module = module;
+}
+
+void GpsMetrics::recordEpoch(uint32_t timeUs)
+{
+  if(mEpochCount.get() > 0)
+  {
+    uint32_t intervalUs = timeUs - mLastEpochUs;
+    if(mLastIntervalUs != 0)
+    {
+      uint32_t jitterUs = (intervalUs > mLastIntervalUs) ? intervalUs - mLastIntervalUs : mLastIntervalUs - intervalUs;
+      uint8_t bucket = 0;
+      while(bucket < JITTER_NUM_BUCKETS - 1 && jitterUs >= JITTER_BUCKET_MS[bucket] * 1000UL)
+      {
+        bucket++;
+      }
+      mJitterHistogram[bucket].add();
+      mJitterMaxUs.update(jitterUs);
+    }
+    mLastIntervalUs = (intervalUs > 0) ? intervalUs : 1;
+  }
+  mLastEpochUs = timeUs;
+  mEpochCount.add();
+}
+
+void GpsMetrics::readTotals(uint32_t nowMs, metrics_totals_t* pTotals)
+{
+  pTotals->timeMs = nowMs;
+  pTotals->bytes = mGs.getRxByteCount();
+  pTotals->nmea = mGs.getNmeaSentenceCount();
+  pTotals->ubx = mGs.getUbxFrameCount();
+  pTotals->epochs = mEpochCount.get();
+  pTotals->loopCount = mLoop.getCount();
+  pTotals->loopSumUs = mLoop.getSumUs();
+  pTotals->renderCount = mRender.getCount();
+  pTotals->renderSumUs = mRender.getSumUs();
+  for(uint8_t i=0; i<GpsSoftwareSerial::NMEA_NUM; i++)
+  {
+    pTotals->nmeaByType[i] = mGs.getNmeaCount((GpsSoftwareSerial::NmeaSentence)i);
+  }
+  for(uint8_t i=0; i<NUM_UBX_TYPES; i++)
+  {
+    pTotals->ubxByType[i] = mGs.getUbxCount((GpsSoftwareSerial::UbxMessage)i);
+  }
+}
+
+void GpsMetrics::begin(uint32_t nowMs)
+{
+  readTotals(nowMs, &mPrev);
+  mLoop.takeMaxUs();
+  mRender.takeMaxUs();
+  mJitterMaxUs.take();
+}
+
+const GpsMetrics::metrics_record_t& GpsMetrics::sample(uint32_t nowMs)
+{
+  metrics_totals_t totals;
+  readTotals(nowMs, &totals);
+  uint32_t elapsedMs = nowMs - mPrev.timeMs;
+
+  mLast.timeMs = nowMs;
+  mLast.bytesPerSec = (elapsedMs > 0) ? (uint64_t)(totals.bytes - mPrev.bytes) * 1000 / elapsedMs : 0;
+  mLast.nmeaPerSec = perSec16(totals.nmea - mPrev.nmea, elapsedMs);
+  mLast.ubxPerSec = perSec16(totals.ubx - mPrev.ubx, elapsedMs);
+  mLast.epochsPerSec = perSec16(totals.epochs - mPrev.epochs, elapsedMs);
+
+  mLast.nmeaChecksumErrors = mGs.getNmeaChecksumErrorCount();
+  mLast.ubxChecksumErrors = mGs.getUbxChecksumErrorCount();
+  mLast.ubxLengthErrors = mGs.getUbxLengthErrorCount();
+  mLast.resyncs = mGs.getResyncCount();
+  mLast.overflows = mGs.getRxOverflowCount();
+
+  uint32_t loopCount = totals.loopCount - mPrev.loopCount;
+  uint32_t renderCount = totals.renderCount - mPrev.renderCount;
+  mLast.loopAvgUs = (loopCount > 0) ? (totals.loopSumUs - mPrev.loopSumUs) / loopCount : 0;
+  mLast.loopMaxUs = mLoop.takeMaxUs();
+  mLast.renderAvgUs = (renderCount > 0) ? (totals.renderSumUs - mPrev.renderSumUs) / renderCount : 0;
+  mLast.renderMaxUs = mRender.takeMaxUs();
+  mLast.jitterMaxUs = mJitterMaxUs.take();
+  for(uint8_t i=0; i<JITTER_NUM_BUCKETS; i++)
+  {
+    mLast.jitterHistogram[i] = mJitterHistogram[i].get();
+  }
+
+  for(uint8_t i=0; i<GpsSoftwareSerial::NMEA_NUM; i++)
+  {
+    mLast.nmeaPerSecByType[i] = perSec16(totals.nmeaByType[i] - mPrev.nmeaByType[i], elapsedMs);
+  }
+  for(uint8_t i=0; i<NUM_UBX_TYPES; i++)
+  {
+    mLast.ubxPerSecByType[i] = perSec16(totals.ubxByType[i] - mPrev.ubxByType[i], elapsedMs);
+  }
+
+  mPrev = totals;
+  return mLast;
+}
+
+void GpsMetrics::printCsvHeader(Print& out)
+{
+  out.print("MH,time_ms,bytes/s,nmea/s,ubx/s,epochs/s,nmea_ck_err,ubx_ck_err,ubx_len_err,resyncs,overflows,"
+            "loop_avg_us,loop_max_us,render_avg_us,render_max_us,jitter_max_us");
+  for(uint8_t i=0; i<JITTER_NUM_BUCKETS - 1; i++)
+  {
+    out.print(",jitter<");
+    out.print(JITTER_BUCKET_MS[i]);
+    out.print("ms");
+  }
+  out.print(",jitter>=");
+  out.print(JITTER_BUCKET_MS[JITTER_NUM_BUCKETS - 2]);
+  out.println("ms");
+}
+
+void GpsMetrics::printCsv(Print& out, const metrics_record_t& record)
+{
+  const uint32_t values[] = {
+    record.timeMs, record.bytesPerSec, record.nmeaPerSec, record.ubxPerSec, record.epochsPerSec,
+    record.nmeaChecksumErrors, record.ubxChecksumErrors, record.ubxLengthErrors, record.resyncs, record.overflows,
+    record.loopAvgUs, record.loopMaxUs, record.renderAvgUs, record.renderMaxUs, record.jitterMaxUs
+  };
+  out.print("M");
+  if(record.module > 0)
+  {
+    out.print(record.module);
+  }
+  for(uint8_t i=0; i<sizeof(values) / sizeof(values[0]); i++)
+  {
+    out.print(",");
+    out.print((unsigned long)values[i]);
+  }
+  for(uint8_t i=0; i<JITTER_NUM_BUCKETS; i++)
+  {
+    out.print(",");
+    out.print((unsigned long)record.jitterHistogram[i]);
+  }
+  out.println();
+
+  // the rates by type, only the ones that came in during the interval
+  out.print("MT");
+  if(record.module > 0)
+  {
+    out.print(record.module);
+  }
+  out.print(",");
+  out.print((unsigned long)record.timeMs);
+  for(uint8_t i=0; i<GpsSoftwareSerial::NMEA_NUM; i++)
+  {
+    if(record.nmeaPerSecByType[i] > 0)
+    {
+      out.print(",");
+      out.print(GpsSoftwareSerial::getNmeaSentenceName((GpsSoftwareSerial::NmeaSentence)i));
+      out.print(":");
+      out.print(record.nmeaPerSecByType[i]);
+    }
+  }
+  for(uint8_t i=0; i<NUM_UBX_TYPES; i++)
+  {
+    if(record.ubxPerSecByType[i] > 0)
+    {
+      out.print(",");
+      out.print(getUbxTypeName(i));
+      out.print(":");
+      out.print(record.ubxPerSecByType[i]);
+    }
+  }
+  out.println();
+}
+
+size_t GpsMetrics::encodeBinary(const metrics_record_t& record, uint8_t* pBuf)
+{
+  uint8_t* p = pBuf;
+  *p++ = BINARY_SYNC_1;
+  *p++ = BINARY_SYNC_2;
+  *p++ = BINARY_VERSION;
+  p = putU16(p, BINARY_PAYLOAD_LEN);
+  *p++ = record.module;
+  p = putU32(p, record.timeMs);
+  p = putU32(p, record.bytesPerSec);
+  p = putU16(p, record.nmeaPerSec);
+  p = putU16(p, record.ubxPerSec);
+  p = putU16(p, record.epochsPerSec);
+  p = putU32(p, record.nmeaChecksumErrors);
+  p = putU32(p, record.ubxChecksumErrors);
+  p = putU32(p, record.ubxLengthErrors);
+  p = putU32(p, record.resyncs);
+  p = putU32(p, record.overflows);
+  p = putU32(p, record.loopAvgUs);
+  p = putU32(p, record.loopMaxUs);
+  p = putU32(p, record.renderAvgUs);
+  p = putU32(p, record.renderMaxUs);
+  p = putU32(p, record.jitterMaxUs);
+  for(uint8_t i=0; i<JITTER_NUM_BUCKETS; i++)
+  {
+    p = putU32(p, record.jitterHistogram[i]);
+  }
+  for(uint8_t i=0; i<GpsSoftwareSerial::NMEA_NUM; i++)
+  {
+    p = putU16(p, record.nmeaPerSecByType[i]);
+  }
+  for(uint8_t i=0; i<NUM_UBX_TYPES; i++)
+  {
+    p = putU16(p, record.ubxPerSecByType[i]);
+  }
+  // same checksum as UBX frames, over version, length and payload
+  uint16_t checksum = GpsSoftwareSerial::calcFletcherChecksum(&pBuf[2], p - &pBuf[2]);
+  *p++ = checksum >> 8;
+  *p++ = checksum & 0xFF;
+  return p - pBuf;
+}
+
+bool GpsMetrics::decodeBinary(const uint8_t* pBuf, size_t len, metrics_record_t* pRecord)
+{
+  if(len < BINARY_LEN || pBuf[0] != BINARY_SYNC_1 || pBuf[1] != BINARY_SYNC_2 || pBuf[2] != BINARY_VERSION ||
+     ((uint16_t)pBuf[3] | ((uint16_t)pBuf[4] << 8)) != BINARY_PAYLOAD_LEN)
+  {
+    return false;
+  }
+  uint16_t checksum = GpsSoftwareSerial::calcFletcherChecksum(&pBuf[2], BINARY_LEN - 4);
+  if(pBuf[BINARY_LEN - 2] != (checksum >> 8) || pBuf[BINARY_LEN - 1] != (checksum & 0xFF))
+  {
+    return false;
+  }
+
+  const uint8_t* p = &pBuf[5];
+  pRecord->module = *p++;
+  pRecord->timeMs = getU32(p);
+  pRecord->bytesPerSec = getU32(p);
+  pRecord->nmeaPerSec = getU16(p);
+  pRecord->ubxPerSec = getU16(p);
+  pRecord->epochsPerSec = getU16(p);
+  pRecord->nmeaChecksumErrors = getU32(p);
+  pRecord->ubxChecksumErrors = getU32(p);
+  pRecord->ubxLengthErrors = getU32(p);
+  pRecord->resyncs = getU32(p);
+  pRecord->overflows = getU32(p);
+  pRecord->loopAvgUs = getU32(p);
+  pRecord->loopMaxUs = getU32(p);
+  pRecord->renderAvgUs = getU32(p);
+  pRecord->renderMaxUs = getU32(p);
+  pRecord->jitterMaxUs = getU32(p);
+  for(uint8_t i=0; i<JITTER_NUM_BUCKETS; i++)
+  {
+    pRecord->jitterHistogram[i] = getU32(p);
+  }
+  for(uint8_t i=0; i<GpsSoftwareSerial::NMEA_NUM; i++)
+  {
+    pRecord->nmeaPerSecByType[i] = getU16(p);
+  }
+  for(uint8_t i=0; i<NUM_UBX_TYPES; i++)
+  {
+    pRecord->ubxPerSecByType[i] = getU16(p);
+  }
+  return true;
+}
+
+void GpsMetrics::writeBinary(Print& out, const metrics_record_t& record)
+{
+  uint8_t buf[BINARY_LEN];
+  out.write(buf, encodeBinary(record, buf));
+}
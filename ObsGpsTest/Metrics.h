@@ -0,0 +1,108 @@
+#ifndef Metrics_h
+#define Metrics_h
+
+#include <Arduino.h>
+#include "GpsSerial.h"
+#include "MetricCounter.h"
+
+// Runtime metrics of the GPS test: the protocol counters of the GPS serial (bytes, NMEA sentences and UBX frames by
+// type, checksum errors, framing resyncs, UART overflows) plus what the sketch records here (epochs and their jitter,
+// loop() and render times). All counters are lock-free with a single writer each (see MetricCounter.h); sample() takes
+// the differences since the sample before and turns them into a record of rates per second, averages and maxima
+// (errors and the jitter histogram are totals since startup). A record can be printed as CSV or sent as a binary
+// frame ("0xA5 'M'", version, length, payload and a UBX-style Fletcher checksum, all little endian), which
+// host/build/metrics_dump turns back into the CSV lines.
+//
+// The epoch jitter is the difference between two consecutive epoch intervals (the time between the ends of two
+// epochs as decoded, i.e. including the delays of the reading side), histogram buckets up to JITTER_BUCKET_MS each.
+
+class GpsMetrics {
+  public:
+    static const uint8_t JITTER_NUM_BUCKETS = 10;
+    static const uint16_t JITTER_BUCKET_MS[JITTER_NUM_BUCKETS - 1]; // upper bounds (exclusive), the last one is open
+    static const uint8_t NUM_UBX_TYPES = GpsSoftwareSerial::UBX_MSG_NUM + 1; // the registry plus all others
+    static const uint8_t BINARY_SYNC_1 = 0xA5;
+    static const uint8_t BINARY_SYNC_2 = 'M';
+    static const uint8_t BINARY_VERSION = 2;
+    static const uint16_t BINARY_PAYLOAD_LEN = 1 + 4 + 4 + 3 * 2 + 5 * 4 + 5 * 4 + JITTER_NUM_BUCKETS * 4 +
+                                               GpsSoftwareSerial::NMEA_NUM * 2 + NUM_UBX_TYPES * 2;
+    static const uint16_t BINARY_FRAMING_LEN = 7; // sync chars, version, length, checksum
+    static const uint16_t BINARY_LEN = BINARY_FRAMING_LEN + BINARY_PAYLOAD_LEN;
+
+    typedef struct
+    {
+      uint8_t module; // of the GPS module (1...) when several are tested at once, otherwise 0
+      uint32_t timeMs; // millis() of the sample
+      // rates during the interval (per second)
+      uint32_t bytesPerSec;
+      uint16_t nmeaPerSec; // sentences w/ a valid checksum
+      uint16_t ubxPerSec; // frames w/ a valid checksum
+      uint16_t epochsPerSec;
+      // totals since startup
+      uint32_t nmeaChecksumErrors;
+      uint32_t ubxChecksumErrors;
+      uint32_t ubxLengthErrors;
+      uint32_t resyncs;
+      uint32_t overflows;
+      // durations during the interval (0 when there were none)
+      uint32_t loopAvgUs;
+      uint32_t loopMaxUs;
+      uint32_t renderAvgUs;
+      uint32_t renderMaxUs;
+      uint32_t jitterMaxUs;
+      uint32_t jitterHistogram[JITTER_NUM_BUCKETS]; // totals since startup
+      uint16_t nmeaPerSecByType[GpsSoftwareSerial::NMEA_NUM];
+      uint16_t ubxPerSecByType[NUM_UBX_TYPES];
+    } metrics_record_t;
+
+    explicit GpsMetrics(GpsSoftwareSerial& gs, uint8_t module = 0);
+
+    // writers (one context each)
+    void recordEpoch(uint32_t timeUs); // an epoch has been decoded completely (RX context)
+    void recordLoop(uint32_t us) { mLoop.add(us); }
+    void recordRender(uint32_t us) { mRender.add(us); }
+
+    // reader: the first sample's interval starts with begin()
+    void begin(uint32_t nowMs);
+    const metrics_record_t& sample(uint32_t nowMs);
+    const metrics_record_t& getLast() { return mLast; }
+
+    static void printCsvHeader(Print& out);
+    // the record line, then the rates by type ("M"/"MT", followed by the module number when it's not 0)
+    static void printCsv(Print& out, const metrics_record_t& record);
+    static size_t encodeBinary(const metrics_record_t& record, uint8_t* pBuf); // BINARY_LEN bytes
+    static bool decodeBinary(const uint8_t* pBuf, size_t len, metrics_record_t* pRecord); // a complete frame
+    static void writeBinary(Print& out, const metrics_record_t& record);
+  private:
+    // totals at the sample before
+    typedef struct
+    {
+      uint32_t timeMs;
+      uint32_t bytes;
+      uint32_t nmea;
+      uint32_t ubx;
+      uint32_t epochs;
+      uint32_t loopCount;
+      uint32_t loopSumUs;
+      uint32_t renderCount;
+      uint32_t renderSumUs;
+      uint32_t nmeaByType[GpsSoftwareSerial::NMEA_NUM];
+      uint32_t ubxByType[NUM_UBX_TYPES];
+    } metrics_totals_t;
+
+    void readTotals(uint32_t nowMs, metrics_totals_t* pTotals);
+
+    GpsSoftwareSerial& mGs;
+    uint8_t mModule;
+    MetricCounter mEpochCount;
+    MetricCounter mJitterHistogram[JITTER_NUM_BUCKETS];
+    MetricMax mJitterMaxUs;
+    MetricDuration mLoop;
+    MetricDuration mRender;
+    uint32_t mLastEpochUs; // writer side of recordEpoch()
+    uint32_t mLastIntervalUs; // 0: none yet
+    metrics_totals_t mPrev;
+    metrics_record_t mLast;
+};
+
+#endif
@@ -11,35 +11,186 @@
 #include <TinyGPSPlus.h>
 #include "GpsSerial.h"
 #include "ObsLogo.h"
+#include "Benchmark.h"
+#include "GsvParser.h"
+#include "SatStore.h"
+#include "DisplayDiff.h"
+#include "RenderCache.h"
+#include "Scheduler.h"
+#include "Button.h"
+#include "UbxEngine.h"
+#include "UbxNav.h"
+#include "Metrics.h"
+#include "TestPlan.h"
+#include "Ttff.h"
+
+// Build configuration
+// -------------------------------------------------------------------------------------------
+// Pipeline mode: a high-priority RX task on core 0 drains the GPS serial and decodes NMEA/UBX, complete GSV cycles
+// are handed over to the UI (the Arduino loop task on core 1) through the triple-buffered satellite store;
+// otherwise everything runs in loop() one after another
+#ifndef GPS_PIPELINE_MODE
+#define GPS_PIPELINE_MODE 0
+#endif
+
+// Benchmark mode: at the end of setup(), time the decode, sort and render hot paths over synthetic data and print the
+// results (in CPU cycles) on the debug serial; the test continues normally afterwards
+#ifndef GPS_BENCHMARK_MODE
+#define GPS_BENCHMARK_MODE 0
+#endif
+
+// TTFF mode (u-blox modules): instead of the pass/fail test, restart the module with UBX CFG-RST (cold, warm, hot;
+// see TtffConfig) several times and measure the time to the first fix of each run (see Ttff.h); the runs and min/
+// median/max per start type go to the debug serial and are shown on the TTFF screen (in place of the constellation view)
+#ifndef GPS_TTFF_MODE
+#define GPS_TTFF_MODE 0
+#endif
+
+// Display: hardware I2C (the ESP32's I2C peripheral, 400 kHz) instead of software I2C (bit-banged by the CPU);
+// with DISPLAY_ASYNC, frames are transferred by a task of their own while the next one is prepared
+#ifndef DISPLAY_HW_I2C
+#define DISPLAY_HW_I2C 1
+#endif
+#ifndef DISPLAY_ASYNC
+#define DISPLAY_ASYNC 1
+#endif
+
+// Upshift: once the GPS module's baudrate has been detected, move the module to this (higher) baudrate with UBX CFG-PRT
+// (taken back when there are no valid frames at the new rate); 0 keeps the detected rate
+#ifndef GPS_UPSHIFT_BAUD
+#define GPS_UPSHIFT_BAUD 0
+#endif
+
+// UBX navigation mode (u-blox modules): configure the module to send NAV-SVINFO, NAV-TIMEUTC and NAV-SOL instead of the
+// NMEA sentences and take the satellites and the time from there, at the highest rate the baudrate allows (see UbxNav.h);
+// when the module does not take the configuration, NMEA stays on and is decoded as before
+#ifndef GPS_UBX_NAV_MODE
+#define GPS_UBX_NAV_MODE 0
+#endif
+
+// RX capture spill: what drops out of the RX recorder's ring is kept in PSRAM (1, if there is any) or in the flash's
+// SPIFFS partition (2, overwriting it; erasing stalls the CPU, so better at low baudrates), 0: the ring only
+#ifndef GPS_RX_SPILL
+#define GPS_RX_SPILL 0
+#endif
+
+// Metrics output: every MetricsIntervalMs, the runtime metrics (rates, errors, jitter, loop and render times, see
+// Metrics.h) go to the debug serial as CSV lines (1) or as binary records (2, see host/build/metrics_dump); 0: only
+// the metrics page on the display
+#ifndef GPS_METRICS_OUTPUT
+#define GPS_METRICS_OUTPUT 1
+#endif
+
+// Modules tested at once (up to 3): each one on a UART of its own (see GpsPorts) w/ its own decoders, metrics and test
+// result; the constellation view and the status pages show one module at a time (the button switches over after the
+// metrics page), the result screen sums up all of them. The third module needs UART0, i.e. a board whose debug serial
+// is its USB CDC port.
+#ifndef GPS_NUM_MODULES
+#define GPS_NUM_MODULES 1
+#endif
+
+#if GPS_NUM_MODULES < 1 || GPS_NUM_MODULES > 3
+#error "GPS_NUM_MODULES: 1 to 3 modules (one per UART)"
+#elif GPS_NUM_MODULES > 2 && !ARDUINO_USB_CDC_ON_BOOT
+#error "GPS_NUM_MODULES: the third module needs UART0, which is the debug serial on this board"
+#endif
 
 // Type definitions
 // -------------------------------------------------------------------------------------------
+typedef SatStore::sat_epoch_t sat_epoch_t; // satellites seen during one complete GSV cycle, ranked by signal strength
+
 typedef struct
 {
-  int no;
-  int elevation;
-  int azimuth;
-  int snr;
-  bool active;
-} satellite_t;
+  uint8_t uartNum;
+  uint8_t rxPin; // the GPS module's TX signal
+  uint8_t txPin; // the GPS module's RX signal
+} gps_port_t;
+
+typedef enum
+{
+  PHASE_STARTUP = 0, // listening to what the GPS module sends after power-up (counted, not decoded), no UI yet
+  PHASE_RUNNING, // decoding and drawing while the test plan's checks are pending
+  PHASE_RESULT // the test plan has a verdict: the result screen stays (and is kept up to date) until reset
+} test_phase_t;
 
 // Hardware-related definitions
 // -------------------------------------------------------------------------------------------
 // Make sure that the button pin is pulled-down via a hardware resistor (as a pressed button will connect to VCC on the OBS display module);
 // otherwise the input pin will float around and the display may show garbage.
 static const int ButtonPin = 2; // OBS' display module's button pin (w/ hardware pull-down resistor)
-static const int GpsSerialRxPin = 16; // OBS' TX_NEO6M signal: IO16
-static const int GpsSerialTxPin = 17; // OBS' RX_NEO6M signal: IO17
-static const uint32_t GpsSerialBaudSlow = 9600;
-static const uint32_t GpsSerialBaudFast = 115200;
+static const uint32_t ButtonDebounceUs = 20000;
+static const gps_port_t GpsPorts[] = {
+  {/*uartNum=*/2, /*rxPin=*/16, /*txPin=*/17}, // OBS' TX_NEO6M/RX_NEO6M signals: IO16/IO17
+  {/*uartNum=*/1, /*rxPin=*/25, /*txPin=*/26}, // further modules: wired on the test jig (any free GPIOs will do)
+  {/*uartNum=*/0, /*rxPin=*/32, /*txPin=*/33}
+};
+static const uint32_t GpsSerialBaudSlow = 9600; // the baudrate detection starts with this one...
+static const uint32_t GpsSerialBaudFast = 115200; // ...or with this one when the button is pressed during power-up
+static const uint32_t AutobaudDwellMs = 1100; // per baudrate tried: a 1 Hz module sends its sentences within that time
+static const uint8_t UbxMsgsPerPage = 6; // number of UBX messages shown on one status page
+static const uint8_t UbxPollWindow = 8; // poll requests outstanding at once (the rest is queued)
+static const uint32_t UbxPollTimeoutMs = 1000; // per attempt
+static const uint8_t UbxPollRetries = 1; // attempts after the first one before a poll request counts as unanswered
+static const uint8_t UbxNavMaxRateHz = 10; // UBX navigation mode: epochs per second, if the baudrate allows
+static const size_t RxRecorderSize = 4096; // raw RX capture ring (the latest bytes received from the GPS module)
+static const size_t RxRecorderPostTrigger = 1024; // bytes still recorded after an error before the capture freezes
+static const uint8_t RxRecorderTriggers = RxRecorder::TRIGGER_OVERFLOW | RxRecorder::TRIGGER_UBX_CHECKSUM |
+                                          RxRecorder::TRIGGER_UBX_LENGTH;
+static const uint32_t MetricsIntervalMs = 1000; // sampling (rates are per second all the same)
+#if GPS_RX_SPILL == 1
+static const size_t RxSpillPsramSize = 1024 * 1024;
+#elif GPS_RX_SPILL == 2
+static const char RxSpillPartition[] = "spiffs";
+#endif
+
+// Test flow timing
+// -------------------------------------------------------------------------------------------
+static const uint32_t StartupListenMs = 2000; // after power-up, before the display is set up
+static const uint8_t EpochDownsampling = 1; // every n-th epoch (of each module) is published, i.e. drawn
+static const uint32_t TestCheckIntervalMs = 100; // the test plan's checks are evaluated this often
+static const uint32_t ResultScreenRefreshMs = 500; // once there is a verdict
+static const uint32_t LongPressMs = 1000; // holding the button that long polls UBX messages instead of switching screens
+static const uint32_t TtffStepMs = 100; // TTFF mode: resets, timeouts and the satellites in view are checked this often
+static const uint32_t TtffScreenRefreshMs = 1000;
+
+// TTFF runs (GPS_TTFF_MODE): each start type in turn, the module stays fixed for `settleMs` before the next reset
+static const TtffBench::ttff_config_t TtffConfig = {
+  /*startTypes=*/TtffBench::START_MASK_ALL, // cold, warm and hot
+  /*runsPerType=*/3, // up to TtffBench::MAX_RUNS
+  /*timeoutMs=*/300000, // a run without a fix by then fails
+  /*settleMs=*/30000 // ephemerides for the next (hot) start
+};
+
+// Test criteria
+// -------------------------------------------------------------------------------------------
+// The test ends as soon as all checks have passed or one has failed (see TestPlan.h), the timeouts count from power-up
+static const TestPlan::test_criteria_t TestCriteria = {
+  /*timeoutMs=*/30000, // checks still pending then fail
+  /*linkTimeoutMs=*/6000, // valid NMEA sentences or UBX frames by then
+  /*minNmeaSentences=*/10, // 0: no NMEA check
+  /*minSats=*/4, // satellites w/ at least `minSnr` in one epoch (0: no satellite check)
+  /*minSnr=*/25, // dB-Hz
+  /*minUbxAnswered=*/1, // UBX polls answered (0: no UBX check, e.g. for NMEA-only modules)
+  /*requireFix=*/false,
+  /*maxErrors=*/10 // NMEA and UBX checksum errors, UBX length errors and RX overflows (TestPlan::NO_LIMIT: no check)
+};
 
 // Display and UI related definitions and declarations
 // -------------------------------------------------------------------------------------------
 
 // Choosing a specific U8g2 constructor for our display
 // (The complete list is available here: https://github.com/olikraus/u8g2/wiki/u8g2setupcpp)
+// Note: the HW_I2C constructors take the reset pin first (unlike SW_I2C), passing the pins in SW_I2C order was
+// the reason why hardware I2C "did not seem to work".
+#if DISPLAY_HW_I2C
+U8G2_SSD1306_128X64_NONAME_F_HW_I2C u8g2(U8G2_R0, /* reset=*/ U8X8_PIN_NONE, /* clock=*/ SCL, /* data=*/ SDA);
+#else
 U8G2_SSD1306_128X64_NONAME_F_SW_I2C u8g2(U8G2_R0, /* clock=*/ SCL, /* data=*/ SDA, /* reset=*/ U8X8_PIN_NONE);
-//U8G2_SSD1306_128X64_NONAME_F_HW_I2C u8g2(U8G2_R0, /* clock=*/ SCL, /* data=*/ SDA, /* reset=*/ U8X8_PIN_NONE); // does not seem to work
+#endif
+DisplayDiff displayDiff(u8g2); // frames are sent with this one: only the tiles that changed go over the (slow) bus
+static const uint32_t DisplayI2cClock = 400000; // SSD1306 fast mode (hardware I2C only)
+static const uint8_t DisplayTaskPriority = 1; // same as the loop task; it waits for the bus most of the time
+static const int8_t DisplayTaskCore = 0; // next to the RX task (pipeline mode), the loop task runs on the other core
 
 const uint8_t *smallTextFont = u8g2_font_chikita_tn; // info from u8g2: The FontStruction "Chikita" (http://fontstruct.com/Ffontstructions/show/52325) by "southernmedia" is licensed under a Creative Commons Attribution Share Alike license
 const uint8_t *textFont = u8g2_font_chikita_tf;
@@ -52,60 +203,197 @@ const uint8_t *glyphFont5 = u8g2_font_unifont_t_animals; // https://savannah.gnu
 // GPS related definitions and declarations
 // -------------------------------------------------------------------------------------------
 
-GpsSoftwareSerial gs(GpsSerialRxPin, GpsSerialTxPin); // serial connection to the GPS device (which has some understanding about the UBX and NMEA protocols)
-unsigned int gsStartupRxCount = 0; // counter for received bytes from the GPS serial
-bool fastBaudRate = false;
-
-static const int MAX_SATELLITES = 32;
-TinyGPSPlus gps; // used for NMEA decoding
-TinyGPSCustom totalGPGSVMessages(gps, "GPGSV", 1); // $GPGSV sentence, first element
-TinyGPSCustom messageNumber(gps, "GPGSV", 2);      // $GPGSV sentence, second element
-TinyGPSCustom gpsSatNumber[4];
-TinyGPSCustom gpsElevation[4];
-TinyGPSCustom gpsAzimuth[4];
-TinyGPSCustom gpsSnr[4];
+#if GPS_UBX_NAV_MODE
+typedef enum
+{
+  UBX_NAV_CFG_OUTPUT = 0, // NAV-SVINFO/-TIMEUTC/-SOL on
+  UBX_NAV_CFG_NMEA_OFF,
+  UBX_NAV_CFG_WAIT_CHANNELS, // for the first NAV-SVINFO, which tells the number of channels
+  UBX_NAV_CFG_RATE,
+  UBX_NAV_CFG_DONE,
+  UBX_NAV_CFG_FAILED // the module did not take (all of) a step, the ones after it are left out
+} ubx_nav_cfg_step_t;
+#endif
+
+// everything that is kept per GPS module: its serial connection, decoders, metrics, UBX requests and test results
+// (one of these per module tested, see GPS_NUM_MODULES)
+struct GpsModule
+{
+  GpsModule(uint8_t moduleNum, const gps_port_t& port) :
+      num(moduleNum),
+      gs(port.uartNum, port.rxPin, port.txPin),
+      startupRxCount(0),
+      started(false),
+      metrics(gs, (GPS_NUM_MODULES > 1) ? moduleNum : 0),
+      ggaQualityGp(gps, "GPGGA", 6),
+      ggaQualityGn(gps, "GNGGA", 6),
+      gsaModeGp(gps, "GPGSA", 2),
+      gsaModeGn(gps, "GNGSA", 2),
+      nmeaFixQuality(0),
+      nmeaFixMode(0),
+      pEpoch(nullptr),
+      downsampleCounter(EpochDownsampling - 1),
+      parsedNmeaDataAvailable(false),
+      gsvCycleCount(0),
+      fixAvailable(false),
+      ubxEngine(gs),
+      onUbxPollsDone(nullptr),
+      ubxPollStartMs(0),
+      strongSats(0),
+      testPollsDone(false),
+      testPollsAnswered(0)
+#if GPS_UBX_NAV_MODE
+      ,
+      ubxNavCfgStep(UBX_NAV_CFG_OUTPUT),
+      ubxNavCfgNumIds(0)
+#endif
+  {
+  }
 
-static satellite_t sats[MAX_SATELLITES]; // sorted by satellite number
-static satellite_t sortedSats[MAX_SATELLITES]; // sorted by signal strength
+  uint8_t num; // 1...
+  GpsSoftwareSerial gs; // serial connection to the GPS device (which has some understanding about the UBX and NMEA protocols)
+  unsigned int startupRxCount; // counter for received bytes from the GPS serial
+  std::atomic<bool> started; // its baudrate detection is done and its test runs (see startModule())
+  uint8_t rxRecorderMem[RxRecorderSize];
+  GpsMetrics metrics; // protocol and runtime metrics (sampled by a scheduled task)
+
+  TinyGPSPlus gps; // used for NMEA decoding (time, fix)
+  TinyGPSCustom ggaQualityGp; // fix quality (0: none) of GPS-only...
+  TinyGPSCustom ggaQualityGn; // ...and multi-GNSS modules
+  TinyGPSCustom gsaModeGp; // fix dimension (1: none, 2: 2D, 3: 3D)
+  TinyGPSCustom gsaModeGn;
+  uint8_t nmeaFixQuality; // of the latest GGA
+  uint8_t nmeaFixMode; // of the latest GSA
+  GsvParser gsvParser; // satellites in view ($--GSV sentences of all constellations)
+  SatStore satStore; // satellites of the epoch being decoded and the latest complete one
+  const sat_epoch_t* pEpoch; // the latest complete GSV cycle (acquired from `satStore`)
+  uint8_t downsampleCounter; // epochs since the last one published (see publishEpoch())
+  std::atomic<bool> parsedNmeaDataAvailable; // satellites decoded (from NMEA, or UBX in UBX navigation mode)
+  std::atomic<unsigned int> gsvCycleCount; // number of complete GSV epochs (cycles of all constellations) decoded
+  std::atomic<bool> fixAvailable; // the module reports a position fix (NMEA, or NAV-SOL in UBX navigation mode)
+
+  UbxEngine ubxEngine; // UBX poll requests: sending, matching the answers, time-outs
+  void (*onUbxPollsDone)(GpsModule& m); // run from loop() once all poll requests have been answered or given up
+  uint32_t ubxPollStartMs;
+
+  TestPlan testPlan; // pass/fail checks, from power-up
+  uint8_t strongSats; // satellites w/ at least TestCriteria.minSnr in the latest epoch
+  bool testPollsDone; // all UBX polls of the test are through
+  uint8_t testPollsAnswered;
+
+#if GPS_TTFF_MODE
+  TtffBench ttff; // restarts and their time to the first fix
+  uint8_t ttffResetId; // CFG-RST of the current run until it has been sent
+#endif
+
+#if GPS_UBX_NAV_MODE
+  UbxNavDecoder ubxNav; // NAV-SVINFO/-TIMEUTC/-SOL into the satellite store (in the RX context)
+  ubx_nav_cfg_step_t ubxNavCfgStep;
+  uint8_t ubxNavCfgIds[UbxNavDecoder::MAX_CONFIG_REQUESTS]; // requests of the current step
+  uint8_t ubxNavCfgNumIds;
+#endif
+};
+
+static GpsModule modules[GPS_NUM_MODULES] = {
+  {1, GpsPorts[0]},
+#if GPS_NUM_MODULES > 1
+  {2, GpsPorts[1]},
+#endif
+#if GPS_NUM_MODULES > 2
+  {3, GpsPorts[2]},
+#endif
+};
+bool fastBaudRate = false; // the (first) module talks at the fast baudrate (or faster)
+static RxSpill* pRxSpill = nullptr; // of the first module's RX recorder
+
+static Scheduler scheduler; // timed steps of the test flow, run from loop()
+static test_phase_t testPhase = PHASE_STARTUP;
+static Deadline startupListen; // end of PHASE_STARTUP
+static uint8_t testTaskId = Scheduler::NO_TASK;
+
+Button button(ButtonPin, ButtonDebounceUs); // runtime button events (the level at power-up selects the first baudrate tried)
+static int8_t uiStatusPage = -1; // page chosen with the button: UBX status page, the metrics page after the last one
+                                 // (see isMetricsPage()) or -1: the constellation view (the result screen once
+                                 // there is a verdict)
+static uint8_t uiModule = 0; // index of the module whose constellation view and pages are shown
+
+#if GPS_PIPELINE_MODE
+static const uint32_t RxTaskStackSize = 4096;
+static const UBaseType_t RxTaskPriority = configMAX_PRIORITIES - 2; // well above the loop task
+static const BaseType_t RxTaskCore = 0; // the loop task runs on the other core (ARDUINO_RUNNING_CORE)
+#endif
 
 // Local function defintions (no declarations due to laziness)
 // -------------------------------------------------------------------------------------------
 
 void drawSatAbsolute(uint8_t x, uint8_t y, bool filled = false)
 {
-  u8g2.drawLine(x - 4, y, x - 2, y);
-  u8g2.drawLine(x + 2, y, x + 4, y);
-  u8g2.drawLine(x - 4, y - 2, x - 4, y + 2);
-  u8g2.drawLine(x + 4, y - 2, x + 4, y + 2);
-  u8g2.drawLine(x - 1, y - 2, x + 1, y - 2);
-  u8g2.drawLine(x - 1, y + 2, x + 1, y + 2);
-  u8g2.drawLine(x - 2, y - 1, x - 2, y + 1);
-  u8g2.drawLine(x + 2, y - 1, x + 2, y + 1);
-  if (filled)
-  {
-    u8g2.drawBox(x - 1, y - 1, 3, 3);
-  }
+  renderSatIcon(u8g2, x, y, filled); // pre-rasterized, ORed into the frame buffer
+}
+
+// Static layers: the parts of the screens that never change, rasterized once (see RenderCache.h)
+// -------------------------------------------------------------------------------------------
+static const uint8_t SkyRadius = 24;
+static const uint8_t SkyCenterX = 4 + SkyRadius;
+static const uint8_t SkyCenterY = 4 + SkyRadius;
+
+void drawClockIcon()
+{
+  u8g2.setFont(glyphFont);
+  u8g2.drawGlyph(5, 62, 0xe016); // clock icon (next to the time)
+}
+
+void renderSkyLayer()
+{
+  u8g2.drawCircle(SkyCenterX, SkyCenterY, SkyRadius * 3 / 3, U8G2_DRAW_ALL);
+  u8g2.drawCircle(SkyCenterX, SkyCenterY, SkyRadius * 2 / 3, U8G2_DRAW_ALL);
+  u8g2.drawCircle(SkyCenterX, SkyCenterY, SkyRadius * 1 / 3, U8G2_DRAW_ALL);
+  drawClockIcon();
+}
+
+void renderWaitLayer()
+{
+  u8g2.setFont(textFont);
+  u8g2.drawStr(15, 15, "please");
+  drawClockIcon();
 }
 
-void drawSatConstellation(int numSats, satellite_t* drawSats)
+void renderSplashLayer()
 {
-  uint8_t outer_radius = 24;
-  uint8_t center_x = 4 + outer_radius;
-  uint8_t center_y = 4 + outer_radius;
-  u8g2.drawCircle(center_x, center_y, outer_radius * 3 / 3, U8G2_DRAW_ALL);
-  u8g2.drawCircle(center_x, center_y, outer_radius * 2 / 3, U8G2_DRAW_ALL);
-  u8g2.drawCircle(center_x, center_y, outer_radius * 1 / 3, U8G2_DRAW_ALL);
+  uint8_t xPos = 85;
+  uint8_t yPos = 42; // the answer to everything
+
+  // draw the logo (white text on black background)
+  u8g2.setDrawColor(1);
+  u8g2.drawXBMP(0, 0, OBSLogo_width, OBSLogo_height, OBSLogo);
 
-  for (size_t i = 0; i < numSats; i++)
+  // draw world icon and location icon
+  u8g2.setFont(glyphFont2);
+  u8g2.drawGlyph(xPos, yPos, 0x0034); // world icon
+  u8g2.setFont(glyphFont3);
+  u8g2.drawGlyph(xPos - 3, yPos - 21, 0x0032); // location icon
+
+  // finally, some info text
+  u8g2.setFont(textFont);
+  u8g2.drawStr(xPos - 11, yPos + 18, "GPS TEST");
+}
+
+RenderLayer skyLayer(u8g2, renderSkyLayer); // sky plot rings
+RenderLayer waitLayer(u8g2, renderWaitLayer); // no sky plot yet
+RenderLayer splashLayer(u8g2, renderSplashLayer);
+
+void drawSatConstellation(const sat_epoch_t& epoch)
+{
+  // the rings are part of `skyLayer`
+  for (uint8_t i = 0; i < epoch.numSats; i++)
   {
-    float r = (90.0f - float(drawSats[i].elevation)) / 90.0f * outer_radius;
-    float dx = sin(float(drawSats[i].azimuth) * M_PI / 180.0f) * r;
-    float dy = cos(float(drawSats[i].azimuth) * M_PI / 180.0f) * r;
-    drawSatAbsolute(center_x + dx, center_y - dy, drawSats[i].snr > 15);
+    int16_t x, y;
+    projectAzEl(epoch.azimuth[i], epoch.elevation[i], SkyRadius, SkyCenterX, SkyCenterY, &x, &y);
+    drawSatAbsolute(x, y, epoch.snr[i] > 15);
   }
 }
 
-void drawSatSignalBars(int numActiveSats, satellite_t* drawSats)
+void drawSatSignalBars(const sat_epoch_t& epoch)
 {
   const int maxBars = 7; // only space for 7 bars on the small display
   const uint8_t xOffs = 45;
@@ -119,47 +407,56 @@ void drawSatSignalBars(int numActiveSats, satellite_t* drawSats)
 
   yPos += yInc;
 
-  int numBars = (numActiveSats > maxBars) ? maxBars : numActiveSats;
+  // the strongest satellites (ranked by the satellite store)
+  int numBars = (epoch.numSats > maxBars) ? maxBars : epoch.numSats;
   for (int i = 0; i < numBars; i++)
   {
-    // satellite number ("name") as 1-2 decimal digits
-    u8g2.drawStr(xPos, yPos, itoa(drawSats[i].no, charBuffer, 10));
+    uint8_t slot = epoch.ranked[i];
+    // satellite number ("name") as 1-2 decimal digits; other systems than GPS are marked with their letter in front
+    u8g2.drawStr(xPos, yPos, itoa(epoch.prn[slot], charBuffer, 10));
+    if (epoch.system[slot] != GsvParser::GNSS_GPS)
+    {
+      charBuffer[0] = GsvParser::getSystemLetter(epoch.system[slot]);
+      charBuffer[1] = '\0';
+      u8g2.setFont(textFont); // the small font has digits only
+      u8g2.drawStr(xPos - 6, yPos, charBuffer);
+      u8g2.setFont(smallTextFont);
+    }
 
     // signal strength bar
-    width = constrain(drawSats[i].snr, 0, maxSnr);
+    width = constrain(epoch.snr[slot], 0, maxSnr);
     u8g2.drawBox(xPos + 12, yPos - height, width, height);
     // draw an additional 1 pixel wide bar at the end to indicate that this signal is stronger than `maxSnr`
     // (and therefore the previous bar width has been constrained to a certain width)
-    if (drawSats[i].snr > maxSnr)
+    if (epoch.snr[slot] > maxSnr)
     {
       u8g2.drawBox(xPos + 13 + maxSnr, yPos - height, 1, height);
     }
 
     // satellite SNR as decimal number
-    u8g2.drawStr(xPos + xOffs, yPos, itoa(drawSats[i].snr, charBuffer, 10));
+    u8g2.drawStr(xPos + xOffs, yPos, itoa(epoch.snr[slot], charBuffer, 10));
     yPos += yInc;
   }
 }
 
-void drawTime()
+void drawTime(const sat_epoch_t& epoch)
 {
-  static char charBuffer[10];
+  static char charBuffer[12]; // up to "255:255:255"
 
   uint8_t xpos = 5;
   uint8_t ypos = 62;
 
-  u8g2.setFont(glyphFont);
-  u8g2.drawGlyph(xpos, ypos, 0xe016); // clock icon
+  // the clock icon is part of the static layers
 
-  // even when the valid flag is set, some GPS modules constantly return 00:00:00
-  if(gps.time.isValid() && (gps.time.hour() != 0 && gps.time.minute() != 0 && gps.time.second() != 0))
+  if(epoch.timeValid)
   {
     u8g2.setFont(smallTextFont);
-    snprintf(charBuffer, 9, "%02d:%02d:%02d", gps.time.hour(), gps.time.minute(), gps.time.second());
+    snprintf(charBuffer, sizeof(charBuffer), "%02d:%02d:%02d", epoch.hour, epoch.minute, epoch.second);
     u8g2.drawStr(xpos + 12, ypos - 1, charBuffer);
   }
   else
   {
+    u8g2.setFont(glyphFont);
     u8g2.drawGlyph(xpos + 12, ypos, 0xe25d); // dots icon
   }
   u8g2.setFont(smallTextFont);
@@ -175,25 +472,44 @@ void drawMsgIndicators(bool seenUbx, bool seenNmea)
   u8g2.drawButtonUTF8(xPos + 30, yPos, seenNmea ? U8G2_BTN_BW1 | U8G2_BTN_INV : U8G2_BTN_BW1, 22, 2, 2, "NMEA");
 }
 
-void drawGraphics(int numActiveSats, satellite_t* drawSats)
+void drawModuleNumber(GpsModule& m, uint8_t yPos)
 {
+  // which module a view belongs to (at the left edge), only when there are several
+#if GPS_NUM_MODULES > 1
+  static char charBuffer[4];
+  u8g2.drawStr(0, yPos, itoa(m.num, charBuffer, 10));
+#endif
+}
+
+void renderGraphics(GpsModule& m, const sat_epoch_t& epoch)
+{
+  // draws the constellation view into the frame buffer (without sending it)
   static uint8_t dotCtr = 0;
   uint8_t xPos = 15;
   uint8_t yPos = 15;
-  
-  u8g2.clearBuffer();
+
+  // start from the static layer instead of a cleared buffer
+  bool skyPlot = (epoch.numValidAzEls > 0); // only when there are valid azimuth/elevation values!
+  if(skyPlot)
+  {
+    skyLayer.copyTo();
+  }
+  else
+  {
+    waitLayer.copyTo();
+  }
   u8g2.setDrawColor(1); // white on black
   u8g2.setFont(smallTextFont);
 
-  if(countValidAzEls(numActiveSats, sortedSats) > 0)
+  if(skyPlot)
   {
-    // draw satellite constellation with azimuth and elevation on display (only when there are valid azimuth/elevation values!)
-    drawSatConstellation(numActiveSats, drawSats);
+    // draw satellite constellation with azimuth and elevation on display
+    drawSatConstellation(epoch);
   }
   else
   {
     u8g2.setFont(textFont);
-    u8g2.drawStr(xPos, yPos, "please");
+    // "please" is part of `waitLayer`
     yPos += 9;
     // add some tiny "animation" just to distinguish if the firmware has hung up or we're still waiting for valid data
     switch(dotCtr)
@@ -219,64 +535,23 @@ void drawGraphics(int numActiveSats, satellite_t* drawSats)
   }
 
   // print signal strength list with bars on the display
-  drawSatSignalBars(numActiveSats, drawSats);
+  drawSatSignalBars(epoch);
 
   // print UTC time on display
-  drawTime();
+  drawTime(epoch);
 
   // draw two message indicators for received UBX and NMEA protocol messages
-  drawMsgIndicators(gs.hasSeenUbx(), gs.hasSeenNmea());
-
-  u8g2.sendBuffer();
-}
+  drawMsgIndicators(m.gs.hasSeenUbx(), m.gs.hasSeenNmea());
 
-int countValidAzEls(int numActiveSats, satellite_t* drawSats)
-{
-  int numValid = 0;
-  // count number of satellites that have at least elevation != 0 _or_ azimuth != 0
-  for (int i = 0; i < numActiveSats; i++)
-  {
-    if(sortedSats[i].elevation != 0 || sortedSats[i].azimuth != 0)
-    {
-      numValid++;
-    }
-  }
-  return numValid;
+  drawModuleNumber(m, 6); // top left corner, outside the sky plot
 }
 
-int satCompareFunc(const void * a, const void * b)
+void drawGraphics(GpsModule& m, const sat_epoch_t& epoch)
 {
-  // sorting order:
-  // 1. active satellites first, then inactive ones
-  // 2. satellites with higher SNR first, then lower SNRs
-  // 3. for satellites with same SNR: lower satellite numbers first
-
-  satellite_t* orderA = (satellite_t*)a;
-  satellite_t* orderB = (satellite_t*)b;
-
-  if (!orderA->active && orderB->active)
-  {
-    // active before inactive
-    return 1;
-  }
-  else if (orderA->active && !orderB->active)
-  {
-    // active before inactive
-    return -1;
-  }
-  else
-  {
-    if (orderB->snr != orderA->snr)
-    {
-      // SNR is main sorting criteria; higher SNR first
-      return (orderB->snr - orderA->snr);
-    }
-    else
-    {
-      // lower satellite number first
-      return (orderA->no - orderB->no);
-    }
-  }
+  uint32_t startUs = micros();
+  renderGraphics(m, epoch);
+  displayDiff.sendBuffer();
+  m.metrics.recordRender(micros() - startUs);
 }
 
 void drawSplashScreen(bool infill)
@@ -284,17 +559,9 @@ void drawSplashScreen(bool infill)
   uint8_t xPos = 85;
   uint8_t yPos = 42; // the answer to everything
 
-  u8g2.clearBuffer();
-
-  // draw the logo (white text on black background)
+  // logo, icons and text
+  splashLayer.copyTo();
   u8g2.setDrawColor(1);
-  u8g2.drawXBMP(0, 0, OBSLogo_width, OBSLogo_height, OBSLogo);
-
-  // draw world icon and location icon
-  u8g2.setFont(glyphFont2);
-  u8g2.drawGlyph(xPos, yPos, 0x0034); // world icon
-  u8g2.setFont(glyphFont3);
-  u8g2.drawGlyph(xPos - 3, yPos - 21, 0x0032); // location icon
 
   // add some satellite icons
   drawSatAbsolute(xPos - 8, yPos - 9, infill);
@@ -314,110 +581,274 @@ void drawSplashScreen(bool infill)
     u8g2.drawGlyph(xPos + 20, yPos - 24, 0x002b); // snail (=slow) icon
   }
 
-  // finally, some info text
-  u8g2.setFont(textFont);
-  u8g2.drawStr(xPos - 11, yPos + 18, "GPS TEST");
+  displayDiff.sendBuffer();
+}
 
-  u8g2.sendBuffer();
+void formatVerdict(GpsModule& m, char* pBuf, size_t len)
+{
+  snprintf(pBuf, len, "%s in %lu.%lu s, %ld baud", (m.testPlan.getVerdict() == TestPlan::VERDICT_PASS) ? "PASS" : "FAIL",
+           (unsigned long)(m.testPlan.getDurationMs() / 1000), (unsigned long)(m.testPlan.getDurationMs() % 1000 / 100),
+           (long)m.gs.getBaudRate());
 }
 
-void drawErrorScreen(bool seenUbx, bool seenNmea)
+#if GPS_NUM_MODULES > 1
+void drawResultScreen()
 {
-  static char charBuffer[8];
-  uint8_t xPos = 67;
-  uint8_t yPos = 13;
+  // summary of all modules: the verdict of each one and the checks that failed (the details are on the debug serial)
+  static char charBuffer[48];
+  uint8_t xPos = 4;
+  uint8_t yPos = 9;
 
+  uint8_t numPassed = 0;
+  for (uint8_t i = 0; i < GPS_NUM_MODULES; i++)
+  {
+    numPassed += (modules[i].testPlan.getVerdict() == TestPlan::VERDICT_PASS) ? 1 : 0;
+  }
   u8g2.clearBuffer();
-
-  // draw the logo (white text on black background)
   u8g2.setDrawColor(1);
-  u8g2.drawXBMP(0, 0, OBSLogo_width, OBSLogo_height, OBSLogo);
+  u8g2.setFont(textFont);
+  snprintf(charBuffer, sizeof(charBuffer), "%u of %u modules PASS", numPassed, GPS_NUM_MODULES);
+  u8g2.drawStr(xPos, yPos, charBuffer);
+
+  for (uint8_t i = 0; i < GPS_NUM_MODULES; i++)
+  {
+    GpsModule& m = modules[i];
+    yPos += 10;
+    snprintf(charBuffer, sizeof(charBuffer), "%u:", m.num);
+    u8g2.drawStr(xPos, yPos, charBuffer);
+    formatVerdict(m, charBuffer, sizeof(charBuffer));
+    u8g2.drawStr(xPos + 10, yPos, charBuffer);
+    if (m.testPlan.getVerdict() == TestPlan::VERDICT_PASS)
+    {
+      continue;
+    }
+    yPos += 8;
+    uint8_t xCheck = xPos + 10;
+    for (uint8_t j = 0; j < TestPlan::CHECK_NUM; j++)
+    {
+      if (m.testPlan.getState((TestPlan::CheckId)j) == TestPlan::CHECK_FAILED)
+      {
+        xCheck += u8g2.drawStr(xCheck, yPos, TestPlan::getCheckName((TestPlan::CheckId)j)) + 4;
+      }
+    }
+  }
 
+  displayDiff.sendBuffer();
+}
+#else
+void drawResultScreen()
+{
+  // the verdict with the test duration, then one line per check: what has been measured, what was required, its state
+  static char charBuffer[48];
+  GpsModule& m = modules[0];
+  uint8_t xPos = 4;
+  uint8_t yPos = 9;
+
+  u8g2.clearBuffer();
+  u8g2.setDrawColor(1);
   u8g2.setFont(textFont);
-  u8g2.drawStr(xPos - 3, yPos, "BAUD");
-  u8g2.drawStr(xPos + 25, yPos, itoa(fastBaudRate ? GpsSerialBaudFast : GpsSerialBaudSlow, charBuffer, 10));
+  formatVerdict(m, charBuffer, sizeof(charBuffer));
+  u8g2.drawStr(xPos, yPos, charBuffer);
+
+  for (uint8_t i = 0; i < TestPlan::CHECK_NUM; i++)
+  {
+    TestPlan::CheckId id = (TestPlan::CheckId)i;
+    yPos += 9;
+    u8g2.drawStr(xPos + 4, yPos, TestPlan::getCheckName(id));
+    if (m.testPlan.getState(id) != TestPlan::CHECK_SKIPPED)
+    {
+      snprintf(charBuffer, sizeof(charBuffer), "%lu/%lu", (unsigned long)m.testPlan.getValue(id),
+               (unsigned long)m.testPlan.getRequired(id)); // errors: count/maximum
+      u8g2.drawStr(xPos + 40, yPos, charBuffer);
+    }
+    u8g2.drawStr(xPos + 96, yPos, TestPlan::getStateName(m.testPlan.getState(id)));
+  }
 
-  u8g2.drawStr(xPos - 3, yPos + 10, "RX ST"); // RX count at startup
-  u8g2.drawStr(xPos + 33, yPos + 10, itoa((gsStartupRxCount > 9999) ? 9999 : gsStartupRxCount, charBuffer, 10));
+  displayDiff.sendBuffer();
+}
+#endif
+
+#if GPS_TTFF_MODE
+void formatTtffSeconds(char* pBuf, size_t len, uint32_t ms)
+{
+  if (ms == TtffBench::NO_TIME)
+  {
+    snprintf(pBuf, len, "-");
+    return;
+  }
+  snprintf(pBuf, len, "%lu.%lu", (unsigned long)(ms / 1000), (unsigned long)(ms % 1000 / 100));
+}
 
-  u8g2.drawStr(xPos - 3, yPos + 20, "RX LST"); // RX count "now"
-  unsigned int rxCount = gs.getRxCount();
-  u8g2.drawStr(xPos + 33, yPos + 20, itoa((rxCount > 9999) ? 9999 : rxCount, charBuffer, 10));
+void drawTtffScreen(GpsModule& m)
+{
+  // the run going on (start type, time since the reset, satellites in view, first time and fix so far), below the
+  // runs w/ a fix and min/median/max TTFF (in s) of each start type
+  static char charBuffer[48];
+  static char timeBuffer[3][10]; // formatTtffSeconds(): up to "4294967.2"
+  TtffBench& ttff = m.ttff;
+  uint8_t xPos = 8;
+  uint8_t yPos = 9;
 
-  // when neither seen UBX nor NMEA, display broken link; otherwise a normal link
-  u8g2.setFont(glyphFont4);
-  if(!seenUbx && !seenNmea)
+  u8g2.clearBuffer();
+  u8g2.setDrawColor(1);
+  u8g2.setFont(textFont);
+  drawModuleNumber(m, yPos);
+  if (ttff.isRunning())
   {
-    u8g2.drawGlyph(xPos + 5, yPos + 41, 0x0032); // broken link icon
+    snprintf(charBuffer, sizeof(charBuffer), "%s %u/%u: %lu s, %u sats",
+             TtffBench::getStartName(ttff.getStartType()), ttff.getRunNumber(), ttff.getRunsPerType(),
+             (unsigned long)(ttff.getElapsedMs(millis()) / 1000), ttff.getSatsInView());
+    u8g2.drawStr(xPos, yPos, charBuffer);
+    const TtffBench::ttff_run_t& run = ttff.getCurrentRun();
+    formatTtffSeconds(timeBuffer[0], sizeof(timeBuffer[0]), run.timeMs);
+    formatTtffSeconds(timeBuffer[1], sizeof(timeBuffer[1]), run.fixMs);
+    formatTtffSeconds(timeBuffer[2], sizeof(timeBuffer[2]), run.fix3dMs);
+    snprintf(charBuffer, sizeof(charBuffer), "time %s, fix %s, 3D %s", timeBuffer[0], timeBuffer[1], timeBuffer[2]);
+    u8g2.drawStr(xPos + 4, yPos += 9, charBuffer);
   }
   else
   {
-    u8g2.drawGlyph(xPos + 5, yPos + 41, 0x0030); // working link icon
+    u8g2.drawStr(xPos, yPos, ttff.isDone() ? "TTFF: all runs through" : "TTFF: not started");
+    yPos += 9;
   }
 
-  // further indicators for fast and slow
-  u8g2.setFont(glyphFont5);
-  u8g2.drawGlyph(xPos + 29, yPos + 37, fastBaudRate ? 0x0027 : 0x002b); // rabbit (=fast) icon, snail (=slow) icon
-
-  drawMsgIndicators(seenUbx, seenNmea);
+  yPos += 12;
+  u8g2.drawStr(xPos + 28, yPos, "fix");
+  u8g2.drawStr(xPos + 48, yPos, "min");
+  u8g2.drawStr(xPos + 72, yPos, "med");
+  u8g2.drawStr(xPos + 96, yPos, "max");
+  for (uint8_t i = 0; i < TtffBench::START_NUM; i++)
+  {
+    TtffBench::StartType type = (TtffBench::StartType)i;
+    if (!ttff.isEnabled(type))
+    {
+      continue;
+    }
+    uint32_t minMs = TtffBench::NO_TIME;
+    uint32_t medianMs = TtffBench::NO_TIME;
+    uint32_t maxMs = TtffBench::NO_TIME;
+    ttff.getStats(type, &minMs, &medianMs, &maxMs);
+    yPos += 9;
+    u8g2.drawStr(xPos, yPos, TtffBench::getStartName(type));
+    snprintf(charBuffer, sizeof(charBuffer), "%u/%u", ttff.getNumFixed(type), ttff.getNumRuns(type));
+    u8g2.drawStr(xPos + 28, yPos, charBuffer);
+    formatTtffSeconds(charBuffer, sizeof(charBuffer), minMs);
+    u8g2.drawStr(xPos + 48, yPos, charBuffer);
+    formatTtffSeconds(charBuffer, sizeof(charBuffer), medianMs);
+    u8g2.drawStr(xPos + 72, yPos, charBuffer);
+    formatTtffSeconds(charBuffer, sizeof(charBuffer), maxMs);
+    u8g2.drawStr(xPos + 96, yPos, charBuffer);
+  }
 
-  u8g2.sendBuffer();
+  displayDiff.sendBuffer();
 }
+#endif
 
 void setupDisplay()
 {
   // prepare display and show animated splash screen
+#if DISPLAY_HW_I2C
+  u8g2.setBusClock(DisplayI2cClock);
+#endif
   u8g2.begin();
+  displayDiff.invalidate(); // the display has been cleared, the first frame is sent completely
   u8g2.setBitmapMode(false /* solid */);
   u8g2.setFlipMode(1); // rotate display content by 180 degrees
   drawSplashScreen(0);
 }
 
-int sortSats()
+void printSatInfo(const sat_epoch_t& epoch)
 {
-  // this function sorts all satellites and return number of active satellites;
-  // drawing and logging will only operate on the (by then) sorted copy
-  qsort(sortedSats, MAX_SATELLITES, sizeof(satellite_t), satCompareFunc);
+  // print detailed infromation about every satellite (number, elevation, azimuth, SNR), strongest first
+  for (uint8_t i = 0; i < epoch.numSats; i++)
+  {
+    uint8_t slot = epoch.ranked[i];
+    Serial.print(F("Sat #"));
+    Serial.print(GsvParser::getSystemLetter(epoch.system[slot]));
+    Serial.print(epoch.prn[slot]);
+    Serial.print(F(",  El: "));
+    Serial.print(epoch.elevation[slot]);
+    Serial.print(F(", Az: "));
+    Serial.print(epoch.azimuth[slot]);
+    Serial.print(F(", SNR: "));
+    Serial.println(epoch.snr[slot]);
+  }
+  Serial.print(F("  # active sats seen: "));
+  Serial.print(epoch.numSats);
+  Serial.print(F(", with azimuth/elevation: "));
+  Serial.println(epoch.numValidAzEls);
+}
 
-  // count active ones
-  int numActiveSats = 0;
-  for (int i = 0; i < MAX_SATELLITES; ++i)
+uint8_t numUbxStatusPages()
+{
+  // the number of status pages follows from the number of polled messages in the UBX message registry
+  uint8_t numPolled = 0;
+  for (uint8_t i = 0; i < GpsSoftwareSerial::UBX_MSG_NUM; i++)
   {
-    if (sortedSats[i].active)
+    if (GpsSoftwareSerial::UBX_MESSAGES[i].flags & GpsSoftwareSerial::UBX_MSG_FLAG_POLL)
     {
-      numActiveSats++;
+      numPolled++;
     }
   }
-  return numActiveSats;
+  return (numPolled + UbxMsgsPerPage - 1) / UbxMsgsPerPage;
 }
 
-void printSatInfo(int numActiveSats)
+bool isOnUbxStatusPage(uint8_t msg, int8_t pageNumber)
 {
-  // print detailed infromation about every satellite (number, activity, elevation, azimuth, SNR)
-  for (int i = 0; i < numActiveSats; i++)
+  // polled messages are assigned to the pages in registry order, `UbxMsgsPerPage` at a time (page -1: all of them)
+  if (!(GpsSoftwareSerial::UBX_MESSAGES[msg].flags & GpsSoftwareSerial::UBX_MSG_FLAG_POLL))
   {
-    Serial.print(F("Sat #"));
-    Serial.print(sortedSats[i].no);
-    Serial.print(F(",  Act: "));
-    Serial.print(sortedSats[i].active ? F("yes") : F("no "));
-    Serial.print(F(",  El: "));
-    Serial.print(sortedSats[i].elevation);
-    Serial.print(F(", Az: "));
-    Serial.print(sortedSats[i].azimuth);
-    Serial.print(F(", SNR: "));
-    Serial.println(sortedSats[i].snr);
+    return false;
   }
-  Serial.print(F("  # active sats seen: "));
-  Serial.println(numActiveSats);
+  if (pageNumber < 0)
+  {
+    return true;
+  }
+  uint8_t pollIndex = 0;
+  for (uint8_t i = 0; i < msg; i++)
+  {
+    if (GpsSoftwareSerial::UBX_MESSAGES[i].flags & GpsSoftwareSerial::UBX_MSG_FLAG_POLL)
+    {
+      pollIndex++;
+    }
+  }
+  return (pollIndex / UbxMsgsPerPage) == pageNumber;
 }
 
-void showUbxMessageStatus(uint8_t burstNumber)
+void printModuleTag(GpsModule& m)
 {
-  static char charBuffer[8];
-  const char pollSuccessMsg[] = "OK"; // polling OK
+  // debug output of several modules: messages start w/ the module's number...
+#if GPS_NUM_MODULES > 1
+  Serial.print(F("GPS"));
+  Serial.print(m.num);
+  Serial.print(F(": "));
+#endif
+}
+
+void printModuleHeading(GpsModule& m)
+{
+  // ...and blocks of lines w/ a heading
+#if GPS_NUM_MODULES > 1
+  Serial.print(F("--- GPS module "));
+  Serial.print(m.num);
+  Serial.println(F(" ---"));
+#endif
+}
+
+uint8_t findUbxPollRequest(GpsModule& m, uint8_t msg)
+{
+  return m.ubxEngine.findLatest(GpsSoftwareSerial::UBX_MESSAGES[msg].msgClass, GpsSoftwareSerial::UBX_MESSAGES[msg].msgId);
+}
+
+void showUbxMessageStatus(GpsModule& m, uint8_t pageNumber)
+{
+  static char charBuffer[10]; // up to "(255/255)"
+  const char pollSuccessMsg[] = "OK"; // polling OK (the request has been sent)
   const char pollFailMsg[] = "ER"; // polling ERROR
+  const char pollQueuedMsg[] = ".."; // not sent yet / no answer yet
   const char rxSuccessMsg[] = "OK"; // receiving OK (received a reply to the poll request)
   const char rxFailMsg[] = "NO"; // receiving NOt OK (didn't receive a reply)
+  const char rxNakMsg[] = "NK"; // the module rejected the request (ACK-NAK)
   uint8_t xPos = 8; // UBX message name text's x start offset
   uint8_t yPos = 9;
   uint8_t xOffset = 80; // status text's x start offset (to the right of the display; right of the UBX message names)
@@ -426,205 +857,422 @@ void showUbxMessageStatus(uint8_t burstNumber)
   u8g2.clearBuffer();
   u8g2.setFont(textFont);
   u8g2.drawStr(xPos, yPos, "Polled UBX msgs.");
+  drawModuleNumber(m, yPos);
 
-  // for timing purposes first draw all the text messages, then send the poll requests
-  if (burstNumber == 0)
-  {
-    u8g2.drawStr(xPos + xOffset, yPos, "(1/4)");
-    xPos += 4;
-
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "NAV-POSECEF");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_NAV_POSECEF) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_NAV_POSECEF) ? rxSuccessMsg : rxFailMsg);
-
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "NAV-POSLLH");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_NAV_POSLLH) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_NAV_POSLLH) ? rxSuccessMsg : rxFailMsg);
-
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "NAV-STATUS");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_NAV_STATUS) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_NAV_STATUS) ? rxSuccessMsg : rxFailMsg);
-
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "NAV-DOP");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_NAV_DOP) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_NAV_DOP) ? rxSuccessMsg : rxFailMsg);
-
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "NAV-SOL");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_NAV_SOL) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_NAV_SOL) ? rxSuccessMsg : rxFailMsg);
+  snprintf(charBuffer, sizeof(charBuffer), "(%u/%u)", (uint8_t)(pageNumber + 1), numUbxStatusPages());
+  u8g2.drawStr(xPos + xOffset, yPos, charBuffer);
+  xPos += 4;
 
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "NAV-VELECEF");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_NAV_VELECEF) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_NAV_VELECEF) ? rxSuccessMsg : rxFailMsg);
-  }
-  else if (burstNumber == 1)
+  for (uint8_t i = 0; i < GpsSoftwareSerial::UBX_MSG_NUM; i++)
   {
-    u8g2.drawStr(xPos + xOffset, yPos, "(2/4)");
-    xPos += 4;
-
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "NAV-VELNED");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_NAV_VELNED) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_NAV_VELNED) ? rxSuccessMsg : rxFailMsg);
-
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "NAV-TIMEGPS");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_NAV_TIMEGPS) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_NAV_TIMEGPS) ? rxSuccessMsg : rxFailMsg);
-
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "NAV-TIMEUTC");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_NAV_TIMEUTC) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_NAV_TIMEUTC) ? rxSuccessMsg : rxFailMsg);
-
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "NAV-CLOCK");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_NAV_CLOCK) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_NAV_CLOCK) ? rxSuccessMsg : rxFailMsg);
-
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "NAV-SVINFO");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_NAV_SVINFO) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_NAV_SVINFO) ? rxSuccessMsg : rxFailMsg);
+    if (!isOnUbxStatusPage(i, pageNumber))
+    {
+      continue;
+    }
+    const char* pPollStatus = pollFailMsg;
+    const char* pRxStatus = rxFailMsg;
+    uint8_t id = findUbxPollRequest(m, i);
+    if (id != UbxEngine::NO_REQUEST)
+    {
+      const UbxEngine::ubx_request_t& req = m.ubxEngine.getRequest(id);
+      pPollStatus = (req.attempts > 0) ? pollSuccessMsg : pollQueuedMsg;
+      switch (req.state)
+      {
+        case UbxEngine::REQ_ANSWERED:
+        case UbxEngine::REQ_ACKED:
+          pRxStatus = rxSuccessMsg;
+          break;
+        case UbxEngine::REQ_NAKED:
+          pRxStatus = rxNakMsg;
+          break;
+        case UbxEngine::REQ_TIMED_OUT:
+          pRxStatus = rxFailMsg;
+          break;
+        default:
+          pRxStatus = pollQueuedMsg;
+          break;
+      }
+    }
 
     yPos += 8;
-    u8g2.drawStr(xPos, yPos, "NAV-DPGPS");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_NAV_DGPS) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_NAV_DGPS) ? rxSuccessMsg : rxFailMsg);
-
+    u8g2.drawStr(xPos, yPos, GpsSoftwareSerial::UBX_MESSAGES[i].name);
+    u8g2.drawStr(xPos + xOffset, yPos, pPollStatus);
+    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, pRxStatus);
   }
-  else if (burstNumber == 2)
-  {
-    u8g2.drawStr(xPos + xOffset, yPos, "(3/4)");
-    xPos += 4;
-
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "NAV-SBAS");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_NAV_SBAS) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_NAV_SBAS) ? rxSuccessMsg : rxFailMsg);
-
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "NAV-EFKSTATUS");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_NAV_EFKSTATUS) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_NAV_EFKSTATUS) ? rxSuccessMsg : rxFailMsg);
+  displayDiff.sendBuffer();
+}
 
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "NAV-AOPSTATUS");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_NAV_AOPSTATUS) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_NAV_AOPSTATUS) ? rxSuccessMsg : rxFailMsg);
+bool isMetricsPage(int8_t page)
+{
+  return page == numUbxStatusPages(); // right after the UBX status pages
+}
 
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "CFG-MSG");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_CFG_MSG) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_CFG_MSG) ? rxSuccessMsg : rxFailMsg);
+void drawMetricsPage(GpsModule& m, const GpsMetrics::metrics_record_t& record)
+{
+  // summary of the latest metrics sample (rates per second, averages/maxima during the interval, errors in total)
+  static char charBuffer[64];
+  uint8_t xPos = 8;
+  uint8_t yPos = 9;
 
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "CFG-INF");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_CFG_INF) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_CFG_INF) ? rxSuccessMsg : rxFailMsg);
+  u8g2.clearBuffer();
+  u8g2.setFont(textFont);
+  u8g2.drawStr(xPos, yPos, "Metrics (avg/max)");
+  drawModuleNumber(m, yPos);
+  xPos += 4;
+
+  snprintf(charBuffer, sizeof(charBuffer), "RX %lu B/s, OVF %lu", (unsigned long)record.bytesPerSec,
+           (unsigned long)record.overflows);
+  u8g2.drawStr(xPos, yPos += 8, charBuffer);
+  snprintf(charBuffer, sizeof(charBuffer), "NMEA %u/s, UBX %u/s", record.nmeaPerSec, record.ubxPerSec);
+  u8g2.drawStr(xPos, yPos += 8, charBuffer);
+  snprintf(charBuffer, sizeof(charBuffer), "Epochs %u/s, jitter %lu ms", record.epochsPerSec,
+           (unsigned long)(record.jitterMaxUs / 1000));
+  u8g2.drawStr(xPos, yPos += 8, charBuffer);
+  snprintf(charBuffer, sizeof(charBuffer), "CK err N %lu, U %lu, sync %lu", (unsigned long)record.nmeaChecksumErrors,
+           (unsigned long)(record.ubxChecksumErrors + record.ubxLengthErrors), (unsigned long)record.resyncs);
+  u8g2.drawStr(xPos, yPos += 8, charBuffer);
+  snprintf(charBuffer, sizeof(charBuffer), "Loop %lu/%lu us", (unsigned long)record.loopAvgUs,
+           (unsigned long)record.loopMaxUs);
+  u8g2.drawStr(xPos, yPos += 8, charBuffer);
+  snprintf(charBuffer, sizeof(charBuffer), "Render %lu/%lu us", (unsigned long)record.renderAvgUs,
+           (unsigned long)record.renderMaxUs);
+  u8g2.drawStr(xPos, yPos += 8, charBuffer);
+  displayDiff.sendBuffer();
+}
 
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "CFG-DAT");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_CFG_DAT) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_CFG_DAT) ? rxSuccessMsg : rxFailMsg);
+void showUiPage(GpsModule& m, int8_t page)
+{
+  // a UBX status page or the metrics page
+  if (isMetricsPage(page))
+  {
+    drawMetricsPage(m, m.metrics.getLast());
   }
-  else if (burstNumber == 3)
+  else
   {
-    u8g2.drawStr(xPos + xOffset, yPos, "(4/4)");
-    xPos += 4;
-
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "CFG-TP");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_CFG_TP) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_CFG_TP) ? rxSuccessMsg : rxFailMsg);
-
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "CFG-RATE");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_CFG_RATE) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_CFG_RATE) ? rxSuccessMsg : rxFailMsg);
-
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "CFG-FXN");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_CFG_FXN) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_CFG_FXN) ? rxSuccessMsg : rxFailMsg);
-
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "CFG-RXM");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_CFG_RXM) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_CFG_RXM) ? rxSuccessMsg : rxFailMsg);
-
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "CFG-EKF");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_CFG_EKF) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_CFG_EKF) ? rxSuccessMsg : rxFailMsg);
-
-    yPos += 8;
-    u8g2.drawStr(xPos, yPos, "CFG-PRT");
-    u8g2.drawStr(xPos + xOffset, yPos, gs.polledMessage(GpsSoftwareSerial::UBX_MSG_CFG_PRT) ? pollSuccessMsg : pollFailMsg);
-    u8g2.drawStr(xPos + xOffset + xOffsetPollRx, yPos, gs.rxedMessage(GpsSoftwareSerial::UBX_MSG_CFG_PRT) ? rxSuccessMsg : rxFailMsg);
+    showUbxMessageStatus(m, page);
   }
-  u8g2.sendBuffer();
-  delay(1700); // the time in ms the display is frozen
 }
 
-void pollMultiUbx(uint8_t burstNumber)
+bool pollMultiUbx(GpsModule& m, int8_t pageNumber, void (*onDone)(GpsModule& m))
 {
   // this function can be used to narrow down if the GPS module responds to any UBX message poll request at all!
-  // please note that some polling requests might need payload (which is not implemented (yet?));
-  // currently NAV-* messages are polled and also some CFG-* messages
-
-  if (burstNumber == 0)
+  // the polled messages (currently NAV-* and some CFG-* messages) are taken from the UBX message registry in GpsSerial.h;
+  // they are all queued at once, the engine sends them as fast as the module answers (page -1: all pages)
+  if (!m.ubxEngine.isIdle())
   {
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_POSECEF)) { Serial.println("Unable to poll NAV-POSECEF."); }
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_POSLLH)) { Serial.println("Unable to poll NAV-POSLLH."); }
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_STATUS)) { Serial.println("Unable to poll NAV-STATUS."); }
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_DOP)) { Serial.println("Unable to poll NAV-DOP."); }
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_SOL)) { Serial.println("Unable to poll NAV-SOL."); }
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_VELECEF)) { Serial.println("Unable to poll NAV-VELECEF."); }
+    return false;
   }
-  else if (burstNumber == 1)
+  m.ubxEngine.clear(); // forget the answers of the polls before
+  for (uint8_t i = 0; i < GpsSoftwareSerial::UBX_MSG_NUM; i++)
   {
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_VELNED)) { Serial.println("Unable to poll NAV-VELNED."); }
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_TIMEGPS)) { Serial.println("Unable to poll NAV-TIMEGPS."); }
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_TIMEUTC)) { Serial.println("Unable to poll NAV-TIMEUTC."); }
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_CLOCK)) { Serial.println("Unable to poll NAV-CLOCK."); }
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_SVINFO)) { Serial.println("Unable to poll NAV-SVINFO."); }
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_DGPS)) { Serial.println("Unable to poll NAV-DGPS."); }
+    if (isOnUbxStatusPage(i, pageNumber) && m.ubxEngine.poll((GpsSoftwareSerial::UbxMessage)i) == UbxEngine::NO_REQUEST)
+    {
+      printModuleTag(m);
+      Serial.print(F("Unable to poll "));
+      Serial.print(GpsSoftwareSerial::UBX_MESSAGES[i].name);
+      Serial.println(F("."));
+    }
   }
-  else if (burstNumber == 2)
+  m.ubxPollStartMs = millis();
+  m.onUbxPollsDone = onDone;
+  return true;
+}
+
+void printUbxPollResults(GpsModule& m)
+{
+  // one line per request (round trip time of the last attempt), then the summary
+  printModuleHeading(m);
+  unsigned int numAnswered = 0;
+  unsigned int numNaked = 0;
+  unsigned int numTimedOut = 0;
+  uint32_t minRttUs = UINT32_MAX;
+  uint32_t maxRttUs = 0;
+  for (uint8_t i = 0; i < GpsSoftwareSerial::UBX_MSG_NUM; i++)
   {
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_SBAS)) { Serial.println("Unable to poll NAV-SBAS."); }
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_EFKSTATUS)) { Serial.println("Unable to poll NAV-EFKSTATUS."); }
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_AOPSTATUS)) { Serial.println("Unable to poll NAV-AOPSTATUS."); }
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_CFG, GpsSoftwareSerial::UBX_MSG_ID_CFG_MSG)) { Serial.println("Unable to poll CFG-MSG."); } // TODO: has param(s)! payload length=2
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_CFG, GpsSoftwareSerial::UBX_MSG_ID_CFG_INF)) { Serial.println("Unable to poll CFG-INF."); } // TODO: has param(s)! payload length=1
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_CFG, GpsSoftwareSerial::UBX_MSG_ID_CFG_DAT)) { Serial.println("Unable to poll CFG-DAT."); }
+    uint8_t id = findUbxPollRequest(m, i);
+    if (id == UbxEngine::NO_REQUEST)
+    {
+      continue;
+    }
+    const UbxEngine::ubx_request_t& req = m.ubxEngine.getRequest(id);
+    Serial.print(GpsSoftwareSerial::UBX_MESSAGES[i].name);
+    switch (req.state)
+    {
+      case UbxEngine::REQ_ANSWERED:
+      case UbxEngine::REQ_ACKED:
+        Serial.print(F(": answered"));
+        numAnswered++;
+        if (req.rttUs < minRttUs)
+        {
+          minRttUs = req.rttUs;
+        }
+        if (req.rttUs > maxRttUs)
+        {
+          maxRttUs = req.rttUs;
+        }
+        break;
+      case UbxEngine::REQ_NAKED:
+        Serial.print(F(": NAK"));
+        numNaked++;
+        break;
+      default:
+        Serial.print(F(": no answer"));
+        numTimedOut++;
+        break;
+    }
+    if (req.state != UbxEngine::REQ_TIMED_OUT)
+    {
+      Serial.print(F(" after "));
+      Serial.print(req.rttUs / 1000);
+      Serial.print(F(" ms"));
+    }
+    Serial.print(F(" ("));
+    Serial.print(req.attempts);
+    Serial.println(req.attempts == 1 ? F(" attempt)") : F(" attempts)"));
   }
-  else if (burstNumber == 3)
+  Serial.print(F("UBX polls: "));
+  Serial.print(numAnswered);
+  Serial.print(F(" answered, "));
+  Serial.print(numNaked);
+  Serial.print(F(" NAK, "));
+  Serial.print(numTimedOut);
+  Serial.print(F(" w/o answer within "));
+  Serial.print(millis() - m.ubxPollStartMs);
+  Serial.print(F(" ms"));
+  if (numAnswered > 0)
   {
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_CFG, GpsSoftwareSerial::UBX_MSG_ID_CFG_TP)) { Serial.println("Unable to poll CFG-TP."); }
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_CFG, GpsSoftwareSerial::UBX_MSG_ID_CFG_RATE)) { Serial.println("Unable to poll CFG-RATE."); }
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_CFG, GpsSoftwareSerial::UBX_MSG_ID_CFG_FXN)) { Serial.println("Unable to poll CFG-FXN."); }
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_CFG, GpsSoftwareSerial::UBX_MSG_ID_CFG_RXM)) { Serial.println("Unable to poll CFG-RXM."); }
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_CFG, GpsSoftwareSerial::UBX_MSG_ID_CFG_EKF)) { Serial.println("Unable to poll CFG-EKF."); }
-    if(!gs.pollUbxMessage(GpsSoftwareSerial::UBX_MSG_CLASS_CFG, GpsSoftwareSerial::UBX_MSG_ID_CFG_PRT)) { Serial.println("Unable to poll CFG-PRT."); } // this one seems to have finally "worked for me" on Techtotop GPS modules
+    Serial.print(F(", round trip "));
+    Serial.print(minRttUs / 1000);
+    Serial.print(F("-"));
+    Serial.print(maxRttUs / 1000);
+    Serial.print(F(" ms"));
   }
+  Serial.println(F("."));
 }
 
-void checkCommunication(bool parsedNmeaDataAvailable, bool trap)
+#if GPS_UBX_NAV_MODE
+void startUbxNavConfig(GpsModule& m)
 {
-  bool seenUbx = gs.hasSeenUbx();
-  bool seenNmea = gs.hasSeenNmea();
+  printModuleTag(m);
+  Serial.println(F("UBX navigation mode: configuring NAV-SVINFO/-TIMEUTC/-SOL output."));
+  m.ubxNavCfgNumIds = UbxNavDecoder::submitNavOutput(m.ubxEngine, m.ubxNavCfgIds);
+  m.ubxNavCfgStep = UBX_NAV_CFG_OUTPUT;
+}
 
-  unsigned int rxCount = gs.getRxCount();
+void checkUbxNavConfig(GpsModule& m)
+{
+  // next configuration step once the module has acknowledged all requests of the current one
+  static const char* const stepNames[] = {"NAV output", "NMEA off", "", "rate"};
+  if (m.ubxNavCfgStep == UBX_NAV_CFG_WAIT_CHANNELS)
+  {
+    uint8_t numChannels = m.ubxNav.getNumChannels();
+    if (numChannels == 0)
+    {
+      return;
+    }
+    uint8_t rateHz = UbxNavDecoder::getMaxRateHz(m.gs.getBaudRate(), numChannels, UbxNavMaxRateHz);
+    printModuleTag(m);
+    Serial.print(F("UBX navigation mode: "));
+    Serial.print(numChannels);
+    Serial.print(F(" channels, "));
+    Serial.print(rateHz);
+    Serial.print(F(" Hz at "));
+    Serial.print(m.gs.getBaudRate());
+    Serial.println(F(" baud."));
+    if (rateHz <= 1)
+    {
+      m.ubxNavCfgStep = UBX_NAV_CFG_DONE; // the module's default rate
+      return;
+    }
+    m.ubxNavCfgNumIds = UbxNavDecoder::submitRate(m.ubxEngine, rateHz, m.ubxNavCfgIds);
+    m.ubxNavCfgStep = UBX_NAV_CFG_RATE;
+    return;
+  }
+  if (m.ubxNavCfgStep >= UBX_NAV_CFG_DONE)
+  {
+    return;
+  }
+
+  uint8_t numAcked = 0;
+  for (uint8_t i = 0; i < m.ubxNavCfgNumIds; i++)
+  {
+    if (!m.ubxEngine.isDone(m.ubxNavCfgIds[i]))
+    {
+      return;
+    }
+    if (m.ubxEngine.getRequest(m.ubxNavCfgIds[i]).state == UbxEngine::REQ_ACKED)
+    {
+      numAcked++;
+    }
+  }
+  // the slots are needed for the next step (the test's polls keep theirs until the next round)
+  for (uint8_t i = 0; i < m.ubxNavCfgNumIds; i++)
+  {
+    m.ubxEngine.release(m.ubxNavCfgIds[i]);
+  }
+  printModuleTag(m);
+  Serial.print(F("UBX navigation mode, "));
+  Serial.print(stepNames[m.ubxNavCfgStep]);
+  Serial.print(F(": "));
+  Serial.print(numAcked);
+  Serial.print(F("/"));
+  Serial.print(m.ubxNavCfgNumIds);
+  Serial.println(F(" acknowledged."));
+  if (numAcked == 0 || numAcked < m.ubxNavCfgNumIds)
+  {
+    printModuleTag(m);
+    Serial.println((m.ubxNavCfgStep == UBX_NAV_CFG_OUTPUT) ? F("UBX navigation mode not supported, NMEA stays on.")
+                                                           : F("UBX navigation mode incomplete."));
+    m.ubxNavCfgStep = UBX_NAV_CFG_FAILED;
+    return;
+  }
+  switch (m.ubxNavCfgStep)
+  {
+    case UBX_NAV_CFG_OUTPUT:
+      m.ubxNavCfgNumIds = UbxNavDecoder::submitNmeaOff(m.ubxEngine, m.ubxNavCfgIds);
+      m.ubxNavCfgStep = UBX_NAV_CFG_NMEA_OFF;
+      break;
+    case UBX_NAV_CFG_NMEA_OFF:
+      m.ubxNavCfgStep = UBX_NAV_CFG_WAIT_CHANNELS;
+      break;
+    default:
+      m.ubxNavCfgStep = UBX_NAV_CFG_DONE;
+      break;
+  }
+}
+#endif
+
+void checkUbxPolls(GpsModule& m)
+{
+  // the engine sends, matches and times out from here; once the last request is through, the results are reported
+  m.ubxEngine.update();
+#if GPS_UBX_NAV_MODE
+  checkUbxNavConfig(m); // before anything may clear the requests (when the engine is idle)
+#endif
+  if (m.onUbxPollsDone != nullptr && m.ubxEngine.isIdle())
+  {
+    void (*pDone)(GpsModule& m) = m.onUbxPollsDone;
+    m.onUbxPollsDone = nullptr;
+    printUbxPollResults(m);
+    pDone(m);
+  }
+}
+
+const char* getTriggerName(uint8_t reason)
+{
+  switch (reason)
+  {
+    case RxRecorder::TRIGGER_OVERFLOW:
+      return "RX overflow";
+    case RxRecorder::TRIGGER_UBX_CHECKSUM:
+      return "UBX checksum error";
+    case RxRecorder::TRIGGER_UBX_LENGTH:
+      return "UBX length error";
+    default:
+      return "end of test";
+  }
+}
+
+void dumpRxCapture(GpsModule& m)
+{
+  // the raw bytes as one binary block between two marker lines (the first one with the length), to be cut out of the
+  // debug serial log with host/build/rx_dump (as .ubx for u-center and the replay, and as .nmea), then the timestamps
+  RxRecorder& recorder = m.gs.getRecorder();
+  if (!recorder.isEnabled())
+  {
+    return;
+  }
+  recorder.freeze();
+  uint32_t startOffset = recorder.getStartOffset();
+  uint32_t endOffset = recorder.getEndOffset();
+  Serial.print(F("RX capture of bytes #"));
+  Serial.print(startOffset);
+  Serial.print(F(" to #"));
+  Serial.print(endOffset);
+  Serial.print(F(", frozen by "));
+  Serial.print(getTriggerName(recorder.getTriggerReason()));
+  Serial.print(F(" at #"));
+  Serial.println(recorder.getTriggerOffset());
+  Serial.print(F("-----BEGIN RX CAPTURE "));
+  Serial.print(endOffset - startOffset);
+  Serial.println(F("-----"));
+  uint8_t chunk[64];
+  uint32_t offset = startOffset;
+  size_t len;
+  while (offset != endOffset && (len = recorder.read(offset, chunk, sizeof(chunk))) > 0)
+  {
+    Serial.write(chunk, len);
+    offset += len;
+  }
+  Serial.println();
+  Serial.println(F("-----END RX CAPTURE-----"));
+  Serial.println(F("RX capture timestamps (byte #, us):"));
+  for (uint8_t i = 0; i < recorder.getNumMarks(); i++)
+  {
+    Serial.print(F("  #"));
+    Serial.print(recorder.getMark(i).offset);
+    Serial.print(F(" "));
+    Serial.println(recorder.getMark(i).timeUs);
+  }
+}
+
+void checkCommunication(GpsModule& m)
+{
+  bool seenUbx = m.gs.hasSeenUbx();
+  bool seenNmea = m.gs.hasSeenNmea();
+
+  unsigned int rxCount = m.gs.getRxCount();
   Serial.print(F("Current RX count: "));
   Serial.println(rxCount);
+  Serial.print(F("RX overflows: "));
+  Serial.print(m.gs.getRxOverflowCount());
+  Serial.print(F(", RX buffer high water: "));
+  Serial.print(m.gs.getRxHighWater());
+  Serial.print(F("/"));
+  Serial.println(m.gs.getRxBufferSize());
+  Serial.print(F("Display frames: "));
+  Serial.print(displayDiff.getFrameCount());
+  Serial.print(F(", bytes/frame: "));
+  Serial.print(displayDiff.getFrameCount() ? displayDiff.getBytesSent() / displayDiff.getFrameCount() : 0);
+  Serial.print(F(" (last: "));
+  Serial.print(displayDiff.getLastFrameBytes());
+  Serial.print(F(", full: "));
+  Serial.print(displayDiff.getFrameSize());
+  Serial.print(F("), transfer time: "));
+  Serial.print(displayDiff.getLastTransferMicros());
+  Serial.print(F(" us (max: "));
+  Serial.print(displayDiff.getMaxTransferMicros());
+  Serial.println(F(" us)"));
+  Serial.print(F("GSV cycles decoded: "));
+  Serial.println(m.gsvCycleCount.load());
+  Serial.print(F("NMEA sentences: "));
+  Serial.print(m.gs.getNmeaSentenceCount());
+  Serial.print(F(", checksum errors: "));
+  Serial.print(m.gs.getNmeaChecksumErrorCount());
+  Serial.print(F("; UBX frames: "));
+  Serial.print(m.gs.getUbxFrameCount());
+  Serial.print(F(", checksum errors: "));
+  Serial.print(m.gs.getUbxChecksumErrorCount());
+  Serial.print(F(", length errors: "));
+  Serial.print(m.gs.getUbxLengthErrorCount());
+  Serial.print(F("; framing resyncs: "));
+  Serial.println(m.gs.getResyncCount());
+#if GPS_UBX_NAV_MODE
+  Serial.print(F("UBX NAV-SVINFO epochs decoded: "));
+  Serial.print(m.ubxNav.getEpochCount());
+  Serial.print(F(" ("));
+  Serial.print(m.ubxNav.getNumChannels());
+  Serial.print(F(" channels), fix type: "));
+  Serial.print(m.ubxNav.getFixType());
+  Serial.print(F(", sats used: "));
+  Serial.print(m.ubxNav.getNumSatsUsed());
+  Serial.print(F(", length errors: "));
+  Serial.println(m.ubxNav.getLengthErrorCount());
+#endif
+#if GPS_PIPELINE_MODE
+  Serial.print(F("Epochs dropped between RX task and UI: "));
+  Serial.println(m.satStore.getDropCount());
+#endif
 
   if (!seenUbx && !seenNmea)
   {
@@ -644,7 +1292,7 @@ void checkCommunication(bool parsedNmeaDataAvailable, bool trap)
     Serial.print(F("NMEA RX "));
     if (seenNmea)
     {
-      if (parsedNmeaDataAvailable)
+      if (m.parsedNmeaDataAvailable)
       {
         Serial.println(F("seen, data available. Everything seems to work."));
       }
@@ -658,228 +1306,1045 @@ void checkCommunication(bool parsedNmeaDataAvailable, bool trap)
       Serial.println(F("not seen."));
     }
   }
+}
+
+void collectGsvSats(GsvParser& parser, SatStore& store)
+{
+  // take over the (up to) four satellites of the $--GSV sentence just decoded; the store keeps them ranked
+  for (uint8_t i = 0; i < parser.getNumSats(); i++)
+  {
+    const GsvParser::gsv_sat_t& gsvSat = parser.getSat(i);
+    store.update(gsvSat.system, gsvSat.prn, gsvSat.elevation, gsvSat.azimuth, gsvSat.snr);
+  }
+}
 
-  if(!parsedNmeaDataAvailable && trap)
+bool publishEpoch(GpsModule& m)
+{
+  // the satellites of an epoch are complete: publish them (for drawing) and start over with an empty table;
+  // returns false when the epoch is skipped due to downsampling
+  m.metrics.recordEpoch(micros()); // all of them, the epoch rate and jitter are the module's
+
+  // make sure we do not draw and print to the console and draw too often (base rate usually is 1 Hz)
+  ++m.downsampleCounter;
+  if (m.downsampleCounter != EpochDownsampling)
   {
-    drawErrorScreen(seenUbx, seenNmea);
+    m.satStore.discard();
+    return false;
+  }
+  m.downsampleCounter = 0;
+  m.satStore.publish();
+  return true;
+}
 
-    // dump RX memory on the debug serial
-    unsigned int len = gs.getRxStartupMemLen();
-    Serial.print(F("RX startup memory length: "));
-    Serial.println(len);
-    Serial.print(F("RX count: "));
-    Serial.println(rxCount);
+uint8_t readNmeaField(TinyGPSCustom& gpField, TinyGPSCustom& gnField, uint8_t lastValue)
+{
+  // a numeric field as sent by GPS-only ($GP...) or multi-GNSS modules ($GN...), the value before when neither has
+  // come in since (there may be several GSV cycles per GGA/GSA)
+  if (gnField.isUpdated())
+  {
+    return atoi(gnField.value());
+  }
+  if (gpField.isUpdated())
+  {
+    return atoi(gpField.value());
+  }
+  return lastValue;
+}
+
+bool finishGsvEpoch(GpsModule& m)
+{
+  // all GSV cycles of an epoch have been received, the time is the one of the latest RMC/GGA (an empty time field
+  // reads as 00:00:00.00), the fix the one of the latest GGA w/ its dimension from the latest GSA
+  ++m.gsvCycleCount;
+  if (m.gps.location.isValid())
+  {
+    m.fixAvailable = true;
+  }
+  m.nmeaFixQuality = readNmeaField(m.ggaQualityGp, m.ggaQualityGn, m.nmeaFixQuality);
+  m.nmeaFixMode = readNmeaField(m.gsaModeGp, m.gsaModeGn, m.nmeaFixMode);
+  m.satStore.setFix((m.nmeaFixQuality == 0) ? 0 : (m.nmeaFixMode == 3) ? 3 : 2);
+  m.satStore.setTime(m.gps.time.isValid() && m.gps.time.value() != 0, m.gps.time.hour(), m.gps.time.minute(),
+                     m.gps.time.second());
+  return publishEpoch(m);
+}
+
+bool decodeNmeaChar(GpsModule& m, char c)
+{
+  // feed a single character into the NMEA decoders and collect the satellite info from the $--GSV sentences;
+  // returns true when a complete GSV epoch has been published
+  bool epochComplete = false;
 
-    unsigned int loopCnt = (len < rxCount) ? len : rxCount;
-    int* pMem = gs.getRxStartupMem();
+  m.gps.encode(c);
 
-    // dump received bytes as HEX
-    for (unsigned int i = 0; i < loopCnt; i++)
+#if GPS_UBX_NAV_MODE
+  if (m.ubxNav.getEpochCount() > 0)
+  {
+    return false; // the satellites come from NAV-SVINFO now (the module may not have turned NMEA off)
+  }
+#endif
+  uint8_t gsvEvents = m.gsvParser.encode(c);
+  if (gsvEvents == 0)
+  {
+    return false;
+  }
+
+  if (gsvEvents & GsvParser::GSV_EVENT_EPOCH_BEFORE)
+  {
+    epochComplete |= finishGsvEpoch(m);
+  }
+  if (gsvEvents & GsvParser::GSV_EVENT_SENTENCE)
+  {
+    m.parsedNmeaDataAvailable = true;
+    collectGsvSats(m.gsvParser, m.satStore);
+  }
+  if (gsvEvents & GsvParser::GSV_EVENT_EPOCH)
+  {
+    epochComplete |= finishGsvEpoch(m);
+  }
+  return epochComplete;
+}
+
+#if GPS_UBX_NAV_MODE
+void onUbxNavFrame(uint8_t msgClass, uint8_t msgId, const uint8_t* pPayload, uint16_t len, void* pContext)
+{
+  // UBX handler, i.e. in the RX context like decodeNmeaChar(): each NAV-SVINFO is a complete epoch
+  GpsModule& m = *(GpsModule*)pContext;
+  if (m.ubxNav.getEpochCount() == 0 && msgId == GpsSoftwareSerial::UBX_MSG_ID_NAV_SVINFO)
+  {
+    m.satStore.discard(); // drop what the GSV parser may have collected of its epoch so far
+  }
+  if (m.ubxNav.decode(msgClass, msgId, pPayload, len, m.satStore) & UbxNavDecoder::UBX_NAV_EVENT_EPOCH)
+  {
+    m.parsedNmeaDataAvailable = true;
+    if (m.ubxNav.getFixType() >= 2)
     {
-      if (i % 8 == 0)
+      m.fixAvailable = true; // 2D or better
+    }
+    publishEpoch(m);
+  }
+}
+#endif
+
+#if GPS_TTFF_MODE
+void onUbxNavStatus(uint8_t msgClass, uint8_t msgId, const uint8_t* pPayload, uint16_t len, void* pContext)
+{
+  // UBX handler (in the RX context like onUbxNavFrame()): the module's own fix status and TTFF
+  GpsModule& m = *(GpsModule*)pContext;
+  m.ttff.decodeNavStatus(pPayload, len, millis());
+}
+#endif
+
+#if GPS_PIPELINE_MODE
+void rxTask(void* pParameters)
+{
+  // owns the GPS serials' RX side and the NMEA decoders; publishes complete GSV cycles to the UI
+  // (when the UI does not keep up, the cycle published before is dropped and counted by the satellite store)
+  static uint8_t rxBuffer[128];
+
+  while (true)
+  {
+    size_t rxTotal = 0;
+    for (uint8_t m = 0; m < GPS_NUM_MODULES; m++)
+    {
+      if (!modules[m].started)
       {
-        Serial.println(); // line break
+        continue; // still looking for its baudrate (in loop())
       }
-      Serial.print(" 0x");
-      Serial.print(*pMem, HEX);
-      pMem++;
+      size_t rxLen = modules[m].gs.readBytes(rxBuffer, sizeof(rxBuffer));
+      for (size_t i = 0; i < rxLen; i++)
+      {
+        decodeNmeaChar(modules[m], rxBuffer[i]);
+      }
+      rxTotal += rxLen;
     }
-    Serial.println(); // final line break
 
-    // trap the error permanently until reset
-    if(trap)
+    if (rxTotal == 0)
     {
-      Serial.println(F("Trapped."));
-      while (true);
+      vTaskDelay(1); // nothing pending: sleep for a tick (the UART driver buffers in the meantime)
     }
   }
 }
+#endif
 
-void setup(void)
+#if GPS_BENCHMARK_MODE
+bool benchmarkChecksOk = true; // the fast scan/checksum kernels match the byte by byte ones (see runBenchmarks())
+
+bool runBenchmarks()
 {
-  unsigned int setupTime = millis();
-  // check the GPIO pin for the button to decide if the GPS module communication shall be fast or slow
-  // note: we could also have a selection menu here, but we'd definitely lose data during power-up of the GPS module
-  pinMode(ButtonPin, INPUT);
-  if (digitalRead(ButtonPin) == HIGH)
+  // times the hot paths with synthetic data as sent by a 10 Hz module at 115200 baud (per epoch: RMC, GGA and the GSV
+  // cycle of 12 satellites plus one UBX frame) and checks whether that load can be kept up with;
+  // the satellite tables and the GSV decoder are separate ones; returns false when the fast kernels do not match the
+  // byte by byte ones
+  static const uint8_t BenchEpochsPerSec = 10;
+  static const uint32_t BenchBaudRate = 115200;
+  static const uint8_t BenchNumSats = 12;
+  static const uint16_t BenchNumRuns = 200;
+  static const size_t BenchEpochBufferSize = 640;
+  static uint8_t epochBuffer[BenchEpochsPerSec][BenchEpochBufferSize];
+  static size_t epochLen[BenchEpochsPerSec];
+  static uint8_t checksumBuffer[256];
+  static uint8_t scanBuffer[256 + 16];
+  static uint8_t faultyEpoch[BenchEpochBufferSize];
+  static SatStore benchStore;
+  static GpsSoftwareSerial benchGs(GpsPorts[0].uartNum, GpsPorts[0].rxPin, GpsPorts[0].txPin); // only fed, never started
+  static GpsSoftwareSerial bytewiseGs(GpsPorts[0].uartNum, GpsPorts[0].rxPin, GpsPorts[0].txPin); // benchGs' twin, fed byte by byte
+  static GsvParser benchParser;
+  static BenchSampler inspectSampler("inspect()");
+  static BenchSampler checksumSampler("calcFletcherChecksum()");
+  static BenchSampler checksumScalarSampler("calcFletcherChecksumScalar()");
+  static BenchSampler scanSampler("findSyncChar()");
+  static BenchSampler scanSwarSampler("findSyncCharSwar()");
+  static BenchSampler scanScalarSampler("findSyncCharScalar()");
+  static BenchSampler gsvParserSampler("GsvParser::encode()");
+  static BenchSampler gsvSampler("collectGsvSats()");
+  static BenchSampler publishSampler("SatStore::publish()+acquire()");
+  static BenchSampler renderSampler("renderGraphics()");
+  static BenchSampler sendSampler("DisplayDiff::sendBuffer()");
+  static BenchSampler nmeaEpochSampler("NMEA epoch (inspect+GSV+collect)");
+  static BenchSampler ubxEpochSampler("UBX epoch (inspect+NAV-SVINFO)");
+  static UbxNavDecoder benchNav;
+  bench_sat_t benchSats[BenchNumSats];
+  uint32_t randomState = 0x4F425347; // "OBSG"
+  volatile uint16_t checksumSink;
+  const uint8_t* volatile scanSink;
+
+  Serial.println(F("Benchmarks (10 Hz module at 115200 baud):"));
+
+  // synthetic stream: one chunk per epoch
+  size_t streamLen = 0;
+  for (uint8_t i = 0; i < BenchEpochsPerSec; i++)
   {
-    fastBaudRate = true;
+    benchMakeSats(benchSats, BenchNumSats, &randomState);
+    epochLen[i] = benchMakeNmeaEpoch((char*)epochBuffer[i], BenchEpochBufferSize, benchSats, BenchNumSats, 45296 + i);
+    epochLen[i] += benchMakeUbxFrame(&epochBuffer[i][epochLen[i]], BenchEpochBufferSize - epochLen[i],
+                                     GpsSoftwareSerial::UBX_MSG_CLASS_NAV, 0x06, 52, &randomState); // NAV-SOL
+    streamLen += epochLen[i];
   }
-  else
+
+  // UBX/NMEA frame detection and UBX decoding, per byte
+  for (uint16_t run = 0; run < BenchNumRuns; run++)
   {
-    fastBaudRate = false;
+    uint8_t i = run % BenchEpochsPerSec;
+    inspectSampler.start();
+    benchGs.feed(epochBuffer[i], epochLen[i]);
+    inspectSampler.stop();
   }
+  inspectSampler.print(Serial, "byte", streamLen / BenchEpochsPerSec);
 
-  // start communication with GPS module (either fast or slow)
-  gs.begin(fastBaudRate ? GpsSerialBaudFast : GpsSerialBaudSlow);
-
-  // before setting anything else up, use the time directly after startup -- don't even setup the display before
-  // to check for serial activity (and try to find NMEA or UBX);
-  // only read from the serial, do not use the received data in the GPS NMEA decoder yet;
-  // the UBX-speaking modules dump some info on startup but are quiet from then on;
-  while (millis() <= (setupTime + 2000))
+  // GSV parsing, per byte (of all the stream)
+  for (uint16_t run = 0; run < BenchNumRuns; run++)
   {
-    // Dispatch incoming characters
-    if (gs.available() > 0)
+    uint8_t i = run % BenchEpochsPerSec;
+    gsvParserSampler.start();
+    for (size_t j = 0; j < epochLen[i]; j++)
     {
-      gs.read();
+      benchParser.encode(epochBuffer[i][j]);
     }
+    gsvParserSampler.stop();
   }
+  gsvParserSampler.print(Serial, "byte", streamLen / BenchEpochsPerSec);
 
-  // now it's time to setup the display and the UI
-  setupDisplay();
+  // UBX checksum, per byte
+  for (size_t i = 0; i < sizeof(checksumBuffer); i++)
+  {
+    checksumBuffer[i] = benchRandom(&randomState) & 0xFF;
+  }
+  for (uint16_t run = 0; run < BenchNumRuns; run++)
+  {
+    checksumSampler.start();
+    checksumSink = GpsSoftwareSerial::calcFletcherChecksum(checksumBuffer, sizeof(checksumBuffer));
+    checksumSampler.stop();
+  }
+  checksumSampler.print(Serial, "byte", sizeof(checksumBuffer));
+  for (uint16_t run = 0; run < BenchNumRuns; run++)
+  {
+    checksumScalarSampler.start();
+    checksumSink = GpsSoftwareSerial::calcFletcherChecksumScalar(checksumBuffer, sizeof(checksumBuffer));
+    checksumScalarSampler.stop();
+  }
+  (void)checksumSink;
+  checksumScalarSampler.print(Serial, "byte", sizeof(checksumBuffer));
 
-  // use hardware serial for logging
-  Serial.begin(115200);
-  Serial.print(F("Using TinyGPSPlus library v. ")); Serial.println(TinyGPSPlus::libraryVersion());
-  // log if we use fast or slow rate for communication with the GPS module
-  if (fastBaudRate)
+  // skipping to the next sync char, per byte (of noise w/o any, i.e. all of it is scanned)
+  for (size_t i = 0; i < sizeof(scanBuffer); i++)
+  {
+    do
+    {
+      scanBuffer[i] = benchRandom(&randomState) & 0xFF;
+    } while (scanBuffer[i] == 0xB5 || scanBuffer[i] == '$');
+  }
+  for (uint16_t run = 0; run < BenchNumRuns; run++)
   {
-    Serial.print(F("Using fast (="));
-    Serial.print(GpsSerialBaudFast);
+    scanSampler.start();
+    scanSink = GpsSoftwareSerial::findSyncChar(scanBuffer, 256);
+    scanSampler.stop();
+    scanSwarSampler.start();
+    scanSink = GpsSoftwareSerial::findSyncCharSwar(scanBuffer, 256);
+    scanSwarSampler.stop();
+    scanScalarSampler.start();
+    scanSink = GpsSoftwareSerial::findSyncCharScalar(scanBuffer, 256);
+    scanScalarSampler.stop();
+  }
+  (void)scanSink;
+  scanSampler.print(Serial, "byte", 256);
+  scanSwarSampler.print(Serial, "byte", 256);
+  scanScalarSampler.print(Serial, "byte", 256);
+
+  // the fast kernels against the byte by byte ones: random lengths and alignments w/ a few sync chars sprinkled in,
+  // and the (partly corrupted) stream fed in one go vs. one byte per call (the protocol metrics have to match)
+  uint16_t kernelMismatches = 0;
+  for (uint16_t run = 0; run < 1000; run++)
+  {
+    size_t offset = benchRandom(&randomState) % 16;
+    size_t len = benchRandom(&randomState) % (sizeof(scanBuffer) - offset + 1);
+    for (size_t i = 0; i < sizeof(scanBuffer); i++)
+    {
+      uint32_t r = benchRandom(&randomState);
+      scanBuffer[i] = ((r >> 8) % 64 == 0) ? (((r >> 16) & 1) ? 0xB5 : '$') : (r & 0xFF);
+    }
+    const uint8_t* pExpected = GpsSoftwareSerial::findSyncCharScalar(&scanBuffer[offset], len);
+    if (GpsSoftwareSerial::findSyncChar(&scanBuffer[offset], len) != pExpected ||
+        GpsSoftwareSerial::findSyncCharSwar(&scanBuffer[offset], len) != pExpected ||
+        GpsSoftwareSerial::calcFletcherChecksum(&scanBuffer[offset], len) !=
+            GpsSoftwareSerial::calcFletcherChecksumScalar(&scanBuffer[offset], len))
+    {
+      kernelMismatches++;
+    }
+  }
+  for (uint8_t i = 0; i < BenchEpochsPerSec; i++)
+  {
+    uint32_t bytewiseBefore[5] = {bytewiseGs.getNmeaSentenceCount(), bytewiseGs.getNmeaChecksumErrorCount(),
+                                  bytewiseGs.getUbxFrameCount(), bytewiseGs.getUbxChecksumErrorCount(),
+                                  bytewiseGs.getResyncCount()};
+    memcpy(faultyEpoch, epochBuffer[i], epochLen[i]);
+    for (uint8_t j = 0; j < i; j++)
+    {
+      faultyEpoch[benchRandom(&randomState) % epochLen[i]] ^= 1 << (j % 8);
+    }
+    uint32_t before[5] = {benchGs.getNmeaSentenceCount(), benchGs.getNmeaChecksumErrorCount(),
+                          benchGs.getUbxFrameCount(), benchGs.getUbxChecksumErrorCount(), benchGs.getResyncCount()};
+    benchGs.feed(faultyEpoch, epochLen[i]);
+    for (size_t j = 0; j < epochLen[i]; j++)
+    {
+      bytewiseGs.feed(&faultyEpoch[j], 1);
+    }
+    uint32_t counts[2][5] = {
+      {benchGs.getNmeaSentenceCount() - before[0], benchGs.getNmeaChecksumErrorCount() - before[1],
+       benchGs.getUbxFrameCount() - before[2], benchGs.getUbxChecksumErrorCount() - before[3],
+       benchGs.getResyncCount() - before[4]},
+      {bytewiseGs.getNmeaSentenceCount() - bytewiseBefore[0], bytewiseGs.getNmeaChecksumErrorCount() - bytewiseBefore[1],
+       bytewiseGs.getUbxFrameCount() - bytewiseBefore[2], bytewiseGs.getUbxChecksumErrorCount() - bytewiseBefore[3],
+       bytewiseGs.getResyncCount() - bytewiseBefore[4]}};
+    if (memcmp(counts[0], counts[1], sizeof(counts[0])) != 0)
+    {
+      kernelMismatches++;
+    }
+  }
+  Serial.print(F("Scan/checksum kernels vs. byte by byte: "));
+  if (kernelMismatches == 0)
+  {
+    Serial.println(F("OK"));
   }
   else
   {
-    Serial.print(F("Using slow (="));
-    Serial.print(GpsSerialBaudSlow);
+    Serial.print(kernelMismatches);
+    Serial.println(F(" MISMATCHES!"));
   }
-  Serial.println(F(") baudrate w/ GPS module."));
 
-  gsStartupRxCount = gs.getRxCount();
-  Serial.print(F("Rx'ed no. of bytes during startup: "));
-  Serial.println(gsStartupRxCount);
+  // taking over the satellites of each (decoded) $GPGSV sentence into the ranked satellite table, handing the GSV
+  // cycle over and drawing it, with a different satellite table each time
+  uint8_t gsvPerEpoch = (BenchNumSats + 3) / 4;
+  char gsvSentence[96];
+  unsigned long displayBytesBefore = displayDiff.getBytesSent();
+  for (uint16_t run = 0; run < BenchNumRuns; run++)
+  {
+    benchMakeSats(benchSats, BenchNumSats, &randomState);
+    for (uint8_t msg = 1; msg <= gsvPerEpoch; msg++)
+    {
+      size_t gsvLen = benchMakeGsvSentence(gsvSentence, sizeof(gsvSentence), benchSats, BenchNumSats, msg);
+      for (size_t i = 0; i < gsvLen; i++)
+      {
+        benchParser.encode(gsvSentence[i]);
+      }
+      gsvSampler.start();
+      collectGsvSats(benchParser, benchStore);
+      gsvSampler.stop();
+    }
 
-  drawSplashScreen(1);
+    publishSampler.start();
+    benchStore.publish();
+    const sat_epoch_t* pEpoch = benchStore.acquire();
+    publishSampler.stop();
+
+    renderSampler.start();
+    renderGraphics(modules[0], *pEpoch);
+    renderSampler.stop();
+
+    sendSampler.start();
+    displayDiff.sendBuffer();
+    sendSampler.stop();
+  }
+  gsvSampler.print(Serial, "sentence", 1);
+  publishSampler.print(Serial, "call", 1);
+  renderSampler.print(Serial, "frame", 1);
+  sendSampler.print(Serial, "frame", 1);
+  Serial.print(F("Display: "));
+  Serial.print((displayDiff.getBytesSent() - displayBytesBefore) / BenchNumRuns);
+  Serial.print(F(" bytes/frame sent of "));
+  Serial.println(displayDiff.getFrameSize());
+
+  // budget: RX processing per second and the per-epoch work (worst case, i.e. p99) within one epoch period
+  double ticksPerSec = BenchSampler::ticksPerUs() * 1e6;
+  double rxLoad = ((double)inspectSampler.getPercentile(99) + gsvParserSampler.getPercentile(99)) * BenchEpochsPerSec /
+                  ticksPerSec;
+  double epochLoad = ((double)gsvSampler.getPercentile(99) * gsvPerEpoch + publishSampler.getPercentile(99) +
+                      renderSampler.getPercentile(99) + sendSampler.getPercentile(99)) * BenchEpochsPerSec / ticksPerSec;
+  Serial.print(F("Stream: "));
+  Serial.print(streamLen);
+  Serial.print(F(" bytes/s of "));
+  Serial.print(BenchBaudRate / 10);
+  Serial.println(F(" bytes/s max."));
+  Serial.print(F("CPU load at 10 Hz (p99): RX "));
+  Serial.print(rxLoad * 100.0, 2);
+  Serial.print(F(" %, GSV+publish+render+send "));
+  Serial.print(epochLoad * 100.0, 2);
+  Serial.println(F(" %"));
+  Serial.println((rxLoad + epochLoad < 1.0) ? F("Keeps up with 10 Hz.") : F("Does NOT keep up with 10 Hz!"));
+
+  // the same satellites as NMEA text and as UBX NAV-SVINFO (UBX navigation mode), from the wire to the satellite table;
+  // the NMEA epoch has RMC, GGA and GSV only, a module usually sends GSA, GLL and VTG on top
+  static uint8_t svInfoFrame[UbxNavDecoder::FRAMING_LEN + UbxNavDecoder::SVINFO_HEADER_LEN +
+                             BenchNumSats * UbxNavDecoder::SVINFO_BLOCK_LEN];
+  size_t nmeaEpochLen = 0;
+  size_t ubxEpochLen = 0;
+  for (uint16_t run = 0; run < BenchNumRuns; run++)
+  {
+    benchMakeSats(benchSats, BenchNumSats, &randomState);
+    nmeaEpochLen = benchMakeNmeaEpoch((char*)epochBuffer[0], BenchEpochBufferSize, benchSats, BenchNumSats, 45296);
+    ubxEpochLen = benchMakeSvInfoFrame(svInfoFrame, sizeof(svInfoFrame), benchSats, BenchNumSats, 45296000);
+
+    nmeaEpochSampler.start();
+    benchGs.feed(epochBuffer[0], nmeaEpochLen);
+    for (size_t i = 0; i < nmeaEpochLen; i++)
+    {
+      if (benchParser.encode(epochBuffer[0][i]) & GsvParser::GSV_EVENT_SENTENCE)
+      {
+        collectGsvSats(benchParser, benchStore);
+      }
+    }
+    nmeaEpochSampler.stop();
+    benchStore.discard();
+
+    ubxEpochSampler.start();
+    benchGs.feed(svInfoFrame, ubxEpochLen);
+    benchNav.decode(svInfoFrame[2], svInfoFrame[3], &svInfoFrame[6], ubxEpochLen - UbxNavDecoder::FRAMING_LEN,
+                   benchStore);
+    ubxEpochSampler.stop();
+    benchStore.discard();
+  }
+  nmeaEpochSampler.print(Serial, "byte", nmeaEpochLen);
+  ubxEpochSampler.print(Serial, "byte", ubxEpochLen);
+  Serial.print(F("Bytes/epoch: NMEA "));
+  Serial.print(nmeaEpochLen);
+  Serial.print(F(", UBX "));
+  Serial.print(ubxEpochLen);
+  Serial.print(F("; max. rate at 9600 baud: NMEA "));
+  Serial.print(960 / nmeaEpochLen);
+  Serial.print(F(" Hz, UBX "));
+  Serial.print(UbxNavDecoder::getMaxRateHz(9600, BenchNumSats, 100));
+  Serial.println(F(" Hz"));
+  return kernelMismatches == 0;
+}
+#endif
 
-  // Initialize all the uninitialized TinyGPSCustom objects
-  for (int i = 0; i < 4; ++i)
+uint8_t countUbxPollsAnswered(GpsModule& m)
+{
+  uint8_t numAnswered = 0;
+  for (uint8_t i = 0; i < GpsSoftwareSerial::UBX_MSG_NUM; i++)
   {
-    gpsSatNumber[i].begin(gps, "GPGSV", 4 + 4 * i);
-    gpsElevation[i].begin(gps, "GPGSV", 5 + 4 * i);
-    gpsAzimuth[i].begin(gps, "GPGSV", 6 + 4 * i);
-    gpsSnr[i].begin(gps, "GPGSV", 7 + 4 * i);
+    uint8_t id = findUbxPollRequest(m, i);
+    if (id != UbxEngine::NO_REQUEST && (m.ubxEngine.getRequest(id).state == UbxEngine::REQ_ANSWERED ||
+                                        m.ubxEngine.getRequest(id).state == UbxEngine::REQ_ACKED))
+    {
+      numAnswered++;
+    }
   }
+  return numAnswered;
+}
 
-  for (int i = 0; i < MAX_SATELLITES; ++i)
+void onTestPollsDone(GpsModule& m)
+{
+  // all UBX polls of the test are through (see checkUbxPolls())
+  m.testPollsAnswered = countUbxPollsAnswered(m);
+  m.testPollsDone = true;
+}
+
+void refreshResultScreen()
+{
+  // scheduled once there is a verdict for all modules (the GPS serial is still drained, the diagnostics go on)
+  if (uiStatusPage < 0)
   {
-    sats[i].no = -1;
-    sats[i].active = false;
+    drawResultScreen();
   }
+}
 
-  u8g2.setFont(smallTextFont);
+bool allTestsFinished()
+{
+  for (uint8_t i = 0; i < GPS_NUM_MODULES; i++)
+  {
+    if (modules[i].testPlan.getVerdict() == TestPlan::VERDICT_PENDING)
+    {
+      return false;
+    }
+  }
+  return true;
 }
 
-void loop(void)
+void finishTest(GpsModule& m)
 {
-  static bool parsedNmeaDataAvailable = false;
-  static const int downsamplingFactor = 1; // base rate usually is 1 Hz, i.e. every second
-  static int downsampleCounter = downsamplingFactor - 1;
+  // verdict: the diagnostics, the raw RX capture when the test failed (or there were errors in the RX stream), the
+  // result line last (for a test jig reading the debug serial); the result screen until reset once all modules are
+  // through
+  printModuleHeading(m);
+  Serial.print(F("Test "));
+  Serial.print((m.testPlan.getVerdict() == TestPlan::VERDICT_PASS) ? F("passed") : F("failed"));
+  Serial.print(F(" after "));
+  Serial.print(m.testPlan.getDurationMs());
+  Serial.println(F(" ms."));
+  checkCommunication(m);
+  if (m.testPlan.getVerdict() == TestPlan::VERDICT_FAIL || m.gs.getRecorder().isTriggered())
+  {
+    dumpRxCapture(m);
+  }
+  m.testPlan.printResult(Serial, (GPS_NUM_MODULES > 1) ? m.num : 0);
 
-  // Dispatch incoming characters from the GPS serial
-  if (gs.available() > 0)
+  if (allTestsFinished())
   {
-    gps.encode(gs.read());
+    scheduler.cancel(testTaskId);
+    testPhase = PHASE_RESULT;
+    uiStatusPage = -1;
+    scheduler.every(ResultScreenRefreshMs, refreshResultScreen, 0);
+  }
+}
 
-    if (totalGPGSVMessages.isUpdated())
+void testTask()
+{
+  // evaluate the test plans' checks with what has been measured so far (of the modules w/o a verdict yet)
+  for (uint8_t i = 0; i < GPS_NUM_MODULES; i++)
+  {
+    GpsModule& m = modules[i];
+    if (m.testPlan.getVerdict() != TestPlan::VERDICT_PENDING)
+    {
+      continue;
+    }
+    TestPlan::test_status_t status;
+    status.linkSeen = m.gs.hasSeenUbx() || m.gs.hasSeenNmea();
+    status.nmeaSentences = m.gs.getNmeaSentenceCount();
+    status.strongSats = m.strongSats;
+    status.ubxPollsDone = m.testPollsDone;
+    status.ubxAnswered = m.testPollsAnswered;
+    status.fix = m.fixAvailable;
+    status.errors = m.gs.getNmeaChecksumErrorCount() + m.gs.getUbxChecksumErrorCount() +
+                    m.gs.getUbxLengthErrorCount() + m.gs.getRxOverflowCount();
+    if (m.testPlan.update(status, millis()) != TestPlan::VERDICT_PENDING)
     {
-      parsedNmeaDataAvailable = true;
+      finishTest(m);
+    }
+  }
+}
 
-      // four satellites per message
-      for (int i = 0; i < 4; ++i)
-      {
-        int no = atoi(gpsSatNumber[i].value());
-        if (no >= 1 && no <= MAX_SATELLITES)
+#if GPS_TTFF_MODE
+void ttffTask()
+{
+  // the TTFF runs of each module: the reset when a run starts, its results when it is through, the summary at the end
+  uint32_t nowMs = millis();
+  for (uint8_t i = 0; i < GPS_NUM_MODULES; i++)
+  {
+    GpsModule& m = modules[i];
+    if (!m.started)
+    {
+      continue;
+    }
+    switch (m.ttff.update(nowMs))
+    {
+      case TtffBench::ACTION_RESET:
+        printModuleTag(m);
+        Serial.print(F("TTFF: "));
+        Serial.print(TtffBench::getStartName(m.ttff.getStartType()));
+        Serial.print(F(" start, run "));
+        Serial.print(m.ttff.getRunNumber());
+        Serial.print(F("/"));
+        Serial.println(m.ttff.getRunsPerType());
+        m.ttffResetId = TtffBench::submitReset(m.ubxEngine, m.ttff.getStartType());
+        if (m.ttffResetId == UbxEngine::NO_REQUEST)
         {
-          int elev = atoi(gpsElevation[i].value());
-          int azimuth = atoi(gpsAzimuth[i].value());
-          int snr = atoi(gpsSnr[i].value());
-          sats[no - 1].no = no;
-          sats[no - 1].active = true;
-          sats[no - 1].elevation = elev;
-          sats[no - 1].azimuth = azimuth;
-          sats[no - 1].snr = snr;
+          Serial.println(F("Unable to send CFG-RST."));
         }
-      }
-
-      int totalMessages = atoi(totalGPGSVMessages.value());
-      int currentMessage = atoi(messageNumber.value());
+        m.ubxEngine.update(); // send it right away (unless the window is full)
+        break;
+      case TtffBench::ACTION_RUN_DONE:
+        m.ttff.printRun(Serial, (GPS_NUM_MODULES > 1) ? m.num : 0);
+        if (m.ttff.isDone())
+        {
+          printModuleHeading(m);
+          m.ttff.printSummary(Serial, (GPS_NUM_MODULES > 1) ? m.num : 0);
+        }
+        break;
+      default:
+        break;
+    }
 
-      if (totalMessages == currentMessage)
+    // the run is timed from the sending of CFG-RST, which may have waited for room in the window; its slot is free
+    // once it is through
+    if (m.ttffResetId != UbxEngine::NO_REQUEST && m.ubxEngine.isDone(m.ttffResetId))
+    {
+      const UbxEngine::ubx_request_t& req = m.ubxEngine.getRequest(m.ttffResetId);
+      if (req.state == UbxEngine::REQ_SENT)
       {
-        // make sure we do not draw and print to the console and draw too often
-        ++downsampleCounter;
-        if ( downsampleCounter == downsamplingFactor )
-        {
-          downsampleCounter = 0;
+        m.ttff.onResetSent(millis() - (micros() - req.sentUs) / 1000);
+      }
+      m.ubxEngine.release(m.ttffResetId);
+      m.ttffResetId = UbxEngine::NO_REQUEST;
+    }
+  }
+}
 
-          // get a copy for sorting and set all satellites back to inactive until seen again
-          memcpy(sortedSats, sats, sizeof(sats));
-          for (int i = 0; i < MAX_SATELLITES; ++i)
-          {
-            sats[i].active = false;
-          }
+void refreshTtffScreen()
+{
+  if (uiStatusPage < 0)
+  {
+    drawTtffScreen(modules[uiModule]);
+  }
+}
+#endif
 
-          int numActiveSats = sortSats();
+void refreshStatusPage(GpsModule& m)
+{
+  // after polls triggered with the button: the answers are in (or have timed out)
+  if (uiStatusPage >= 0 && &m == &modules[uiModule])
+  {
+    showUiPage(m, uiStatusPage);
+  }
+}
 
-          // uncomment for verbose log messages
-          //printSatInfo(numActiveSats);
+void metricsTask()
+{
+  // sample the metrics (of each module), report them on the debug serial and refresh the metrics page (when it is shown)
+  uint32_t nowMs = millis();
+  for (uint8_t i = 0; i < GPS_NUM_MODULES; i++)
+  {
+    const GpsMetrics::metrics_record_t& record = modules[i].metrics.sample(nowMs);
+#if GPS_METRICS_OUTPUT == 1
+    GpsMetrics::printCsv(Serial, record);
+#elif GPS_METRICS_OUTPUT == 2
+    GpsMetrics::writeBinary(Serial, record);
+#endif
+    if (i == uiModule && isMetricsPage(uiStatusPage))
+    {
+      drawMetricsPage(modules[i], record);
+    }
+  }
+}
 
-          countValidAzEls(numActiveSats, sortedSats);
+void handleButtonEvents()
+{
+  // short press: next screen (the constellation view, the result screen or the TTFF screen, the UBX status pages, then
+  // the metrics page;
+  // with several modules, then the same for the next module); long press: poll the UBX messages of the status page
+  // shown (of the first page when on another screen)
+  static uint32_t pressedUs = 0;
+  static bool pressSeen = false; // the button may still be held from power-up (fast baudrate)
+  Button::button_event_t event;
+
+  while (button.getEvent(&event))
+  {
+    if (event.pressed)
+    {
+      pressedUs = event.timeUs;
+      pressSeen = true;
+      continue;
+    }
+    if (!pressSeen || testPhase == PHASE_STARTUP)
+    {
+      continue;
+    }
+    pressSeen = false;
 
-          drawGraphics(numActiveSats, sortedSats);
-        }
+    if ((uint32_t)(event.timeUs - pressedUs) >= LongPressMs * 1000)
+    {
+      if (uiStatusPage < 0 || isMetricsPage(uiStatusPage))
+      {
+        uiStatusPage = 0;
+      }
+      GpsModule& m = modules[uiModule];
+      printModuleTag(m);
+      Serial.print(F("Button: poll status page "));
+      Serial.println(uiStatusPage + 1);
+      if (!m.started)
+      {
+        Serial.println(F("Baudrate detection still running."));
+      }
+      else if (!pollMultiUbx(m, uiStatusPage, refreshStatusPage))
+      {
+        Serial.println(F("UBX polls still running."));
+      }
+      showUbxMessageStatus(m, uiStatusPage);
+    }
+    else
+    {
+      if (++uiStatusPage > numUbxStatusPages())
+      {
+        uiStatusPage = -1;
+        uiModule = (uiModule + 1) % GPS_NUM_MODULES;
+      }
+      GpsModule& m = modules[uiModule];
+      if (uiStatusPage >= 0)
+      {
+        showUiPage(m, uiStatusPage);
+      }
+#if GPS_TTFF_MODE
+      else
+      {
+        drawTtffScreen(m);
+      }
+#else
+      else if (testPhase == PHASE_RESULT)
+      {
+        drawResultScreen();
+      }
+      else if (m.pEpoch != nullptr)
+      {
+        drawGraphics(m, *m.pEpoch);
       }
+#endif
     }
   }
+}
+
+void printAutobaudResult(GpsModule& m)
+{
+  printModuleHeading(m);
+  Serial.print(F("Baudrate detection ("));
+  Serial.print(m.gs.getAutobaudMs());
+  Serial.println(F(" ms), valid frames score per rate:"));
+  for (uint8_t i = 0; i < m.gs.getAutobaudNumTried(); i++)
+  {
+    Serial.print(F("  "));
+    Serial.print(m.gs.getAutobaudRate(i));
+    Serial.print(F(": "));
+    Serial.println(m.gs.getAutobaudScore(i));
+  }
+  if (m.gs.getAutobaudState() == GpsSoftwareSerial::AUTOBAUD_FAILED)
+  {
+    Serial.print(F("No baudrate detected, staying at "));
+  }
+  else
+  {
+    Serial.print(F("Using detected baudrate "));
+  }
+  Serial.print(m.gs.getBaudRate());
+  Serial.println(F(" w/ GPS module."));
+
+  switch (m.gs.getUpshiftResult())
+  {
+    case GpsSoftwareSerial::UPSHIFT_DONE:
+      Serial.print(F("Upshift confirmed, receiving "));
+      Serial.print(m.gs.getUpshiftThroughput());
+      Serial.print(F(" bytes/s of "));
+      Serial.print(m.gs.getBaudRate() / 10);
+      Serial.println(F(" bytes/s max."));
+      break;
+    case GpsSoftwareSerial::UPSHIFT_NO_ANSWER:
+      Serial.println(F("Upshift skipped: no answer to the CFG-PRT poll."));
+      break;
+    case GpsSoftwareSerial::UPSHIFT_NOT_CONFIRMED:
+      Serial.println(F("Upshift failed: no valid frames at the new baudrate."));
+      break;
+    default:
+      break;
+  }
+}
+
+bool isAutobaudDone(GpsModule& m)
+{
+  GpsSoftwareSerial::AutobaudState state = m.gs.getAutobaudState();
+  return state == GpsSoftwareSerial::AUTOBAUD_OFF || state == GpsSoftwareSerial::AUTOBAUD_LOCKED ||
+         state == GpsSoftwareSerial::AUTOBAUD_FAILED;
+}
 
-  // check for connection errors; poll UBX messages to see what message subset the GPS module supports
-  const uint32_t firstComCheckTimeMs = 9000;
-  const uint32_t comCheckIntervalMs = 6000;
-  if (millis() > firstComCheckTimeMs)
+void startModule(GpsModule& m)
+{
+  // its baudrate detection is done: the module's test starts on its own, so that a missing or dead module (which
+  // scans all rates) only delays itself
+  printAutobaudResult(m);
+  m.startupRxCount = m.gs.getRxCount();
+  Serial.print(F("Rx'ed no. of bytes during startup: "));
+  Serial.println(m.startupRxCount);
+  Serial.print(F("RX recorder: "));
+  Serial.print(m.gs.getRecorder().getSize());
+  Serial.print(F(" bytes"));
+  Serial.println((&m == &modules[0] && pRxSpill != nullptr) ? F(" plus spill") : F(""));
+  if (&m == &modules[0])
   {
-    static int checkCount = 0;
+    fastBaudRate = (m.gs.getBaudRate() >= (long)GpsSerialBaudFast);
+  }
+
+  m.ubxEngine.setWindow(UbxPollWindow);
+  m.ubxEngine.setTimeout(UbxPollTimeoutMs, UbxPollRetries);
+  m.ubxEngine.begin(); // before the RX task (pipeline mode) gets to the module and calls the UBX handlers
+#if GPS_TTFF_MODE
+  // the module's own fix status along w/ the epochs, the first reset follows right away (see ttffTask())
+  m.gs.addUbxHandler(GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_STATUS, onUbxNavStatus, &m);
+  TtffBench::submitStatusOutput(m.ubxEngine);
+  m.ttffResetId = UbxEngine::NO_REQUEST;
+  m.ttff.begin(TtffConfig);
+#else
+  // poll all UBX messages to see what message subset the GPS module supports (the status pages show the answers)
+  pollMultiUbx(m, -1, onTestPollsDone);
+#endif
+#if GPS_UBX_NAV_MODE
+  m.gs.addUbxHandler(GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_ANY, onUbxNavFrame, &m);
+  startUbxNavConfig(m);
+#endif
+  m.started = true; // from now on, what it sends is decoded (by the RX task in pipeline mode)
+}
 
-    if (checkCount == 0)
+void startUi()
+{
+  // end of PHASE_STARTUP: now it's time to setup the display and the UI
+  setupDisplay();
+
+  // use hardware serial for logging
+  Serial.begin(115200);
+  Serial.print(F("Using TinyGPSPlus library v. ")); Serial.println(TinyGPSPlus::libraryVersion());
+  if (isAutobaudDone(modules[0]))
+  {
+    fastBaudRate = (modules[0].gs.getBaudRate() >= (long)GpsSerialBaudFast);
+  }
+
+  button.begin();
+
+  drawSplashScreen(1);
+
+#if DISPLAY_ASYNC
+  // from now on, only the transfer task talks to the display
+  if (!displayDiff.beginAsync(DisplayTaskPriority, DisplayTaskCore))
+  {
+    Serial.println(F("Display transfers stay synchronous."));
+  }
+#endif
+
+  u8g2.setFont(smallTextFont);
+
+#if GPS_BENCHMARK_MODE
+  benchmarkChecksOk = runBenchmarks();
+#endif
+
+  // the modules whose baudrate detection is done start their test right away, the others once theirs is (see loop())
+  for (uint8_t i = 0; i < GPS_NUM_MODULES; i++)
+  {
+    if (isAutobaudDone(modules[i]))
     {
-      Serial.println("Coms check #1");
-      checkCommunication(parsedNmeaDataAvailable, /*trap=*/false);
-      pollMultiUbx(0);
-      checkCount++;
+      startModule(modules[i]);
     }
+  }
+
+#if GPS_PIPELINE_MODE
+  // from now on the RX task owns the GPS serials' RX side and the NMEA decoders
+  xTaskCreatePinnedToCore(rxTask, "gpsRx", RxTaskStackSize, nullptr, RxTaskPriority, nullptr, RxTaskCore);
+#endif
 
-    if (millis() > (firstComCheckTimeMs + comCheckIntervalMs) && checkCount == 1)
+  // metrics from now on: the first sample covers the time since then
+  uint32_t nowMs = millis();
+  for (uint8_t i = 0; i < GPS_NUM_MODULES; i++)
+  {
+    modules[i].metrics.begin(nowMs);
+  }
+#if GPS_METRICS_OUTPUT == 1
+  GpsMetrics::printCsvHeader(Serial);
+#elif GPS_METRICS_OUTPUT == 2
+  Serial.println(F("Metrics: binary records (see host/build/metrics_dump)."));
+#endif
+  scheduler.every(MetricsIntervalMs, metricsTask, MetricsIntervalMs);
+
+#if GPS_TTFF_MODE
+  // TTFF runs instead of the pass/fail test
+  scheduler.every(TtffStepMs, ttffTask, 0);
+  scheduler.every(TtffScreenRefreshMs, refreshTtffScreen, 0);
+#else
+  // the checks are evaluated from now on, the test ends as soon as there is a verdict
+  testTaskId = scheduler.every(TestCheckIntervalMs, testTask, 0);
+#endif
+  testPhase = PHASE_RUNNING;
+}
+
+void setup(void)
+{
+  // the test plans' timeouts count from power-up
+  for (uint8_t i = 0; i < GPS_NUM_MODULES; i++)
+  {
+    modules[i].testPlan.begin(TestCriteria, millis());
+  }
+
+  // check the GPIO pin for the button to decide if the GPS module communication shall be fast or slow
+  // note: we could also have a selection menu here, but we'd definitely lose data during power-up of the GPS module
+  pinMode(ButtonPin, INPUT);
+  if (digitalRead(ButtonPin) == HIGH)
+  {
+    fastBaudRate = true;
+  }
+  else
+  {
+    fastBaudRate = false;
+  }
+
+  // record everything received from the GPS modules from now on (the latest bytes, see dumpRxCapture())
+#if GPS_RX_SPILL == 1
+  if (psramFound())
+  {
+    static RamRxSpill psramSpill((uint8_t*)ps_malloc(RxSpillPsramSize), RxSpillPsramSize);
+    pRxSpill = &psramSpill;
+  }
+#elif GPS_RX_SPILL == 2
+  static FlashRxSpill flashSpill(esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                          RxSpillPartition));
+  pRxSpill = &flashSpill;
+#endif
+  for (uint8_t i = 0; i < GPS_NUM_MODULES; i++)
+  {
+    GpsModule& m = modules[i];
+    m.gs.getRecorder().setTriggers(RxRecorderTriggers, RxRecorderPostTrigger);
+    m.gs.getRecorder().begin(m.rxRecorderMem, sizeof(m.rxRecorderMem), (i == 0) ? pRxSpill : nullptr);
+  }
+
+  // start communication with the GPS modules: find their baudrates (starting either fast or slow) and optionally speed
+  // them up
+  for (uint8_t i = 0; i < GPS_NUM_MODULES; i++)
+  {
+    modules[i].gs.beginAutobaud(fastBaudRate ? GpsSerialBaudFast : GpsSerialBaudSlow, AutobaudDwellMs,
+                                GPS_UPSHIFT_BAUD);
+  }
+
+  // before setting anything else up, use the time directly after startup -- don't even setup the display before
+  // to check for serial activity (and try to find NMEA or UBX); see PHASE_STARTUP in loop()
+  startupListen.start(StartupListenMs);
+}
+
+void loop(void)
+{
+  bool epochComplete = false;
+
+  if (testPhase == PHASE_STARTUP)
+  {
+    // the baudrate detection reads on its own until it is done (or gives up); then only read from the serial, do
+    // not use the received data in the GPS NMEA decoder yet; the UBX-speaking modules dump some info on startup but are
+    // quiet from then on; the UI starts w/ the first module whose baudrate is known (the others join later)
+    static uint8_t rxBuffer[128];
+    bool autobaudDone = false;
+    for (uint8_t i = 0; i < GPS_NUM_MODULES; i++)
+    {
+      if (!modules[i].gs.updateAutobaud())
+      {
+        autobaudDone = true;
+        modules[i].gs.readBytes(rxBuffer, sizeof(rxBuffer));
+      }
+    }
+    if (autobaudDone && startupListen.hasExpired())
     {
-      Serial.println("Coms check #2");
-      showUbxMessageStatus(0);
-      checkCommunication(parsedNmeaDataAvailable, /*trap=*/false); // don't trap yet
-      pollMultiUbx(1);
-      checkCount++;
+      startupListen.stop();
+      startUi();
     }
+    return;
+  }
+  uint32_t loopStartUs = micros();
 
-    if (millis() > (firstComCheckTimeMs + 2 * comCheckIntervalMs) && checkCount == 2)
+  // modules still looking for their baudrate: their test starts once it is found (or given up)
+  for (uint8_t i = 0; i < GPS_NUM_MODULES; i++)
+  {
+    if (!modules[i].started && !modules[i].gs.updateAutobaud())
     {
-      Serial.println("Coms check #3");
-      showUbxMessageStatus(1);
-      checkCommunication(parsedNmeaDataAvailable, /*trap=*/false); // still don't trap...
-      pollMultiUbx(2);
-      checkCount++;
+      startModule(modules[i]);
     }
+  }
 
-    if (millis() > (firstComCheckTimeMs + 3 * comCheckIntervalMs) && checkCount == 3)
+#if GPS_PIPELINE_MODE
+  // the RX task does all the receiving and decoding; draw the latest complete GSV cycle (if there's a new one)
+#else
+  // Dispatch all pending characters from the GPS serials before anything gets drawn
+  // (drawing takes long enough for the UART buffers to fill up at higher baudrates)
+  static uint8_t rxBuffer[128];
+  for (uint8_t i = 0; i < GPS_NUM_MODULES; i++)
+  {
+    if (!modules[i].started)
+    {
+      continue;
+    }
+    size_t rxLen;
+    while ((rxLen = modules[i].gs.readBytes(rxBuffer, sizeof(rxBuffer))) > 0)
     {
-      Serial.println("Coms check #4");
-      showUbxMessageStatus(2);
-      checkCommunication(parsedNmeaDataAvailable, /*trap=*/false); // still don't trap...
-      pollMultiUbx(3);
-      checkCount++;
+      for (size_t j = 0; j < rxLen; j++)
+      {
+        decodeNmeaChar(modules[i], rxBuffer[j]);
+      }
+    }
+  }
+#endif
+  // when several GSV cycles came in at once, only the latest one is used
+  for (uint8_t i = 0; i < GPS_NUM_MODULES; i++)
+  {
+    GpsModule& m = modules[i];
+    const sat_epoch_t* pEpoch = m.satStore.acquire();
+    if (pEpoch == nullptr)
+    {
+      continue;
+    }
+    m.pEpoch = pEpoch;
+#if GPS_TTFF_MODE
+    m.ttff.onEpoch(*pEpoch, millis());
+#endif
+    m.strongSats = 0;
+    for (uint8_t j = 0; j < pEpoch->numSats; j++)
+    {
+      if (pEpoch->snr[j] >= TestCriteria.minSnr)
+      {
+        m.strongSats++;
+      }
+    }
+    if (i == uiModule)
+    {
+      epochComplete = true;
     }
+  }
+#if GPS_PIPELINE_MODE
+  if (!epochComplete)
+  {
+    delay(1); // leave the core to others while there's nothing to draw
+  }
+#endif
 
-    if (millis() > (firstComCheckTimeMs + 4 * comCheckIntervalMs) && checkCount == 4)
+  // UBX poll requests and their answers, screens switched with the button
+  for (uint8_t i = 0; i < GPS_NUM_MODULES; i++)
+  {
+    if (modules[i].started)
     {
-      Serial.println("Coms check #5");
-      showUbxMessageStatus(3);
-      checkCommunication(parsedNmeaDataAvailable, /*trap=*/true); // finally trap...
-      checkCount++;
+      checkUbxPolls(modules[i]);
     }
   }
+  handleButtonEvents();
+
+  // the constellation view (of the module chosen with the button), unless a status page or the result screen is shown
+  // (TTFF mode: the TTFF screen instead, see refreshTtffScreen())
+  GpsModule& shown = modules[uiModule];
+  if (!GPS_TTFF_MODE && epochComplete && shown.pEpoch != nullptr && testPhase == PHASE_RUNNING && uiStatusPage < 0)
+  {
+    // uncomment for verbose log messages
+    //printSatInfo(*shown.pEpoch);
+
+    drawGraphics(shown, *shown.pEpoch);
+  }
+
+  // the test plans' checks, result screen updates, metrics
+  scheduler.run();
+
+  modules[0].metrics.recordLoop(micros() - loopStartUs);
 }
@@ -0,0 +1,132 @@
+#include "RenderCache.h"
+
+namespace
+{
+  // sine of 0..90 degrees in Q14, computed at compile time (Taylor series)
+  constexpr double sinSeries(double x2, double term, double sum, int k)
+  {
+    return (k > 12) ? sum : sinSeries(x2, -term * x2 / ((2.0 * k) * (2.0 * k + 1)), sum - term * x2 / ((2.0 * k) * (2.0 * k + 1)), k + 1);
+  }
+
+  constexpr double sinDegrees(double degrees)
+  {
+    return sinSeries((degrees * M_PI / 180.0) * (degrees * M_PI / 180.0), degrees * M_PI / 180.0, degrees * M_PI / 180.0, 1);
+  }
+
+#define SIN_Q14(d) int16_t(sinDegrees(d) * 16384.0 + 0.5)
+#define SIN_Q14_10(d) SIN_Q14(d), SIN_Q14(d + 1), SIN_Q14(d + 2), SIN_Q14(d + 3), SIN_Q14(d + 4), \
+                      SIN_Q14(d + 5), SIN_Q14(d + 6), SIN_Q14(d + 7), SIN_Q14(d + 8), SIN_Q14(d + 9)
+
+  constexpr int16_t SIN_Q14_TABLE[91] = {
+    SIN_Q14_10(0), SIN_Q14_10(10), SIN_Q14_10(20), SIN_Q14_10(30), SIN_Q14_10(40),
+    SIN_Q14_10(50), SIN_Q14_10(60), SIN_Q14_10(70), SIN_Q14_10(80), SIN_Q14(90)
+  };
+
+#undef SIN_Q14_10
+#undef SIN_Q14
+
+  static_assert(SIN_Q14_TABLE[0] == 0 && SIN_Q14_TABLE[30] == 8192 && SIN_Q14_TABLE[90] == 16384, "sine table");
+
+  const int32_t ONE_Q14 = 16384;
+
+  int32_t sinQ14(uint16_t degrees)
+  {
+    degrees %= 360;
+    if(degrees <= 90)
+    {
+      return SIN_Q14_TABLE[degrees];
+    }
+    if(degrees <= 180)
+    {
+      return SIN_Q14_TABLE[180 - degrees];
+    }
+    if(degrees <= 270)
+    {
+      return -SIN_Q14_TABLE[degrees - 180];
+    }
+    return -SIN_Q14_TABLE[360 - degrees];
+  }
+
+  // satellite icon: one byte per column (x - 4 .. x + 4), bit 0 is the top row (y - 2)
+  const uint8_t SAT_ICON_WIDTH = 9;
+  const uint8_t SAT_ICON_HOLLOW[SAT_ICON_WIDTH] = {0x1F, 0x04, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x04, 0x1F};
+  const uint8_t SAT_ICON_FILLED[SAT_ICON_WIDTH] = {0x1F, 0x04, 0x0E, 0x1F, 0x1F, 0x1F, 0x0E, 0x04, 0x1F};
+}
+
+RenderLayer::RenderLayer(U8G2& display, render_fn_t pRender) :
+    mDisplay(display),
+    mpRender(pRender),
+    mValid(false)
+{
+}
+
+void RenderLayer::copyTo()
+{
+  size_t size = (size_t)mDisplay.getBufferTileWidth() * mDisplay.getBufferTileHeight() * 8;
+  if(size > sizeof(mBitmap))
+  {
+    // display too large for the cache: draw the layer every time
+    mDisplay.clearBuffer();
+    mpRender();
+    return;
+  }
+  if(!mValid)
+  {
+    mDisplay.clearBuffer();
+    mpRender();
+    memcpy(mBitmap, mDisplay.getBufferPtr(), size);
+    mValid = true;
+    return;
+  }
+  memcpy(mDisplay.getBufferPtr(), mBitmap, size);
+}
+
+void renderSatIcon(U8G2& display, int16_t x, int16_t y, bool filled)
+{
+  // the 5 rows of each column span one or two pages
+  const uint8_t* pColumns = filled ? SAT_ICON_FILLED : SAT_ICON_HOLLOW;
+  uint8_t* pBuffer = display.getBufferPtr();
+  int16_t width = display.getBufferTileWidth() * 8;
+  int16_t height = display.getBufferTileHeight() * 8;
+  int16_t top = y - 2;
+
+  for(uint8_t i=0; i<SAT_ICON_WIDTH; i++)
+  {
+    int16_t column = x - 4 + i;
+    if(column < 0 || column >= width)
+    {
+      continue;
+    }
+    uint16_t bits = pColumns[i];
+    int16_t row = top;
+    if(row < 0)
+    {
+      bits >>= -row; // clipped at the top
+      row = 0;
+    }
+    if(bits == 0 || row >= height)
+    {
+      continue;
+    }
+    bits <<= (row & 7);
+    uint8_t page = row >> 3;
+    pBuffer[page * width + column] |= bits & 0xFF;
+    if((bits >> 8) && (page + 1) * 8 < height)
+    {
+      pBuffer[(page + 1) * width + column] |= bits >> 8;
+    }
+  }
+}
+
+void projectAzEl(uint16_t azimuth, uint8_t elevation, uint8_t radius, uint8_t cx, uint8_t cy, int16_t* pX, int16_t* pY)
+{
+  // distance from the center: (90 - elevation) / 90 * radius; everything is scaled by 90 * 2^14 so that a single
+  // (integer) division yields the pixel
+  const int32_t scale = 90 * ONE_Q14;
+  int32_t distance = (elevation > 90) ? 0 : (int32_t)(90 - elevation) * radius;
+  int32_t x = (int32_t)cx * scale + sinQ14(azimuth) * distance;
+  int32_t y = (int32_t)cy * scale - sinQ14(azimuth + 90) * distance;
+  // floor division (the float projection truncates, its results being positive on the display)
+  *pX = (x >= 0) ? x / scale : -((-x + scale - 1) / scale);
+  *pY = (y >= 0) ? y / scale : -((-y + scale - 1) / scale);
+}
@@ -0,0 +1,37 @@
+#ifndef RenderCache_h
+#define RenderCache_h
+
+#include <Arduino.h>
+#include <U8g2lib.h>
+
+// Render cache for the U8g2 full frame buffer: static layers (everything of a screen that does not change from frame
+// to frame) are rasterized once and then copied into the frame buffer instead of clearing and redrawing it, and the
+// satellite icons are pre-rasterized sprites that are ORed into the buffer. The sky plot projection of azimuth and
+// elevation uses a fixed-point sine table instead of float trigonometry.
+
+class RenderLayer {
+  public:
+    static const size_t MAX_BUFFER_SIZE = 128 * 64 / 8;
+
+    typedef void (*render_fn_t)(); // draws the layer into the (cleared) frame buffer
+
+    RenderLayer(U8G2& display, render_fn_t pRender);
+
+    void copyTo(); // replaces the frame buffer with the layer (in place of clearBuffer()); rasterizes on first use
+    void invalidate() { mValid = false; } // re-rasterize on next use (e.g. when what the layer shows has changed)
+  private:
+    U8G2& mDisplay;
+    render_fn_t mpRender;
+    uint8_t mBitmap[MAX_BUFFER_SIZE]; // page-aligned, in the frame buffer's layout
+    bool mValid;
+};
+
+// ORs the satellite icon (9x5 pixels, hollow or filled) centered at x/y into the frame buffer (draw color 1)
+void renderSatIcon(U8G2& display, int16_t x, int16_t y, bool filled);
+
+// projects azimuth (degrees, clockwise from north) and elevation (degrees, 90: zenith) onto the sky plot of the
+// given radius around cx/cy, truncated towards the upper left like the float projection (which may land a pixel off
+// where its rounding error crosses a pixel border)
+void projectAzEl(uint16_t azimuth, uint8_t elevation, uint8_t radius, uint8_t cx, uint8_t cy, int16_t* pX, int16_t* pY);
+
+#endif
@@ -0,0 +1,290 @@
+#include "RxRecorder.h"
+
+RamRxSpill::RamRxSpill(uint8_t* pBuf, size_t size) :
+    mBuf(pBuf),
+    mSize((pBuf != nullptr) ? size : 0),
+    mHead(0),
+    mLength(0)
+{
+}
+
+void RamRxSpill::write(const uint8_t* pBuf, size_t len)
+{
+  while(len > 0 && mSize > 0)
+  {
+    size_t n = (len < mSize - mHead) ? len : mSize - mHead; // up to the end of the buffer
+    memcpy(&mBuf[mHead], pBuf, n);
+    pBuf += n;
+    len -= n;
+    mHead = (mHead + n) % mSize;
+    mLength = (mLength + n < mSize) ? mLength + n : mSize;
+  }
+}
+
+size_t RamRxSpill::read(size_t pos, uint8_t* pBuf, size_t len)
+{
+  if(pos >= mLength)
+  {
+    return 0;
+  }
+  if(len > mLength - pos)
+  {
+    len = mLength - pos;
+  }
+  size_t idx = (mHead + mSize - mLength + pos) % mSize;
+  size_t n = (len < mSize - idx) ? len : mSize - idx;
+  memcpy(pBuf, &mBuf[idx], n);
+  memcpy(pBuf + n, mBuf, len - n);
+  return len;
+}
+
+#if defined(ESP32)
+FlashRxSpill::FlashRxSpill(const esp_partition_t* pPartition) :
+    mPartition(pPartition),
+    mSize(0),
+    mHead(0),
+    mLength(0)
+{
+  // needs two sectors at least: the one written and the one erased ahead
+  if(mPartition != nullptr && mPartition->size >= 2 * SECTOR_SIZE &&
+     esp_partition_erase_range(mPartition, 0, SECTOR_SIZE) == ESP_OK)
+  {
+    mSize = mPartition->size - mPartition->size % SECTOR_SIZE;
+  }
+}
+
+void FlashRxSpill::write(const uint8_t* pBuf, size_t len)
+{
+  while(len > 0 && mSize > 0)
+  {
+    size_t n = SECTOR_SIZE - mHead % SECTOR_SIZE; // up to the end of the (erased) sector
+    if(n > len)
+    {
+      n = len;
+    }
+    if(esp_partition_write(mPartition, mHead, pBuf, n) != ESP_OK)
+    {
+      mSize = 0; // give up, the bytes kept so far can still be read
+      return;
+    }
+    pBuf += n;
+    len -= n;
+    mLength += n;
+    mHead = (mHead + n) % mSize;
+    if(mHead % SECTOR_SIZE == 0)
+    {
+      // the next sector: erase it, the oldest bytes go with it
+      if(esp_partition_erase_range(mPartition, mHead, SECTOR_SIZE) != ESP_OK)
+      {
+        mSize = 0;
+        return;
+      }
+      if(mLength > mSize - SECTOR_SIZE)
+      {
+        mLength = mSize - SECTOR_SIZE;
+      }
+    }
+  }
+}
+
+size_t FlashRxSpill::read(size_t pos, uint8_t* pBuf, size_t len)
+{
+  size_t partitionSize = mPartition->size - mPartition->size % SECTOR_SIZE; // mSize is 0 after an error
+  if(pos >= mLength || partitionSize == 0)
+  {
+    return 0;
+  }
+  if(len > mLength - pos)
+  {
+    len = mLength - pos;
+  }
+  size_t idx = (mHead + partitionSize - mLength + pos) % partitionSize;
+  size_t n = (len < partitionSize - idx) ? len : partitionSize - idx;
+  if(esp_partition_read(mPartition, idx, pBuf, n) != ESP_OK ||
+     (n < len && esp_partition_read(mPartition, 0, pBuf + n, len - n) != ESP_OK))
+  {
+    return 0;
+  }
+  return len;
+}
+#endif
+
+RxRecorder::RxRecorder() :
+    mBuf(nullptr),
+    mSize(0),
+    mSpill(nullptr),
+    mTotal(0),
+    mHead(0),
+    mFull(false),
+    mTriggerMask(0),
+    mPostTriggerLen(0),
+    mPostTriggerLeft(0),
+    mTriggerReason(0),
+    mTriggerOffset(0),
+    mFrozen(false),
+    mRecording(false),
+    mMarkHead(0),
+    mNumMarks(0),
+    mMarkSpacing(0)
+{
+}
+
+void RxRecorder::begin(uint8_t* pBuf, size_t size, RxSpill* pSpill)
+{
+  mSize = (pBuf != nullptr) ? size : 0;
+  mSpill = pSpill;
+  mMarkSpacing = mSize / MAX_MARKS;
+  mBuf = (mSize > 0) ? pBuf : nullptr;
+}
+
+void RxRecorder::record(const uint8_t* pBuf, size_t len)
+{
+  if(mBuf == nullptr || len == 0)
+  {
+    return;
+  }
+  mRecording = true;
+  if(mFrozen)
+  {
+    mRecording = false;
+    return;
+  }
+
+  // after a trigger: only up to the end of the post-trigger bytes
+  bool freezeAfter = false;
+  if(mTriggerReason != 0 && len >= mPostTriggerLeft)
+  {
+    len = mPostTriggerLeft;
+    freezeAfter = true;
+  }
+
+  uint32_t nowUs = micros();
+  if(mNumMarks == 0 || mTotal - mMarks[(mMarkHead + MAX_MARKS - 1) % MAX_MARKS].offset >= mMarkSpacing ||
+     nowUs - mMarks[(mMarkHead + MAX_MARKS - 1) % MAX_MARKS].timeUs >= MARK_MAX_GAP_US)
+  {
+    addMark(nowUs);
+  }
+
+  while(len > 0)
+  {
+    size_t n = (len < mSize - mHead) ? len : mSize - mHead; // up to the end of the ring
+    if(mFull && mSpill != nullptr)
+    {
+      mSpill->write(&mBuf[mHead], n); // what is about to be overwritten
+    }
+    memcpy(&mBuf[mHead], pBuf, n);
+    pBuf += n;
+    len -= n;
+    mTotal += n;
+    if(mTriggerReason != 0)
+    {
+      mPostTriggerLeft -= n;
+    }
+    mHead += n;
+    if(mHead == mSize)
+    {
+      mHead = 0;
+      mFull = true;
+    }
+  }
+
+  if(freezeAfter)
+  {
+    mFrozen = true;
+  }
+  mRecording = false;
+}
+
+void RxRecorder::addMark(uint32_t timeUs)
+{
+  mMarks[mMarkHead].offset = mTotal;
+  mMarks[mMarkHead].timeUs = timeUs;
+  mMarkHead = (mMarkHead + 1) % MAX_MARKS;
+  if(mNumMarks < MAX_MARKS)
+  {
+    mNumMarks++;
+  }
+}
+
+void RxRecorder::trigger(uint8_t reason)
+{
+  // the first trigger counts, the ones during the post-trigger bytes are part of what is recorded
+  if(!(reason & mTriggerMask) || mTriggerReason != 0 || mBuf == nullptr)
+  {
+    return;
+  }
+  mTriggerOffset = mTotal;
+  mPostTriggerLeft = mPostTriggerLen;
+  mTriggerReason = reason;
+  if(mPostTriggerLen == 0)
+  {
+    mFrozen = true;
+  }
+}
+
+void RxRecorder::freeze()
+{
+  if(mTriggerReason == 0)
+  {
+    mTriggerOffset = mTotal;
+    mTriggerReason = TRIGGER_MANUAL;
+  }
+  mFrozen = true;
+  while(mRecording)
+  {
+    // a record() on another core finishes its chunk (it has seen the flag too late)
+  }
+}
+
+void RxRecorder::rearm()
+{
+  mTriggerReason = 0;
+  mFrozen = false;
+}
+
+uint32_t RxRecorder::getStartOffset()
+{
+  size_t kept = (mFull ? mSize : mHead) + ((mSpill != nullptr) ? mSpill->getLength() : 0);
+  return mTotal - kept;
+}
+
+size_t RxRecorder::read(uint32_t offset, uint8_t* pBuf, size_t len)
+{
+  size_t spillLen = (mSpill != nullptr) ? mSpill->getLength() : 0;
+  size_t ringLen = mFull ? mSize : mHead;
+  size_t pos = offset - getStartOffset();
+  if(mBuf == nullptr || pos >= spillLen + ringLen)
+  {
+    return 0;
+  }
+  if(pos < spillLen)
+  {
+    return mSpill->read(pos, pBuf, (len < spillLen - pos) ? len : spillLen - pos); // the rest with the next call
+  }
+  pos -= spillLen;
+  if(len > ringLen - pos)
+  {
+    len = ringLen - pos;
+  }
+  size_t idx = ((mFull ? mHead : 0) + pos) % mSize;
+  size_t n = (len < mSize - idx) ? len : mSize - idx;
+  memcpy(pBuf, &mBuf[idx], n);
+  memcpy(pBuf + n, mBuf, len - n);
+  return len;
+}
+
+uint8_t RxRecorder::getNumMarks()
+{
+  uint32_t start = getStartOffset();
+  uint8_t num = mNumMarks;
+  while(num > 0 && (int32_t)(mMarks[(mMarkHead + MAX_MARKS - num) % MAX_MARKS].offset - start) < 0)
+  {
+    num--; // points to bytes that are gone
+  }
+  return num;
+}
+
+const RxRecorder::rx_mark_t& RxRecorder::getMark(uint8_t i)
+{
+  return mMarks[(mMarkHead + MAX_MARKS - getNumMarks() + i) % MAX_MARKS];
+}
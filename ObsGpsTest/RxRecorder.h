@@ -0,0 +1,123 @@
+#ifndef RxRecorder_h
+#define RxRecorder_h
+
+#include <Arduino.h>
+#include <atomic>
+#if defined(ESP32)
+#include <esp_partition.h>
+#endif
+
+// Flight recorder of the GPS serial's RX stream: the raw bytes go into a ring buffer (one byte per byte, the memory is
+// the caller's) all the time, with a timestamp at the start of a chunk now and then (sparse: when enough bytes or time
+// have passed since the last one). An error of a kind selected with setTriggers() (UART overflow, UBX checksum...)
+// freezes the recording some bytes later, so that what led to the error and what followed it stays available, and
+// so does freeze() at any time. What the ring overwrites can be spilled into a larger, slower store (see RxSpill,
+// e.g. PSRAM or a flash partition) first; reading covers both, by stream offset (number of bytes recorded before).
+// record() and trigger() belong to the RX context, freeze() may be called from any other (it waits for a record() in
+// progress), reading is only consistent while frozen.
+
+// secondary store for the bytes that drop out of the ring: keeps the latest ones that fit (oldest first)
+class RxSpill {
+  public:
+    virtual ~RxSpill() {}
+    virtual void write(const uint8_t* pBuf, size_t len) = 0;
+    virtual size_t getLength() = 0; // bytes kept
+    virtual size_t read(size_t pos, uint8_t* pBuf, size_t len) = 0; // `pos` counts from the oldest byte kept
+};
+
+// spill into memory of the caller's, e.g. PSRAM (ps_malloc())
+class RamRxSpill : public RxSpill {
+  public:
+    RamRxSpill(uint8_t* pBuf, size_t size);
+    void write(const uint8_t* pBuf, size_t len) override;
+    size_t getLength() override { return mLength; }
+    size_t read(size_t pos, uint8_t* pBuf, size_t len) override;
+  private:
+    uint8_t* mBuf;
+    size_t mSize;
+    size_t mHead; // next byte written
+    size_t mLength;
+};
+
+#if defined(ESP32)
+// spill into a data partition of the flash (e.g. the unused SPIFFS partition), erased sector by sector just ahead of
+// the writing; please note that erasing a sector stalls both cores for tens of ms (the UART buffer has to bridge that)
+class FlashRxSpill : public RxSpill {
+  public:
+    explicit FlashRxSpill(const esp_partition_t* pPartition);
+    void write(const uint8_t* pBuf, size_t len) override;
+    size_t getLength() override { return mLength; }
+    size_t read(size_t pos, uint8_t* pBuf, size_t len) override;
+  private:
+    static const size_t SECTOR_SIZE = 4096;
+
+    const esp_partition_t* mPartition;
+    size_t mSize; // whole sectors only
+    size_t mHead; // next byte written (its sector has been erased)
+    size_t mLength; // at most one sector less than the partition: the sector ahead of the head is erased
+};
+#endif
+
+class RxRecorder {
+  public:
+    static const uint8_t TRIGGER_OVERFLOW = 0x01; // bytes lost by the UART (driver)
+    static const uint8_t TRIGGER_UBX_CHECKSUM = 0x02;
+    static const uint8_t TRIGGER_UBX_LENGTH = 0x04; // UBX frame too long for the receive buffer
+    static const uint8_t TRIGGER_MANUAL = 0x80; // freeze()
+    static const uint8_t MAX_MARKS = 32;
+    static const uint32_t MARK_MAX_GAP_US = 1000000; // a timestamp at least every second (when there is data)
+
+    typedef struct
+    {
+      uint32_t offset; // stream offset of the chunk's first byte
+      uint32_t timeUs; // micros() when the chunk was recorded
+    } rx_mark_t;
+
+    RxRecorder();
+
+    // recording starts with begin(), into `pBuf` (and `pSpill`, optional); without it, nothing is recorded
+    void begin(uint8_t* pBuf, size_t size, RxSpill* pSpill = nullptr);
+    // errors that freeze the recording (TRIGGER_* flags), `postTriggerLen` bytes after the error
+    void setTriggers(uint8_t mask, size_t postTriggerLen) { mTriggerMask = mask; mPostTriggerLen = postTriggerLen; }
+
+    void record(const uint8_t* pBuf, size_t len);
+    void trigger(uint8_t reason); // an error of that kind has just been seen (in the bytes recorded last)
+    void freeze(); // stop recording now
+    void rearm(); // record again (appending), waiting for the next trigger
+
+    bool isEnabled() { return mBuf != nullptr; }
+    bool isFrozen() { return mFrozen; }
+    bool isTriggered() { return mTriggerReason.load() != 0; } // frozen or about to be
+    uint8_t getTriggerReason() { return mTriggerReason; } // TRIGGER_* flag of the first trigger, 0 if none
+    uint32_t getTriggerOffset() { return mTriggerOffset; } // stream offset at the trigger
+    size_t getSize() { return mSize; }
+
+    // the bytes kept (spill and ring), by stream offset; use while frozen
+    uint32_t getStartOffset(); // of the oldest byte kept
+    uint32_t getEndOffset() { return mTotal; } // one past the latest byte, i.e. the number of bytes recorded
+    size_t read(uint32_t offset, uint8_t* pBuf, size_t len); // returns the number of bytes read (0 outside)
+    uint8_t getNumMarks(); // timestamps within the bytes kept, oldest first
+    const rx_mark_t& getMark(uint8_t i);
+  private:
+    void addMark(uint32_t timeUs);
+
+    uint8_t* mBuf;
+    size_t mSize;
+    RxSpill* mSpill;
+    uint32_t mTotal; // bytes recorded, the ring holds the last min(mTotal, mSize) of them
+    size_t mHead; // next byte written in the ring
+    bool mFull; // the ring has wrapped (the oldest byte is at mHead)
+    uint8_t mTriggerMask;
+    size_t mPostTriggerLen;
+    size_t mPostTriggerLeft;
+    std::atomic<uint8_t> mTriggerReason;
+    uint32_t mTriggerOffset;
+    std::atomic<bool> mFrozen;
+    std::atomic<bool> mRecording; // record() in progress (freeze() waits for it)
+    rx_mark_t mMarks[MAX_MARKS]; // ring, mNumMarks entries ending before mMarkHead
+    uint8_t mMarkHead;
+    uint8_t mNumMarks;
+    uint32_t mMarkSpacing; // bytes between timestamps (at least)
+};
+
+#endif
@@ -0,0 +1,152 @@
+#include "SatStore.h"
+
+namespace
+{
+  // true when the satellite in `slotA` ranks before the one in `slotB`
+  bool ranksBefore(const SatStore::sat_epoch_t* pEpoch, uint8_t slotA, uint8_t slotB)
+  {
+    if(pEpoch->snr[slotA] != pEpoch->snr[slotB])
+    {
+      return pEpoch->snr[slotA] > pEpoch->snr[slotB];
+    }
+    if(pEpoch->system[slotA] != pEpoch->system[slotB])
+    {
+      return pEpoch->system[slotA] < pEpoch->system[slotB];
+    }
+    return pEpoch->prn[slotA] < pEpoch->prn[slotB];
+  }
+
+  bool hasValidAzEl(uint8_t elevation, uint16_t azimuth)
+  {
+    return elevation != 0 || azimuth != 0;
+  }
+}
+
+SatStore::SatStore() :
+    mWriteBank(0),
+    mReadBank(1),
+    mReadyBank(2),
+    mDropCount(0)
+{
+  for(uint8_t i=0; i<NUM_BANKS; i++)
+  {
+    reset(&mBanks[i]);
+  }
+}
+
+void SatStore::update(uint8_t system, uint8_t prn, uint8_t elevation, uint16_t azimuth, uint8_t snr)
+{
+  sat_epoch_t* pEpoch = &mBanks[mWriteBank];
+
+  uint8_t slot = 0;
+  while(slot < pEpoch->numSats && (pEpoch->prn[slot] != prn || pEpoch->system[slot] != system))
+  {
+    slot++;
+  }
+
+  if(slot == pEpoch->numSats)
+  {
+    // new satellite: append it and rank it from the bottom
+    if(pEpoch->numSats == MAX_SATS)
+    {
+      return;
+    }
+    pEpoch->numSats++;
+    pEpoch->system[slot] = system;
+    pEpoch->prn[slot] = prn;
+    pEpoch->snr[slot] = snr;
+    pEpoch->ranked[slot] = slot;
+    pEpoch->rankPos[slot] = slot;
+  }
+  else
+  {
+    // seen before (another signal of the same satellite): keep the strongest
+    if(hasValidAzEl(pEpoch->elevation[slot], pEpoch->azimuth[slot]))
+    {
+      pEpoch->numValidAzEls--;
+    }
+    if(snr > pEpoch->snr[slot])
+    {
+      pEpoch->snr[slot] = snr;
+    }
+  }
+
+  pEpoch->elevation[slot] = elevation;
+  pEpoch->azimuth[slot] = azimuth;
+  if(hasValidAzEl(elevation, azimuth))
+  {
+    pEpoch->numValidAzEls++;
+  }
+  moveInRanking(pEpoch, slot);
+}
+
+void SatStore::moveInRanking(sat_epoch_t* pEpoch, uint8_t slot)
+{
+  // one insertion sort step: only the satellite just updated may be out of order
+  uint8_t pos = pEpoch->rankPos[slot];
+  while(pos > 0 && ranksBefore(pEpoch, slot, pEpoch->ranked[pos - 1]))
+  {
+    pEpoch->ranked[pos] = pEpoch->ranked[pos - 1];
+    pEpoch->rankPos[pEpoch->ranked[pos]] = pos;
+    pos--;
+  }
+  while(pos + 1 < pEpoch->numSats && ranksBefore(pEpoch, pEpoch->ranked[pos + 1], slot))
+  {
+    pEpoch->ranked[pos] = pEpoch->ranked[pos + 1];
+    pEpoch->rankPos[pEpoch->ranked[pos]] = pos;
+    pos++;
+  }
+  pEpoch->ranked[pos] = slot;
+  pEpoch->rankPos[slot] = pos;
+}
+
+void SatStore::setTime(bool valid, uint8_t hour, uint8_t minute, uint8_t second)
+{
+  sat_epoch_t* pEpoch = &mBanks[mWriteBank];
+  pEpoch->timeValid = valid;
+  pEpoch->hour = hour;
+  pEpoch->minute = minute;
+  pEpoch->second = second;
+}
+
+void SatStore::setFix(uint8_t fixType)
+{
+  mBanks[mWriteBank].fixType = fixType;
+}
+
+void SatStore::publish()
+{
+  // swap the filled bank with the ready one; when that one has not been acquired yet, its epoch is lost
+  uint8_t previous = mReadyBank.exchange(mWriteBank | BANK_NEW, std::memory_order_acq_rel);
+  if(previous & BANK_NEW)
+  {
+    mDropCount.fetch_add(1, std::memory_order_relaxed);
+  }
+  mWriteBank = previous & BANK_MASK;
+  reset(&mBanks[mWriteBank]);
+}
+
+void SatStore::discard()
+{
+  reset(&mBanks[mWriteBank]);
+}
+
+const SatStore::sat_epoch_t* SatStore::acquire()
+{
+  if(!(mReadyBank.load(std::memory_order_acquire) & BANK_NEW))
+  {
+    return nullptr;
+  }
+  uint8_t ready = mReadyBank.exchange(mReadBank, std::memory_order_acq_rel);
+  mReadBank = ready & BANK_MASK;
+  return &mBanks[mReadBank];
+}
+
+void SatStore::reset(sat_epoch_t* pEpoch)
+{
+  // the satellite arrays are overwritten slot by slot, only the counters need to start over
+  pEpoch->numSats = 0;
+  pEpoch->numValidAzEls = 0;
+  pEpoch->timeValid = false;
+  pEpoch->fixType = 0;
+}
@@ -0,0 +1,69 @@
+#ifndef SatStore_h
+#define SatStore_h
+
+#include <Arduino.h>
+#include <atomic>
+
+// Satellite table of the GSV epochs: satellites are taken over record by record as the $--GSV sentences arrive and
+// kept ranked by signal strength all the time (insertion into an index list instead of sorting the table), the
+// number of satellites with a valid azimuth/elevation is maintained on the way.
+// The table is triple-buffered: the decoder (writer) fills one bank, publish() hands it over as the latest epoch and
+// the UI (reader) takes the latest epoch with acquire() -- no copying, and writer and reader may run on different
+// cores (exactly one of each). Epochs published while the reader has not taken the previous one are dropped (and
+// counted).
+
+class SatStore {
+  public:
+    static const uint8_t MAX_SATS = 128; // of all constellations
+
+    // one epoch, structure of arrays indexed by slot (in order of appearance); `ranked` lists the slots by signal
+    // strength (highest SNR first; same SNR: by system, then lower PRN first)
+    typedef struct
+    {
+      uint8_t system[MAX_SATS]; // GsvParser::GnssSystem
+      uint8_t prn[MAX_SATS]; // within the system
+      uint8_t elevation[MAX_SATS]; // degrees
+      uint16_t azimuth[MAX_SATS]; // degrees
+      uint8_t snr[MAX_SATS]; // dBHz
+      uint8_t ranked[MAX_SATS];
+      uint8_t rankPos[MAX_SATS]; // position of each slot in `ranked`
+      uint8_t numSats;
+      uint8_t numValidAzEls; // satellites with elevation != 0 or azimuth != 0
+      bool timeValid; // UTC time at the end of the epoch
+      uint8_t hour;
+      uint8_t minute;
+      uint8_t second;
+      uint8_t fixType; // position fix at the end of the epoch: 0: none, 2: 2D, 3: 3D
+    } sat_epoch_t;
+
+    SatStore();
+
+    // writer side: `update()` takes over a satellite (a satellite seen again, e.g. on another signal, keeps the
+    // highest SNR), `publish()` completes the epoch and starts the next one, `discard()` starts over without publishing
+    void update(uint8_t system, uint8_t prn, uint8_t elevation, uint16_t azimuth, uint8_t snr);
+    void setTime(bool valid, uint8_t hour, uint8_t minute, uint8_t second);
+    void setFix(uint8_t fixType);
+    void publish();
+    void discard();
+    const sat_epoch_t& getCurrent() { return mBanks[mWriteBank]; } // the epoch being collected (writer only)
+
+    // reader side: returns the latest published epoch (valid until the next call) or nullptr when there's no new one
+    const sat_epoch_t* acquire();
+
+    unsigned int getDropCount() const { return mDropCount.load(std::memory_order_relaxed); }
+  private:
+    static const uint8_t NUM_BANKS = 3;
+    static const uint8_t BANK_MASK = 0x03;
+    static const uint8_t BANK_NEW = 0x80; // flag in mReadyBank: published, but not acquired yet
+
+    void reset(sat_epoch_t* pEpoch);
+    void moveInRanking(sat_epoch_t* pEpoch, uint8_t slot);
+
+    sat_epoch_t mBanks[NUM_BANKS];
+    uint8_t mWriteBank; // only used by the writer
+    uint8_t mReadBank; // only used by the reader
+    std::atomic<uint8_t> mReadyBank; // exchanged between writer and reader
+    std::atomic<unsigned int> mDropCount;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#include "Scheduler.h"
+
+Scheduler::Scheduler()
+{
+  for(uint8_t i=0; i<MAX_TASKS; i++)
+  {
+    mTasks[i].pTask = nullptr;
+  }
+}
+
+uint8_t Scheduler::every(uint32_t intervalMs, task_fn_t pTask, uint32_t firstDelayMs)
+{
+  return add(firstDelayMs, (intervalMs > 0) ? intervalMs : 1, pTask);
+}
+
+uint8_t Scheduler::after(uint32_t delayMs, task_fn_t pTask)
+{
+  return add(delayMs, 0, pTask);
+}
+
+uint8_t Scheduler::add(uint32_t delayMs, uint32_t intervalMs, task_fn_t pTask)
+{
+  for(uint8_t i=0; i<MAX_TASKS; i++)
+  {
+    if(mTasks[i].pTask == nullptr)
+    {
+      mTasks[i].pTask = pTask;
+      mTasks[i].dueMs = millis() + delayMs;
+      mTasks[i].intervalMs = intervalMs;
+      return i;
+    }
+  }
+  return NO_TASK;
+}
+
+void Scheduler::cancel(uint8_t id)
+{
+  if(id < MAX_TASKS)
+  {
+    mTasks[id].pTask = nullptr;
+  }
+}
+
+bool Scheduler::isScheduled(uint8_t id)
+{
+  return (id < MAX_TASKS) && (mTasks[id].pTask != nullptr);
+}
+
+uint8_t Scheduler::run()
+{
+  uint8_t numRun = 0;
+  uint32_t now = millis();
+  for(uint8_t i=0; i<MAX_TASKS; i++)
+  {
+    timed_task_t& task = mTasks[i];
+    if(task.pTask == nullptr || (int32_t)(now - task.dueMs) < 0)
+    {
+      continue;
+    }
+    task_fn_t pTask = task.pTask;
+    if(task.intervalMs == 0)
+    {
+      task.pTask = nullptr; // before running it: the task may schedule itself again
+    }
+    else
+    {
+      // keep the period; when running late (e.g. a long task before), skip the missed runs instead of catching up
+      task.dueMs += task.intervalMs;
+      if((int32_t)(now - task.dueMs) >= 0)
+      {
+        task.dueMs = now + task.intervalMs;
+      }
+    }
+    pTask();
+    numRun++;
+  }
+  return numRun;
+}
@@ -0,0 +1,53 @@
+#ifndef Scheduler_h
+#define Scheduler_h
+
+#include <Arduino.h>
+
+// Cooperative timer scheduler for the sketch's loop(): periodic and one-shot tasks (plain functions) are run from
+// run() once they are due, nothing ever blocks -- a task does its step and returns, so the GPS serial keeps being
+// drained in between. Times are millis(), comparisons are safe across the wrap-around.
+
+class Scheduler {
+  public:
+    static const uint8_t MAX_TASKS = 8;
+    static const uint8_t NO_TASK = 0xFF;
+
+    typedef void (*task_fn_t)();
+
+    Scheduler();
+
+    // both return the task's id (for cancel()) or NO_TASK when all slots are taken
+    uint8_t every(uint32_t intervalMs, task_fn_t pTask, uint32_t firstDelayMs); // periodic, first run after the delay
+    uint8_t after(uint32_t delayMs, task_fn_t pTask); // one-shot
+    void cancel(uint8_t id); // may be called from within the task itself
+    bool isScheduled(uint8_t id);
+
+    uint8_t run(); // runs the tasks that are due (each at most once), returns how many
+  private:
+    typedef struct
+    {
+      task_fn_t pTask; // nullptr: free slot
+      uint32_t dueMs;
+      uint32_t intervalMs; // 0: one-shot
+    } timed_task_t;
+
+    uint8_t add(uint32_t delayMs, uint32_t intervalMs, task_fn_t pTask);
+
+    timed_task_t mTasks[MAX_TASKS];
+};
+
+// One-shot deadline to poll from loop() (e.g. how long a screen is shown) instead of waiting with delay()
+class Deadline {
+  public:
+    Deadline() : mDueMs(0), mRunning(false) {}
+
+    void start(uint32_t durationMs) { mDueMs = millis() + durationMs; mRunning = true; }
+    void stop() { mRunning = false; }
+    bool isPending() { return mRunning && (int32_t)(millis() - mDueMs) < 0; } // started and not reached yet
+    bool hasExpired() { return mRunning && (int32_t)(millis() - mDueMs) >= 0; } // started and reached
+  private:
+    uint32_t mDueMs;
+    bool mRunning;
+};
+
+#endif
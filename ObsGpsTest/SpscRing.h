@@ -0,0 +1,64 @@
+#ifndef SpscRing_h
+#define SpscRing_h
+
+#include <atomic>
+#include <stddef.h>
+
+// Lock-free ring buffer for exactly one producer and one consumer context (e.g. two tasks on different cores).
+// Only depends on <atomic>, so it builds on the ESP32 as well as on a Linux host (std::thread).
+// N must be a power of two; one slot is *not* wasted as head and tail are free-running counters.
+template <typename T, size_t N>
+class SpscRing {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+  public:
+    SpscRing() :
+        mHead(0),
+        mTail(0),
+        mDropCount(0)
+    {
+    }
+
+    // producer side: returns false (and counts the drop) when the consumer has not kept up
+    bool push(const T& item)
+    {
+      size_t head = mHead.load(std::memory_order_relaxed);
+      if(head - mTail.load(std::memory_order_acquire) >= N)
+      {
+        mDropCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      mItems[head & (N - 1)] = item;
+      mHead.store(head + 1, std::memory_order_release); // publish the item
+      return true;
+    }
+
+    // consumer side: returns false when there's nothing to pop
+    bool pop(T& item)
+    {
+      size_t tail = mTail.load(std::memory_order_relaxed);
+      if(tail == mHead.load(std::memory_order_acquire))
+      {
+        return false;
+      }
+      item = mItems[tail & (N - 1)];
+      mTail.store(tail + 1, std::memory_order_release); // hand the slot back to the producer
+      return true;
+    }
+
+    size_t size() const
+    {
+      return mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return N; }
+    unsigned int getDropCount() const { return mDropCount.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<size_t> mHead; // only written by the producer
+    std::atomic<size_t> mTail; // only written by the consumer
+    std::atomic<unsigned int> mDropCount;
+    T mItems[N];
+};
+
+#endif
@@ -0,0 +1,203 @@
+#include "TestPlan.h"
+
+namespace
+{
+  const char* const CHECK_NAMES[TestPlan::CHECK_NUM] = {"LINK", "NMEA", "SATS", "UBX", "FIX", "ERRORS"};
+  const char* const STATE_NAMES[] = {"SKIP", "PENDING", "PASS", "FAIL"};
+}
+
+TestPlan::TestPlan() :
+    mStartMs(0),
+    mDurationMs(0),
+    mVerdict(VERDICT_PENDING),
+    mErrorBaseValid(false),
+    mErrorBase(0)
+{
+  memset(&mCriteria, 0, sizeof(mCriteria));
+  for(uint8_t i=0; i<CHECK_NUM; i++)
+  {
+    mStates[i] = CHECK_SKIPPED;
+    mValues[i] = 0;
+  }
+}
+
+void TestPlan::begin(const test_criteria_t& criteria, uint32_t nowMs)
+{
+  mCriteria = criteria;
+  mStartMs = nowMs;
+  mDurationMs = 0;
+  mVerdict = VERDICT_PENDING;
+  mErrorBaseValid = false;
+  for(uint8_t i=0; i<CHECK_NUM; i++)
+  {
+    mStates[i] = CHECK_PENDING;
+    mValues[i] = 0;
+  }
+  // the link is checked always, the others only with a criterion
+  if(criteria.minNmeaSentences == 0)
+  {
+    mStates[CHECK_NMEA] = CHECK_SKIPPED;
+  }
+  if(criteria.minSats == 0)
+  {
+    mStates[CHECK_SATS] = CHECK_SKIPPED;
+  }
+  if(criteria.minUbxAnswered == 0)
+  {
+    mStates[CHECK_UBX] = CHECK_SKIPPED;
+  }
+  if(!criteria.requireFix)
+  {
+    mStates[CHECK_FIX] = CHECK_SKIPPED;
+  }
+  if(criteria.maxErrors == NO_LIMIT)
+  {
+    mStates[CHECK_ERRORS] = CHECK_SKIPPED;
+  }
+}
+
+void TestPlan::decide(CheckId id, bool passed)
+{
+  if(mStates[id] == CHECK_PENDING)
+  {
+    mStates[id] = passed ? CHECK_PASSED : CHECK_FAILED;
+  }
+}
+
+void TestPlan::finish(Verdict verdict, uint32_t nowMs)
+{
+  mVerdict = verdict;
+  mDurationMs = nowMs - mStartMs;
+}
+
+TestPlan::Verdict TestPlan::update(const test_status_t& status, uint32_t nowMs)
+{
+  if(mVerdict != VERDICT_PENDING)
+  {
+    return mVerdict;
+  }
+  uint32_t elapsedMs = nowMs - mStartMs;
+  if(!mErrorBaseValid)
+  {
+    mErrorBase = status.errors;
+    mErrorBaseValid = true;
+  }
+
+  // measurements (the best one so far) and the checks that can be decided already
+  mValues[CHECK_LINK] = status.linkSeen;
+  if(status.linkSeen)
+  {
+    decide(CHECK_LINK, true);
+  }
+  else if(mCriteria.linkTimeoutMs > 0 && elapsedMs >= mCriteria.linkTimeoutMs)
+  {
+    decide(CHECK_LINK, false);
+  }
+
+  mValues[CHECK_NMEA] = status.nmeaSentences;
+  if(status.nmeaSentences >= mCriteria.minNmeaSentences)
+  {
+    decide(CHECK_NMEA, true);
+  }
+
+  if(status.strongSats > mValues[CHECK_SATS])
+  {
+    mValues[CHECK_SATS] = status.strongSats;
+  }
+  if(mValues[CHECK_SATS] >= mCriteria.minSats)
+  {
+    decide(CHECK_SATS, true);
+  }
+
+  mValues[CHECK_UBX] = status.ubxAnswered;
+  if(status.ubxPollsDone || status.ubxAnswered >= mCriteria.minUbxAnswered)
+  {
+    decide(CHECK_UBX, status.ubxAnswered >= mCriteria.minUbxAnswered);
+  }
+
+  if(status.fix)
+  {
+    mValues[CHECK_FIX] = 1;
+    decide(CHECK_FIX, true);
+  }
+
+  mValues[CHECK_ERRORS] = status.errors - mErrorBase;
+  if(mValues[CHECK_ERRORS] > mCriteria.maxErrors)
+  {
+    decide(CHECK_ERRORS, false);
+  }
+
+  // verdict: the first failed check, or all passed (the error limit has held until then), or the timeout
+  bool anyPending = false;
+  for(uint8_t i=0; i<CHECK_NUM; i++)
+  {
+    if(mStates[i] == CHECK_FAILED)
+    {
+      finish(VERDICT_FAIL, nowMs);
+      return mVerdict;
+    }
+    if(mStates[i] == CHECK_PENDING && i != CHECK_ERRORS)
+    {
+      anyPending = true;
+    }
+  }
+  if(!anyPending || elapsedMs >= mCriteria.timeoutMs)
+  {
+    for(uint8_t i=0; i<CHECK_NUM; i++)
+    {
+      decide((CheckId)i, i == CHECK_ERRORS);
+    }
+    finish(anyPending ? VERDICT_FAIL : VERDICT_PASS, nowMs);
+  }
+  return mVerdict;
+}
+
+uint32_t TestPlan::getRequired(CheckId id)
+{
+  switch(id)
+  {
+    case CHECK_NMEA:
+      return mCriteria.minNmeaSentences;
+    case CHECK_SATS:
+      return mCriteria.minSats;
+    case CHECK_UBX:
+      return mCriteria.minUbxAnswered;
+    case CHECK_ERRORS:
+      return mCriteria.maxErrors;
+    default:
+      return 1;
+  }
+}
+
+const char* TestPlan::getCheckName(CheckId id)
+{
+  return (id < CHECK_NUM) ? CHECK_NAMES[id] : "";
+}
+
+const char* TestPlan::getStateName(CheckState state)
+{
+  return (state <= CHECK_FAILED) ? STATE_NAMES[state] : "";
+}
+
+void TestPlan::printResult(Print& out, uint8_t module)
+{
+  out.print("RESULT,");
+  out.print((mVerdict == VERDICT_PASS) ? "PASS" : (mVerdict == VERDICT_FAIL) ? "FAIL" : "PENDING");
+  out.print(",");
+  out.print((unsigned long)mDurationMs);
+  for(uint8_t i=0; i<CHECK_NUM; i++)
+  {
+    out.print(",");
+    out.print(CHECK_NAMES[i]);
+    out.print(":");
+    out.print(STATE_NAMES[mStates[i]]);
+    out.print(":");
+    out.print((unsigned long)mValues[i]);
+  }
+  if(module > 0)
+  {
+    out.print(",MODULE:");
+    out.print(module);
+  }
+  out.println();
+}
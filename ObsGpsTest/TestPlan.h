@@ -0,0 +1,95 @@
+#ifndef TestPlan_h
+#define TestPlan_h
+
+#include <Arduino.h>
+
+// Pass/fail test plan of a GPS module: a fixed set of checks, each with its criterion from test_criteria_t (or left
+// out), evaluated with what the sketch has measured so far whenever update() is called. A check passes as soon as its
+// criterion holds (and stays passed), and fails as soon as it cannot hold anymore: the UBX polls are all through with
+// too few answers, there are more errors than allowed, or no valid data has come in within the link timeout. The test
+// ends with the first failed check or when all checks have passed; checks still pending at the overall timeout fail.
+// The error limit holds until the end, it passes with the others.
+
+class TestPlan {
+  public:
+    static const uint16_t NO_LIMIT = 0xFFFF; // maxErrors: no error check
+
+    enum CheckId {
+      CHECK_LINK, // valid NMEA sentences or UBX frames at all
+      CHECK_NMEA, // number of NMEA sentences w/ a valid checksum
+      CHECK_SATS, // satellites above a C/N0 in one epoch
+      CHECK_UBX, // UBX polls answered
+      CHECK_FIX,
+      CHECK_ERRORS, // checksum errors and UART overflows since the test started
+      CHECK_NUM
+    };
+
+    enum CheckState {
+      CHECK_SKIPPED, // no criterion
+      CHECK_PENDING,
+      CHECK_PASSED,
+      CHECK_FAILED
+    };
+
+    enum Verdict {
+      VERDICT_PENDING,
+      VERDICT_PASS,
+      VERDICT_FAIL
+    };
+
+    typedef struct
+    {
+      uint32_t timeoutMs; // checks still pending by then fail
+      uint32_t linkTimeoutMs; // the link check fails by then already (0: at the overall timeout)
+      uint16_t minNmeaSentences; // 0: no NMEA check
+      uint8_t minSats; // 0: no satellite check
+      uint8_t minSnr; // dB-Hz, for minSats
+      uint8_t minUbxAnswered; // 0: no UBX check
+      bool requireFix;
+      uint16_t maxErrors; // NO_LIMIT: no error check
+    } test_criteria_t;
+
+    // what has been measured so far (counts since power-up, the plan takes the errors relative to its first update)
+    typedef struct
+    {
+      bool linkSeen;
+      uint32_t nmeaSentences;
+      uint8_t strongSats; // satellites w/ at least `minSnr` in the latest epoch
+      bool ubxPollsDone; // all answered or given up
+      uint8_t ubxAnswered;
+      bool fix;
+      uint32_t errors;
+    } test_status_t;
+
+    TestPlan();
+
+    void begin(const test_criteria_t& criteria, uint32_t nowMs); // timeouts count from `nowMs`
+    Verdict update(const test_status_t& status, uint32_t nowMs);
+
+    const test_criteria_t& getCriteria() { return mCriteria; }
+    Verdict getVerdict() { return mVerdict; }
+    uint32_t getDurationMs() { return mDurationMs; } // from begin() to the verdict
+    CheckState getState(CheckId id) { return mStates[id]; }
+    uint32_t getValue(CheckId id) { return mValues[id]; } // the best (or, for the errors, latest) measurement
+    uint32_t getRequired(CheckId id); // the criterion's value
+    static const char* getCheckName(CheckId id);
+    static const char* getStateName(CheckState state);
+
+    // machine-readable result: "RESULT,<PASS|FAIL>,<ms>" and "<check>:<state>:<value>" for each check, then
+    // "MODULE:<module>" when testing several modules (`module` > 0)
+    void printResult(Print& out, uint8_t module = 0);
+  private:
+    void decide(CheckId id, bool passed);
+    void finish(Verdict verdict, uint32_t nowMs);
+
+    test_criteria_t mCriteria;
+    uint32_t mStartMs;
+    uint32_t mDurationMs;
+    Verdict mVerdict;
+    bool mErrorBaseValid;
+    uint32_t mErrorBase;
+    CheckState mStates[CHECK_NUM];
+    uint32_t mValues[CHECK_NUM];
+};
+
+#endif
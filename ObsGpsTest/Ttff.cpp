@@ -0,0 +1,363 @@
+#include "Ttff.h"
+#include "GpsSerial.h"
+#include "UbxNav.h"
+
+namespace
+{
+  const char* const START_NAMES[TtffBench::START_NUM] = {"COLD", "WARM", "HOT"};
+  // CFG-RST navBbrMask per start type: cold clears everything in the battery-backed RAM, warm the ephemerides
+  const uint16_t START_BBR_MASKS[TtffBench::START_NUM] = {0xFFFF, 0x0001, 0x0000};
+  const uint8_t UBX_MSG_ID_CFG_RST = 0x04;
+  const uint8_t RESET_MODE_GNSS = 0x02; // controlled software reset of the GNSS part only
+  const uint16_t NAV_STATUS_LEN = 16;
+  const uint8_t NAV_STATUS_FIX_OK = 0x01;
+  const uint8_t NAV_STATUS_TIME_SET = 0x0C; // week number and time of week valid
+  const uint32_t MSSS_TOLERANCE_MS = 500; // NAV-STATUS msss vs. the time since the reset was sent
+
+  uint32_t readU4(const uint8_t* p)
+  {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+  }
+}
+
+TtffBench::TtffBench() :
+    mState(STATE_IDLE),
+    mStartType(START_COLD),
+    mRun(0),
+    mNextStartType(START_COLD),
+    mNextRun(0),
+    mRunStartMs(0),
+    mFixAtMs(0),
+    mEpochsValid(false),
+    mSatsInView(0),
+    mNumSatSamples(0)
+{
+  memset(&mConfig, 0, sizeof(mConfig));
+  memset(&mCurrent, 0, sizeof(mCurrent));
+  for(uint8_t i=0; i<START_NUM; i++)
+  {
+    mNumRuns[i] = 0;
+  }
+}
+
+void TtffBench::begin(const ttff_config_t& config)
+{
+  mConfig = config;
+  if(mConfig.runsPerType > MAX_RUNS)
+  {
+    mConfig.runsPerType = MAX_RUNS;
+  }
+  for(uint8_t i=0; i<START_NUM; i++)
+  {
+    mNumRuns[i] = 0;
+  }
+  // the first run of the first enabled start type
+  mState = STATE_DONE;
+  for(uint8_t type=0; type<START_NUM && mConfig.runsPerType > 0; type++)
+  {
+    if(isEnabled((StartType)type))
+    {
+      mNextStartType = (StartType)type;
+      mNextRun = 0;
+      mState = STATE_RESET_DUE;
+      break;
+    }
+  }
+}
+
+void TtffBench::onResetSent(uint32_t sentMs)
+{
+  // what has been observed since ACTION_RESET was from before the reset
+  if(mState == STATE_ACQUIRING)
+  {
+    startRun(sentMs);
+  }
+}
+
+void TtffBench::startRun(uint32_t startMs)
+{
+  mRunStartMs = startMs;
+  mFixAtMs = 0;
+  mEpochsValid = false;
+  mCurrent.timeMs = NO_TIME;
+  mCurrent.fixMs = NO_TIME;
+  mCurrent.fix3dMs = NO_TIME;
+  mCurrent.moduleTtffMs = NO_TIME;
+  mCurrent.maxSats = 0;
+  mSatsInView = 0;
+  mNumSatSamples = 0;
+  nav_status_t status;
+  while(mNavStatus.pop(status))
+  {
+    // from before the reset
+  }
+}
+
+TtffBench::Action TtffBench::update(uint32_t nowMs)
+{
+  if(mState == STATE_RESET_DUE)
+  {
+    mState = STATE_ACQUIRING;
+    mStartType = mNextStartType;
+    mRun = mNextRun;
+    startRun(nowMs);
+    return ACTION_RESET;
+  }
+  if(!isRunning())
+  {
+    return ACTION_NONE;
+  }
+
+  // NAV-STATUS sent since the reset: the module's time since its reset matches ours
+  nav_status_t status;
+  while(mNavStatus.pop(status))
+  {
+    uint32_t sinceResetMs = status.rxMs - mRunStartMs;
+    if((int32_t)sinceResetMs < 0 || status.msss > sinceResetMs + MSSS_TOLERANCE_MS)
+    {
+      continue;
+    }
+    if(status.fixType > 0 && mCurrent.moduleTtffMs == NO_TIME)
+    {
+      mCurrent.moduleTtffMs = status.ttffMs;
+    }
+    observe(status.timeValid, status.fixType, status.rxMs);
+  }
+
+  // satellites in view once a second
+  uint32_t elapsedMs = nowMs - mRunStartMs;
+  while(mNumSatSamples < MAX_SAT_SAMPLES && elapsedMs >= mNumSatSamples * 1000UL)
+  {
+    mSatSamples[mNumSatSamples++] = mSatsInView;
+  }
+
+  if((mState == STATE_ACQUIRING && elapsedMs >= mConfig.timeoutMs) ||
+     (mState == STATE_SETTLING && nowMs - mFixAtMs >= mConfig.settleMs))
+  {
+    finishRun();
+    return ACTION_RUN_DONE;
+  }
+  return ACTION_NONE;
+}
+
+void TtffBench::onEpoch(const SatStore::sat_epoch_t& epoch, uint32_t nowMs)
+{
+  if(!isRunning())
+  {
+    return;
+  }
+  mSatsInView = epoch.numSats;
+  if(epoch.numSats > mCurrent.maxSats)
+  {
+    mCurrent.maxSats = epoch.numSats;
+  }
+  if(!mEpochsValid)
+  {
+    // the module has evidently been reset once it reports no fix
+    mEpochsValid = (epoch.fixType == 0);
+    if(!mEpochsValid)
+    {
+      return;
+    }
+  }
+  observe(epoch.timeValid, epoch.fixType, nowMs);
+}
+
+void TtffBench::decodeNavStatus(const uint8_t* pPayload, uint16_t len, uint32_t nowMs)
+{
+  if(len < NAV_STATUS_LEN)
+  {
+    return;
+  }
+  nav_status_t status;
+  status.fixType = (pPayload[5] & NAV_STATUS_FIX_OK) ? UbxNavDecoder::getFixDimension(pPayload[4]) : 0;
+  status.timeValid = (pPayload[5] & NAV_STATUS_TIME_SET) == NAV_STATUS_TIME_SET;
+  status.ttffMs = readU4(&pPayload[8]);
+  status.msss = readU4(&pPayload[12]);
+  status.rxMs = nowMs;
+  mNavStatus.push(status);
+}
+
+void TtffBench::observe(bool timeValid, uint8_t fixType, uint32_t atMs)
+{
+  uint32_t sinceResetMs = atMs - mRunStartMs;
+  if(timeValid && mCurrent.timeMs == NO_TIME)
+  {
+    mCurrent.timeMs = sinceResetMs;
+  }
+  if(fixType >= 2 && mCurrent.fixMs == NO_TIME)
+  {
+    mCurrent.fixMs = sinceResetMs;
+    mFixAtMs = atMs;
+    mState = STATE_SETTLING;
+  }
+  if(fixType >= 3 && mCurrent.fix3dMs == NO_TIME)
+  {
+    mCurrent.fix3dMs = sinceResetMs;
+  }
+}
+
+void TtffBench::finishRun()
+{
+  mRuns[mStartType][mRun] = mCurrent;
+  mNumRuns[mStartType] = mRun + 1;
+  mState = findNextRun() ? STATE_RESET_DUE : STATE_DONE;
+}
+
+bool TtffBench::findNextRun()
+{
+  // the next run of the same start type, else the first one of the next enabled type (the current run stays until
+  // the next reset, see getLastRun()); false when all are through
+  if(mRun + 1 < mConfig.runsPerType)
+  {
+    mNextStartType = mStartType;
+    mNextRun = mRun + 1;
+    return true;
+  }
+  for(uint8_t type=mStartType + 1; type<START_NUM; type++)
+  {
+    if(isEnabled((StartType)type))
+    {
+      mNextStartType = (StartType)type;
+      mNextRun = 0;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool TtffBench::getStats(StartType type, uint32_t* pMinMs, uint32_t* pMedianMs, uint32_t* pMaxMs)
+{
+  // insertion sort of the runs w/ a fix (a handful at most)
+  uint32_t sorted[MAX_RUNS];
+  uint8_t num = 0;
+  for(uint8_t i=0; i<mNumRuns[type]; i++)
+  {
+    uint32_t fixMs = mRuns[type][i].fixMs;
+    if(fixMs == NO_TIME)
+    {
+      continue;
+    }
+    uint8_t pos = num++;
+    while(pos > 0 && sorted[pos - 1] > fixMs)
+    {
+      sorted[pos] = sorted[pos - 1];
+      pos--;
+    }
+    sorted[pos] = fixMs;
+  }
+  if(num == 0)
+  {
+    return false;
+  }
+  *pMinMs = sorted[0];
+  *pMedianMs = (num & 1) ? sorted[num / 2] : (sorted[num / 2 - 1] + sorted[num / 2]) / 2;
+  *pMaxMs = sorted[num - 1];
+  return true;
+}
+
+uint8_t TtffBench::getNumFixed(StartType type)
+{
+  uint8_t num = 0;
+  for(uint8_t i=0; i<mNumRuns[type]; i++)
+  {
+    if(mRuns[type][i].fixMs != NO_TIME)
+    {
+      num++;
+    }
+  }
+  return num;
+}
+
+const char* TtffBench::getStartName(StartType type)
+{
+  return (type < START_NUM) ? START_NAMES[type] : "";
+}
+
+void TtffBench::printTime(Print& out, uint32_t ms)
+{
+  out.print(",");
+  if(ms != NO_TIME)
+  {
+    out.print((unsigned long)ms);
+  }
+}
+
+void TtffBench::printModule(Print& out, uint8_t module)
+{
+  if(module > 0)
+  {
+    out.print(",MODULE:");
+    out.print(module);
+  }
+  out.println();
+}
+
+void TtffBench::printRun(Print& out, uint8_t module)
+{
+  const ttff_run_t& run = getLastRun();
+  out.print("TTFF,");
+  out.print(START_NAMES[mStartType]);
+  out.print(",");
+  out.print(mRun + 1);
+  printTime(out, run.timeMs);
+  printTime(out, run.fixMs);
+  printTime(out, run.fix3dMs);
+  printTime(out, run.moduleTtffMs);
+  out.print(",");
+  out.print(run.maxSats);
+  printModule(out, module);
+
+  out.print("TTFFSATS,");
+  out.print(START_NAMES[mStartType]);
+  out.print(",");
+  out.print(mRun + 1);
+  for(uint8_t i=0; i<mNumSatSamples; i++)
+  {
+    out.print(",");
+    out.print(mSatSamples[i]);
+  }
+  printModule(out, module);
+}
+
+void TtffBench::printSummary(Print& out, uint8_t module)
+{
+  for(uint8_t type=0; type<START_NUM; type++)
+  {
+    if(!isEnabled((StartType)type))
+    {
+      continue;
+    }
+    uint32_t minMs = NO_TIME;
+    uint32_t medianMs = NO_TIME;
+    uint32_t maxMs = NO_TIME;
+    getStats((StartType)type, &minMs, &medianMs, &maxMs);
+    out.print("TTFF-RESULT,");
+    out.print(START_NAMES[type]);
+    out.print(",");
+    out.print(getNumFixed((StartType)type));
+    out.print("/");
+    out.print(mNumRuns[type]);
+    printTime(out, minMs);
+    printTime(out, medianMs);
+    printTime(out, maxMs);
+    printModule(out, module);
+  }
+}
+
+uint8_t TtffBench::submitReset(UbxEngine& engine, StartType type)
+{
+  // CFG-RST: navBbrMask, resetMode, reserved; the module does not acknowledge it
+  uint16_t bbrMask = START_BBR_MASKS[(type < START_NUM) ? type : START_COLD];
+  const uint8_t payload[4] = {(uint8_t)(bbrMask & 0xFF), (uint8_t)(bbrMask >> 8), RESET_MODE_GNSS, 0};
+  return engine.submit(GpsSoftwareSerial::UBX_MSG_CLASS_CFG, UBX_MSG_ID_CFG_RST, payload, sizeof(payload), false,
+                       false);
+}
+
+uint8_t TtffBench::submitStatusOutput(UbxEngine& engine)
+{
+  // CFG-MSG w/ 3 bytes: NAV-STATUS every epoch on the port the request came in on
+  const uint8_t payload[3] = {GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_STATUS, 1};
+  return engine.submit(GpsSoftwareSerial::UBX_MSG_CLASS_CFG, GpsSoftwareSerial::UBX_MSG_ID_CFG_MSG, payload,
+                       sizeof(payload), false);
+}
@@ -0,0 +1,139 @@
+#ifndef Ttff_h
+#define Ttff_h
+
+#include <Arduino.h>
+#include "SatStore.h"
+#include "SpscRing.h"
+#include "UbxEngine.h"
+
+// Time-to-first-fix benchmark: the module is restarted with UBX CFG-RST (GNSS only, the UART and the configuration
+// stay) a number of times per start type -- cold (all aiding data cleared), warm (ephemerides cleared) and hot
+// (nothing cleared) -- and each run measures the time from the reset to the first valid time, the first fix and the
+// first 3D fix, together with the satellites in view once a second. Observations come from the epochs (GSV cycles or
+// NAV-SVINFO, with the time and fix at their end) and from NAV-STATUS when the module sends it, which also tells the
+// module's own TTFF. An epoch may still have been collected before the reset, and a module that ignores CFG-RST keeps
+// its fix, so the epochs only count once one without a fix has come in after the reset; NAV-STATUS counts when its
+// time since the reset (msss) fits. After the first fix the module keeps running for a while (it collects the
+// ephemerides the next hot start needs), then the next run starts; a run without a fix within the timeout fails.
+
+class TtffBench {
+  public:
+    static const uint8_t MAX_RUNS = 10; // per start type
+    static const uint8_t MAX_SAT_SAMPLES = 60; // satellites in view of the current run, one per second from the reset
+    static const uint32_t NO_TIME = 0xFFFFFFFF;
+
+    enum StartType {
+      START_COLD,
+      START_WARM,
+      START_HOT,
+      START_NUM
+    };
+    static const uint8_t START_MASK_ALL = (1 << START_NUM) - 1; // ttff_config_t::startTypes: (1 << StartType) each
+
+    enum Action {
+      ACTION_NONE,
+      ACTION_RESET, // a run starts: send CFG-RST for getStartType() now (see submitReset())
+      ACTION_RUN_DONE // a run is through (see getLastRun(), printRun()); after the last one, isDone()
+    };
+
+    typedef struct
+    {
+      uint8_t startTypes; // bit mask, the types run one after the other: cold, warm, hot
+      uint8_t runsPerType; // up to MAX_RUNS
+      uint32_t timeoutMs; // per run, from the reset to the first fix
+      uint32_t settleMs; // from the first fix to the next reset
+    } ttff_config_t;
+
+    // times from the reset (NO_TIME: not within the run)
+    typedef struct
+    {
+      uint32_t timeMs; // first valid time
+      uint32_t fixMs; // first fix (2D or better)
+      uint32_t fix3dMs;
+      uint32_t moduleTtffMs; // as told by NAV-STATUS
+      uint8_t maxSats; // most satellites in view in one epoch
+    } ttff_run_t;
+
+    TtffBench();
+
+    void begin(const ttff_config_t& config); // the first run starts w/ the next update()
+    Action update(uint32_t nowMs); // call often (every 100 ms or so)
+    void onResetSent(uint32_t sentMs); // the run is timed from then on (CFG-RST may have waited for room to be sent)
+    void onEpoch(const SatStore::sat_epoch_t& epoch, uint32_t nowMs); // each epoch taken from the satellite store
+
+    // NAV-STATUS payload, may be called from another context (the UBX handler in the RX task)
+    void decodeNavStatus(const uint8_t* pPayload, uint16_t len, uint32_t nowMs);
+
+    bool isRunning() { return mState != STATE_IDLE && mState != STATE_DONE; }
+    bool isDone() { return mState == STATE_DONE; }
+    bool hasFix() { return mState == STATE_SETTLING; } // of the current run
+    StartType getStartType() { return mStartType; } // of the current (or last) run
+    uint8_t getRunNumber() { return mRun + 1; } // within its start type
+    uint8_t getRunsPerType() { return mConfig.runsPerType; }
+    uint32_t getElapsedMs(uint32_t nowMs) { return nowMs - mRunStartMs; } // since the reset of the current run
+    uint8_t getSatsInView() { return mSatsInView; } // latest epoch
+    const ttff_run_t& getCurrentRun() { return mCurrent; }
+    const ttff_run_t& getLastRun() { return mRuns[mStartType][mRun]; } // after ACTION_RUN_DONE
+
+    // min/median/max of the first fix over the runs of `type` w/ a fix; false when there is none yet
+    bool getStats(StartType type, uint32_t* pMinMs, uint32_t* pMedianMs, uint32_t* pMaxMs);
+    uint8_t getNumFixed(StartType type);
+    uint8_t getNumRuns(StartType type) { return mNumRuns[type]; } // through so far
+    bool isEnabled(StartType type) { return (mConfig.startTypes & (1 << type)) != 0; }
+    static const char* getStartName(StartType type);
+
+    // machine-readable: "TTFF,<type>,<run>,<time>,<fix>,<3D fix>,<module TTFF>,<max. sats>" (ms, empty when there is
+    // none) and "TTFFSATS,<type>,<run>,<sats in view each second>..." for the run just through;
+    // "TTFF-RESULT,<type>,<runs w/ a fix>/<runs>,<min>,<median>,<max>" for each start type; all followed by
+    // ",MODULE:<module>" when testing several modules (`module` > 0)
+    void printRun(Print& out, uint8_t module = 0);
+    void printSummary(Print& out, uint8_t module = 0);
+
+    // requests queued with `engine`: CFG-RST (GNSS only) for `type`, NAV-STATUS output every epoch; the request's id
+    // or UbxEngine::NO_REQUEST
+    static uint8_t submitReset(UbxEngine& engine, StartType type);
+    static uint8_t submitStatusOutput(UbxEngine& engine);
+  private:
+    enum State {
+      STATE_IDLE,
+      STATE_RESET_DUE,
+      STATE_ACQUIRING, // reset sent, waiting for the first fix
+      STATE_SETTLING, // fixed, waiting before the next reset
+      STATE_DONE
+    };
+
+    typedef struct
+    {
+      uint8_t fixType; // 0, 2 or 3 (see UbxNavDecoder::getFixDimension())
+      bool timeValid; // week number and time of week
+      uint32_t ttffMs;
+      uint32_t msss; // since the reset
+      uint32_t rxMs; // millis() when received
+    } nav_status_t;
+
+    void startRun(uint32_t startMs); // clears the current run
+    void observe(bool timeValid, uint8_t fixType, uint32_t atMs);
+    void finishRun();
+    bool findNextRun();
+    static void printTime(Print& out, uint32_t ms);
+    static void printModule(Print& out, uint8_t module);
+
+    ttff_config_t mConfig;
+    State mState;
+    StartType mStartType;
+    uint8_t mRun;
+    StartType mNextStartType; // taken over with the next reset
+    uint8_t mNextRun;
+    uint32_t mRunStartMs;
+    uint32_t mFixAtMs; // millis() of the first fix of the current run
+    bool mEpochsValid; // an epoch w/o a fix has come in since the reset
+    ttff_run_t mCurrent;
+    uint8_t mSatsInView;
+    uint8_t mNumSatSamples;
+    uint8_t mSatSamples[MAX_SAT_SAMPLES];
+    ttff_run_t mRuns[START_NUM][MAX_RUNS];
+    uint8_t mNumRuns[START_NUM];
+    SpscRing<nav_status_t, 4> mNavStatus; // pushed by decodeNavStatus(), popped by update()
+};
+
+#endif
@@ -0,0 +1,281 @@
+#include "UbxEngine.h"
+
+namespace {
+  const uint8_t DEFAULT_WINDOW = 8;
+  const uint32_t DEFAULT_TIMEOUT_MS = 1000;
+  const uint8_t DEFAULT_RETRIES = 1;
+}
+
+UbxEngine::UbxEngine(GpsSoftwareSerial& gps) :
+    mGps(gps),
+    mMaxInFlight(DEFAULT_WINDOW),
+    mTimeoutUs(DEFAULT_TIMEOUT_MS * 1000),
+    mRetries(DEFAULT_RETRIES),
+    mNumQueued(0),
+    mNumInFlight(0),
+    mNextSeq(0),
+    mUnmatched(0)
+{
+  for(uint8_t i=0; i<MAX_REQUESTS; i++)
+  {
+    mRequests[i].state = REQ_FREE;
+  }
+}
+
+void UbxEngine::begin()
+{
+  mGps.addUbxHandler(GpsSoftwareSerial::UBX_ANY, GpsSoftwareSerial::UBX_ANY, onUbxFrame, this);
+}
+
+void UbxEngine::onUbxFrame(uint8_t msgClass, uint8_t msgId, const uint8_t* pPayload, uint16_t len, void* pContext)
+{
+  // runs in the RX context: only hand the frame over (the payload is not valid after the call, so keep its start)
+  UbxEngine* pThis = (UbxEngine*)pContext;
+  rx_frame_t frame;
+  frame.msgClass = msgClass;
+  frame.msgId = msgId;
+  frame.prefixLen = (len < FRAME_PREFIX_LEN) ? len : FRAME_PREFIX_LEN;
+  memcpy(frame.prefix, pPayload, frame.prefixLen);
+  frame.timeUs = micros();
+  pThis->mFrames.push(frame);
+}
+
+uint8_t UbxEngine::submit(uint8_t msgClass, uint8_t msgId, const uint8_t* pPayload, uint8_t len, bool isPoll,
+                          bool expectsAck)
+{
+  if(len > MAX_PAYLOAD_LEN || (len > 0 && pPayload == nullptr))
+  {
+    return NO_REQUEST;
+  }
+  for(uint8_t i=0; i<MAX_REQUESTS; i++)
+  {
+    ubx_request_t& req = mRequests[i];
+    if(req.state != REQ_FREE)
+    {
+      continue;
+    }
+    req.state = REQ_QUEUED;
+    req.msgClass = msgClass;
+    req.msgId = msgId;
+    req.isPoll = isPoll;
+    req.expectsAck = expectsAck && (msgClass == GpsSoftwareSerial::UBX_MSG_CLASS_CFG);
+    req.gotAnswer = false;
+    req.gotAck = false;
+    req.attempts = 0;
+    req.payloadLen = len;
+    if(len > 0)
+    {
+      memcpy(req.payload, pPayload, len);
+    }
+    req.seq = mNextSeq++;
+    req.sentUs = 0;
+    req.rttUs = 0;
+    mNumQueued++;
+    return i;
+  }
+  return NO_REQUEST;
+}
+
+uint8_t UbxEngine::poll(GpsSoftwareSerial::UbxMessage msg)
+{
+  if(msg >= GpsSoftwareSerial::UBX_MSG_NUM)
+  {
+    return NO_REQUEST;
+  }
+  const GpsSoftwareSerial::UbxMessageInfo& info = GpsSoftwareSerial::UBX_MESSAGES[msg];
+  return submit(info.msgClass, info.msgId, GpsSoftwareSerial::getPollPayload(msg), info.pollPayloadLen, true);
+}
+
+void UbxEngine::update()
+{
+  rx_frame_t frame;
+  while(mFrames.pop(frame))
+  {
+    match(frame);
+  }
+
+  // time-outs: send again while there are attempts left (keeping the place in the window), otherwise give up
+  uint32_t nowUs = micros();
+  for(uint8_t i=0; i<MAX_REQUESTS; i++)
+  {
+    ubx_request_t& req = mRequests[i];
+    if(req.state != REQ_IN_FLIGHT || (uint32_t)(nowUs - req.sentUs) < mTimeoutUs)
+    {
+      continue;
+    }
+    if(req.gotAnswer)
+    {
+      complete(req, REQ_ANSWERED, req.sentUs + req.rttUs); // answered, only the ACK is missing
+    }
+    else if(req.attempts > mRetries || !send(req))
+    {
+      complete(req, REQ_TIMED_OUT, nowUs);
+    }
+  }
+
+  // fill the window in the order of submission
+  while(mNumQueued > 0 && mNumInFlight < mMaxInFlight)
+  {
+    ubx_request_t* pNext = nullptr;
+    for(uint8_t i=0; i<MAX_REQUESTS; i++)
+    {
+      ubx_request_t& req = mRequests[i];
+      if(req.state == REQ_QUEUED && (pNext == nullptr || (int16_t)(req.seq - pNext->seq) < 0))
+      {
+        pNext = &req;
+      }
+    }
+    pNext->state = REQ_IN_FLIGHT;
+    mNumQueued--;
+    mNumInFlight++;
+    if(!send(*pNext))
+    {
+      complete(*pNext, REQ_TIMED_OUT, micros());
+    }
+    else if(!pNext->isPoll && !pNext->expectsAck)
+    {
+      complete(*pNext, REQ_SENT, pNext->sentUs);
+    }
+  }
+}
+
+bool UbxEngine::send(ubx_request_t& req)
+{
+  req.attempts++;
+  req.sentUs = micros();
+  return mGps.sendUbxMessage(req.msgClass, req.msgId, req.payload, req.payloadLen);
+}
+
+void UbxEngine::complete(ubx_request_t& req, uint8_t state, uint32_t timeUs)
+{
+  req.state = state;
+  req.rttUs = timeUs - req.sentUs;
+  mNumInFlight--;
+}
+
+void UbxEngine::match(const rx_frame_t& frame)
+{
+  if(frame.msgClass == GpsSoftwareSerial::UBX_MSG_CLASS_ACK)
+  {
+    // the payload of ACK-ACK/-NAK is the class and ID of the message concerned
+    if(frame.prefixLen < 2)
+    {
+      return;
+    }
+    uint8_t id = findOldestInFlight(frame.prefix[0], frame.prefix[1], false, nullptr);
+    if(id == NO_REQUEST)
+    {
+      mUnmatched++;
+      return;
+    }
+    ubx_request_t& req = mRequests[id];
+    if(frame.msgId == GpsSoftwareSerial::UBX_MSG_ID_ACK_NAK)
+    {
+      complete(req, REQ_NAKED, frame.timeUs);
+    }
+    else
+    {
+      req.gotAck = true;
+      if(!req.isPoll)
+      {
+        complete(req, REQ_ACKED, frame.timeUs);
+      }
+      else if(req.gotAnswer)
+      {
+        complete(req, REQ_ANSWERED, req.sentUs + req.rttUs); // the round trip is the one of the answer
+      }
+    }
+    return;
+  }
+
+  // anything else may be the answer of a poll (or just a periodic message, which matches nothing)
+  uint8_t id = findOldestInFlight(frame.msgClass, frame.msgId, true, &frame);
+  if(id == NO_REQUEST)
+  {
+    return;
+  }
+  ubx_request_t& req = mRequests[id];
+  req.gotAnswer = true;
+  req.rttUs = frame.timeUs - req.sentUs;
+  if(!req.expectsAck || req.gotAck)
+  {
+    complete(req, REQ_ANSWERED, frame.timeUs);
+  }
+}
+
+uint8_t UbxEngine::findOldestInFlight(uint8_t msgClass, uint8_t msgId, bool forAnswer, const rx_frame_t* pFrame)
+{
+  uint8_t oldest = NO_REQUEST;
+  for(uint8_t i=0; i<MAX_REQUESTS; i++)
+  {
+    ubx_request_t& req = mRequests[i];
+    if(req.state != REQ_IN_FLIGHT || req.msgClass != msgClass || req.msgId != msgId)
+    {
+      continue;
+    }
+    if(forAnswer)
+    {
+      // a poll that is still waiting for its answer, and the answer is for what was polled (as far as it is kept)
+      uint8_t cmpLen = (req.payloadLen < FRAME_PREFIX_LEN) ? req.payloadLen : FRAME_PREFIX_LEN;
+      if(!req.isPoll || req.gotAnswer || pFrame->prefixLen < cmpLen || memcmp(req.payload, pFrame->prefix, cmpLen) != 0)
+      {
+        continue;
+      }
+    }
+    else if(req.gotAck)
+    {
+      continue;
+    }
+    if(oldest == NO_REQUEST)
+    {
+      oldest = i;
+      continue;
+    }
+    // the module acknowledges a poll after answering it: polls that got their answer go first
+    const ubx_request_t& other = mRequests[oldest];
+    bool reqAnswered = req.isPoll && req.gotAnswer;
+    bool otherAnswered = other.isPoll && other.gotAnswer;
+    if((!forAnswer && reqAnswered != otherAnswered) ? reqAnswered : (int16_t)(req.seq - other.seq) < 0)
+    {
+      oldest = i;
+    }
+  }
+  return oldest;
+}
+
+uint8_t UbxEngine::findLatest(uint8_t msgClass, uint8_t msgId)
+{
+  uint8_t latest = NO_REQUEST;
+  for(uint8_t i=0; i<MAX_REQUESTS; i++)
+  {
+    ubx_request_t& req = mRequests[i];
+    if(req.state == REQ_FREE || req.msgClass != msgClass || req.msgId != msgId)
+    {
+      continue;
+    }
+    if(latest == NO_REQUEST || (int16_t)(req.seq - mRequests[latest].seq) > 0)
+    {
+      latest = i;
+    }
+  }
+  return latest;
+}
+
+void UbxEngine::release(uint8_t id)
+{
+  if(isDone(id))
+  {
+    mRequests[id].state = REQ_FREE;
+  }
+}
+
+void UbxEngine::clear()
+{
+  for(uint8_t i=0; i<MAX_REQUESTS; i++)
+  {
+    if(isDone(i))
+    {
+      mRequests[i].state = REQ_FREE;
+    }
+  }
+}
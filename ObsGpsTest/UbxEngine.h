@@ -0,0 +1,108 @@
+#ifndef UbxEngine_h
+#define UbxEngine_h
+
+#include <Arduino.h>
+#include "GpsSerial.h"
+#include "SpscRing.h"
+
+// UBX command engine: requests (polls and commands with arbitrary payloads) are queued, sent as soon as there is room
+// in the window of outstanding requests and matched with what the module answers:
+// - a poll is answered by the polled message itself (when the poll had a payload, e.g. the message class/ID of a
+//   CFG-MSG poll or the port of a CFG-PRT poll, the answer's payload starts with the same bytes),
+// - everything of class CFG is acknowledged by ACK-ACK (after the answer of a poll) or rejected by ACK-NAK, except for
+//   the commands submitted without expecting an ACK (CFG-RST: the module resets instead), which are done once sent.
+// Several outstanding requests for the same message are matched in the order they were sent (an ACK-ACK preferably
+// with a poll that has got its answer already). Each request has a timeout and is re-sent a configurable number of
+// times before it is given up; its round trip time is measured from the (last) sending to the matching answer.
+// Frames are taken from the GPS serial's UBX handler (that may be the RX task in pipeline mode) through a lock-free
+// queue, everything else happens in update() in loop().
+
+class UbxEngine {
+  public:
+    static const uint8_t MAX_REQUESTS = 32;
+    static const uint8_t MAX_PAYLOAD_LEN = 32;
+    static const uint8_t NO_REQUEST = 0xFF;
+
+    enum RequestState {
+      REQ_FREE,
+      REQ_QUEUED, // waiting for room in the window
+      REQ_IN_FLIGHT, // sent, waiting for the answer and/or ACK
+      REQ_ANSWERED, // done: the poll was answered (and acknowledged, where expected)
+      REQ_ACKED, // done: the command was acknowledged
+      REQ_NAKED, // done: rejected by the module
+      REQ_TIMED_OUT, // done: no (complete) answer after all attempts
+      REQ_SENT // done: sent, nothing comes back (a command submitted w/o expecting an ACK)
+    };
+
+    typedef struct
+    {
+      uint8_t state; // RequestState
+      uint8_t msgClass;
+      uint8_t msgId;
+      bool isPoll; // expects the message back
+      bool expectsAck; // class CFG
+      bool gotAnswer;
+      bool gotAck;
+      uint8_t attempts; // how often it has been sent
+      uint8_t payloadLen;
+      uint8_t payload[MAX_PAYLOAD_LEN];
+      uint16_t seq; // order of submission (requests are sent in that order, the oldest outstanding one matches first)
+      uint32_t sentUs; // micros() of the last sending
+      uint32_t rttUs; // sending to answer (or ACK/NAK), only valid when done
+    } ubx_request_t;
+
+    explicit UbxEngine(GpsSoftwareSerial& gps);
+
+    void begin(); // registers with the GPS serial's UBX handlers
+    void setWindow(uint8_t maxInFlight) { mMaxInFlight = (maxInFlight > 0) ? maxInFlight : 1; }
+    void setTimeout(uint32_t timeoutMs, uint8_t retries) { mTimeoutUs = timeoutMs * 1000; mRetries = retries; }
+
+    // both return the request's id (for getRequest()) or NO_REQUEST when all slots are taken; `expectsAck`: false for
+    // the CFG messages the module does not acknowledge
+    uint8_t submit(uint8_t msgClass, uint8_t msgId, const uint8_t* pPayload, uint8_t len, bool isPoll,
+                   bool expectsAck = true);
+    uint8_t poll(GpsSoftwareSerial::UbxMessage msg); // with the registry's poll payload
+
+    void update(); // matches the frames received, handles timeouts and sends what fits into the window
+
+    bool isIdle() { return mNumQueued == 0 && mNumInFlight == 0; }
+    bool isDone(uint8_t id) { return id < MAX_REQUESTS && mRequests[id].state >= REQ_ANSWERED; }
+    const ubx_request_t& getRequest(uint8_t id) { return mRequests[id]; }
+    uint8_t findLatest(uint8_t msgClass, uint8_t msgId); // latest request for that message, NO_REQUEST if none
+    void clear(); // frees all requests that are done
+    void release(uint8_t id); // frees that request if it is done (its id may be handed out again)
+
+    unsigned int getUnmatchedCount() { return mUnmatched; } // ACK-ACK/-NAK that matched no request
+    unsigned int getDropCount() { return mFrames.getDropCount(); } // frames lost as update() did not keep up
+  private:
+    static const size_t FRAME_QUEUE_SIZE = 32;
+    static const uint8_t FRAME_PREFIX_LEN = 8; // payload bytes kept per frame for the matching
+
+    typedef struct
+    {
+      uint8_t msgClass;
+      uint8_t msgId;
+      uint8_t prefixLen;
+      uint8_t prefix[FRAME_PREFIX_LEN];
+      uint32_t timeUs; // micros() when the frame was complete
+    } rx_frame_t;
+
+    static void onUbxFrame(uint8_t msgClass, uint8_t msgId, const uint8_t* pPayload, uint16_t len, void* pContext);
+    void match(const rx_frame_t& frame);
+    uint8_t findOldestInFlight(uint8_t msgClass, uint8_t msgId, bool forAnswer, const rx_frame_t* pFrame);
+    void complete(ubx_request_t& req, uint8_t state, uint32_t timeUs);
+    bool send(ubx_request_t& req);
+
+    GpsSoftwareSerial& mGps;
+    ubx_request_t mRequests[MAX_REQUESTS];
+    SpscRing<rx_frame_t, FRAME_QUEUE_SIZE> mFrames; // pushed from the UBX handler, popped by update()
+    uint8_t mMaxInFlight;
+    uint32_t mTimeoutUs;
+    uint8_t mRetries;
+    uint8_t mNumQueued;
+    uint8_t mNumInFlight;
+    uint16_t mNextSeq;
+    unsigned int mUnmatched;
+};
+
+#endif
@@ -0,0 +1,257 @@
+#include "UbxNav.h"
+#include "GsvParser.h"
+
+namespace
+{
+  const uint8_t UBX_MSG_ID_CFG_MSG = GpsSoftwareSerial::UBX_MSG_ID_CFG_MSG;
+  const uint8_t UBX_MSG_ID_CFG_RATE = GpsSoftwareSerial::UBX_MSG_ID_CFG_RATE;
+  const uint8_t NMEA_STD_CLASS = 0xF0; // class of the standard NMEA sentences in CFG-MSG
+  const uint8_t NMEA_STD_IDS[UbxNavDecoder::NUM_NMEA_OFF] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05}; // GGA GLL GSA GSV RMC VTG
+  const uint8_t SVINFO_QUALITY_MASK = 0x0F; // quality indicator, 0: channel idle
+  const uint8_t TIMEUTC_VALID_UTC = 0x04;
+  const uint32_t MS_PER_DAY = 86400000UL;
+  const uint32_t MS_PER_WEEK = 604800000UL;
+  const int32_t TIME_MAX_AGE_MS = 10000; // NAV-TIMEUTC older (or newer) than that is not used for an epoch
+
+  uint16_t readU2(const uint8_t* p)
+  {
+    return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+  }
+
+  uint32_t readU4(const uint8_t* p)
+  {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+  }
+
+  uint8_t submitCfgMsg(UbxEngine& engine, uint8_t msgClass, uint8_t msgId, uint8_t rate)
+  {
+    // CFG-MSG w/ 3 bytes: output rate on the port the request came in on (in epochs, 0: off)
+    const uint8_t payload[3] = {msgClass, msgId, rate};
+    return engine.submit(GpsSoftwareSerial::UBX_MSG_CLASS_CFG, UBX_MSG_ID_CFG_MSG, payload, sizeof(payload), false);
+  }
+
+  uint8_t collectId(uint8_t id, uint8_t* pIds, uint8_t numIds)
+  {
+    if(id != UbxEngine::NO_REQUEST)
+    {
+      pIds[numIds++] = id;
+    }
+    return numIds;
+  }
+}
+
+UbxNavDecoder::UbxNavDecoder() :
+    mTimeValid(false),
+    mTimeItow(0),
+    mTimeOfDayMs(0),
+    mEpochCount(0),
+    mLengthErrorCount(0),
+    mNumChannels(0),
+    mFixType(0),
+    mNumSatsUsed(0)
+{
+}
+
+uint8_t UbxNavDecoder::decode(uint8_t msgClass, uint8_t msgId, const uint8_t* pPayload, uint16_t len, SatStore& store)
+{
+  if(msgClass != GpsSoftwareSerial::UBX_MSG_CLASS_NAV)
+  {
+    return 0;
+  }
+
+  switch(msgId)
+  {
+    case GpsSoftwareSerial::UBX_MSG_ID_NAV_SVINFO:
+    {
+      if(len < SVINFO_HEADER_LEN || len < SVINFO_HEADER_LEN + pPayload[4] * SVINFO_BLOCK_LEN)
+      {
+        ++mLengthErrorCount;
+        return 0;
+      }
+      uint8_t numCh = pPayload[4];
+      for(uint8_t i=0; i<numCh; i++)
+      {
+        const uint8_t* pBlock = &pPayload[SVINFO_HEADER_LEN + i * SVINFO_BLOCK_LEN];
+        uint8_t quality = pBlock[3] & SVINFO_QUALITY_MASK;
+        uint8_t cno = pBlock[4];
+        int8_t elevation = (int8_t)pBlock[5];
+        int16_t azimuth = (int16_t)readU2(&pBlock[6]);
+        uint8_t system;
+        uint8_t prn;
+        // like $--GSV: satellites in view only (idle channels and ones below the horizon are left out)
+        if((quality == 0 && cno == 0) || elevation < 0 || !mapSvId(pBlock[1], &system, &prn))
+        {
+          continue;
+        }
+        store.update(system, prn, elevation, (azimuth < 0) ? 0 : azimuth, cno);
+      }
+      setEpochTime(readU4(&pPayload[0]), store);
+      store.setFix(getFixDimension(mFixType));
+      mNumChannels = numCh;
+      ++mEpochCount;
+      return UBX_NAV_EVENT_EPOCH;
+    }
+
+    case GpsSoftwareSerial::UBX_MSG_ID_NAV_TIMEUTC:
+      if(len < TIMEUTC_LEN)
+      {
+        ++mLengthErrorCount;
+        return 0;
+      }
+      mTimeValid = (pPayload[19] & TIMEUTC_VALID_UTC) != 0;
+      mTimeItow = readU4(&pPayload[0]);
+      // hour, minute, second, plus the fraction (-1e9..1e9 ns) the epoch is away from that
+      mTimeOfDayMs = ((pPayload[16] * 60L + pPayload[17]) * 60L + pPayload[18]) * 1000L +
+                     (int32_t)readU4(&pPayload[8]) / 1000000L;
+      return UBX_NAV_EVENT_TIME;
+
+    case GpsSoftwareSerial::UBX_MSG_ID_NAV_SOL:
+      if(len < SOL_LEN)
+      {
+        ++mLengthErrorCount;
+        return 0;
+      }
+      mFixType = pPayload[10];
+      mNumSatsUsed = pPayload[47];
+      return UBX_NAV_EVENT_SOL;
+
+    default:
+      return 0;
+  }
+}
+
+void UbxNavDecoder::setEpochTime(uint32_t iTow, SatStore& store)
+{
+  // time of the epoch = time of the latest NAV-TIMEUTC plus the time of week elapsed since then
+  int32_t ageMs = (int32_t)(iTow - mTimeItow);
+  if(ageMs > (int32_t)(MS_PER_WEEK / 2))
+  {
+    ageMs -= MS_PER_WEEK; // iTOW wrapped at the end of the week
+  }
+  else if(ageMs < -(int32_t)(MS_PER_WEEK / 2))
+  {
+    ageMs += MS_PER_WEEK;
+  }
+  if(!mTimeValid || ageMs > TIME_MAX_AGE_MS || ageMs < -TIME_MAX_AGE_MS)
+  {
+    store.setTime(false, 0, 0, 0);
+    return;
+  }
+  int32_t timeOfDayMs = (mTimeOfDayMs + ageMs) % (int32_t)MS_PER_DAY;
+  if(timeOfDayMs < 0)
+  {
+    timeOfDayMs += MS_PER_DAY;
+  }
+  uint32_t timeOfDaySec = timeOfDayMs / 1000;
+  store.setTime(true, timeOfDaySec / 3600, (timeOfDaySec / 60) % 60, timeOfDaySec % 60);
+}
+
+uint8_t UbxNavDecoder::getFixDimension(uint8_t fixType)
+{
+  // NAV-SOL/NAV-STATUS gpsFix: 0: none, 1: dead reckoning only, 2: 2D, 3: 3D, 4: GPS + dead reckoning, 5: time only
+  switch(fixType)
+  {
+    case 2:
+      return 2;
+    case 3:
+    case 4:
+      return 3;
+    default:
+      return 0;
+  }
+}
+
+bool UbxNavDecoder::mapSvId(uint8_t svId, uint8_t* pSystem, uint8_t* pPrn)
+{
+  // UBX numbering of the satellites (differs from the NMEA one for BeiDou and Galileo)
+  if(svId >= 1 && svId <= 32)
+  {
+    *pSystem = GsvParser::GNSS_GPS;
+    *pPrn = svId;
+  }
+  else if(svId >= 33 && svId <= 64)
+  {
+    *pSystem = GsvParser::GNSS_BEIDOU;
+    *pPrn = svId - 27; // 6..37
+  }
+  else if(svId >= 65 && svId <= 96)
+  {
+    *pSystem = GsvParser::GNSS_GLONASS;
+    *pPrn = svId - 64;
+  }
+  else if(svId >= 120 && svId <= 158)
+  {
+    *pSystem = GsvParser::GNSS_SBAS;
+    *pPrn = svId;
+  }
+  else if(svId >= 159 && svId <= 163)
+  {
+    *pSystem = GsvParser::GNSS_BEIDOU;
+    *pPrn = svId - 158; // 1..5
+  }
+  else if(svId >= 193 && svId <= 200)
+  {
+    *pSystem = GsvParser::GNSS_QZSS;
+    *pPrn = svId - 192;
+  }
+  else if(svId >= 211 && svId <= 246)
+  {
+    *pSystem = GsvParser::GNSS_GALILEO;
+    *pPrn = svId - 210;
+  }
+  else
+  {
+    return false; // 0 (unused channel) and 255 (GLONASS, slot unknown)
+  }
+  return true;
+}
+
+uint8_t UbxNavDecoder::getMaxRateHz(long baudRate, uint8_t numChannels, uint8_t maxHz)
+{
+  uint32_t bytesPerSec = baudRate / 10;
+  uint32_t auxBytes = 2 * FRAMING_LEN + TIMEUTC_LEN + SOL_LEN;
+  uint32_t epochBytes = FRAMING_LEN + SVINFO_HEADER_LEN + numChannels * SVINFO_BLOCK_LEN;
+  uint32_t hz = (bytesPerSec > auxBytes) ? (bytesPerSec - auxBytes) / epochBytes : 0;
+  if(hz > maxHz)
+  {
+    hz = maxHz;
+  }
+  return (hz > 0) ? hz : 1;
+}
+
+uint8_t UbxNavDecoder::submitNavOutput(UbxEngine& engine, uint8_t* pIds)
+{
+  uint8_t numIds = 0;
+  numIds = collectId(submitCfgMsg(engine, GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_SVINFO, 1),
+                     pIds, numIds);
+  numIds = collectId(submitCfgMsg(engine, GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_TIMEUTC, 1),
+                     pIds, numIds);
+  numIds = collectId(submitCfgMsg(engine, GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_SOL, 1),
+                     pIds, numIds);
+  return numIds;
+}
+
+uint8_t UbxNavDecoder::submitNmeaOff(UbxEngine& engine, uint8_t* pIds)
+{
+  uint8_t numIds = 0;
+  for(uint8_t i=0; i<NUM_NMEA_OFF; i++)
+  {
+    numIds = collectId(submitCfgMsg(engine, NMEA_STD_CLASS, NMEA_STD_IDS[i], 0), pIds, numIds);
+  }
+  return numIds;
+}
+
+uint8_t UbxNavDecoder::submitRate(UbxEngine& engine, uint8_t rateHz, uint8_t* pIds)
+{
+  // CFG-RATE: measurement period (ms), navigation rate (1: a solution per measurement), time reference (1: GPS time)
+  uint16_t measRateMs = 1000 / ((rateHz > 0) ? rateHz : 1);
+  const uint8_t payload[6] = {(uint8_t)(measRateMs & 0xFF), (uint8_t)(measRateMs >> 8), 1, 0, 1, 0};
+  uint8_t numIds = 0;
+  numIds = collectId(submitCfgMsg(engine, GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_TIMEUTC,
+                                  rateHz), pIds, numIds);
+  numIds = collectId(submitCfgMsg(engine, GpsSoftwareSerial::UBX_MSG_CLASS_NAV, GpsSoftwareSerial::UBX_MSG_ID_NAV_SOL,
+                                  rateHz), pIds, numIds);
+  numIds = collectId(engine.submit(GpsSoftwareSerial::UBX_MSG_CLASS_CFG, UBX_MSG_ID_CFG_RATE, payload, sizeof(payload),
+                                   false), pIds, numIds);
+  return numIds;
+}
@@ -0,0 +1,76 @@
+#ifndef UbxNav_h
+#define UbxNav_h
+
+#include <Arduino.h>
+#include <atomic>
+#include "SatStore.h"
+#include "UbxEngine.h"
+
+// Binary navigation data of u-blox modules, as an alternative to the NMEA text: NAV-SVINFO (all channels with
+// satellite, signal strength, elevation and azimuth) is decoded straight into the satellite table, one frame is one
+// epoch; the clock comes from NAV-TIMEUTC, which only needs to be sent about once a second as the time of the epochs
+// in between follows from their time of week (iTOW); NAV-SOL is kept for the fix type and the number of satellites used.
+// Per epoch, that is 16 bytes of framing plus 12 bytes per channel, instead of about 500 bytes of RMC, GGA, GSA, GSV...
+// sentences, which is what allows for 5-10 Hz at 9600 baud. The module is configured for it with UBX CFG-MSG and
+// CFG-RATE requests through the UBX engine, step by step: NMEA is only turned off when the module has taken the UBX
+// output, and the rate is only raised when the first NAV-SVINFO has told the number of channels.
+
+class UbxNavDecoder {
+  public:
+    static const uint8_t UBX_NAV_EVENT_EPOCH = 0x01; // an epoch (NAV-SVINFO) has been decoded into the satellite table
+    static const uint8_t UBX_NAV_EVENT_TIME = 0x02; // NAV-TIMEUTC decoded
+    static const uint8_t UBX_NAV_EVENT_SOL = 0x04; // NAV-SOL decoded
+
+    static const uint16_t SVINFO_HEADER_LEN = 8;
+    static const uint16_t SVINFO_BLOCK_LEN = 12; // per channel
+    static const uint16_t TIMEUTC_LEN = 20;
+    static const uint16_t SOL_LEN = 52;
+    static const uint8_t FRAMING_LEN = 8; // sync chars, class, ID, length and checksum
+    static const uint8_t NUM_NMEA_OFF = 6; // standard sentences turned off: GGA, GLL, GSA, GSV, RMC, VTG
+    static const uint8_t MAX_CONFIG_REQUESTS = NUM_NMEA_OFF; // the largest of the configuration steps
+
+    UbxNavDecoder();
+
+    // decodes NAV-SVINFO/-TIMEUTC/-SOL (other frames are ignored); NAV-SVINFO goes into `store` with the time of the
+    // epoch, but publishing (or discarding) is up to the caller; returns UBX_NAV_EVENT_* flags
+    uint8_t decode(uint8_t msgClass, uint8_t msgId, const uint8_t* pPayload, uint16_t len, SatStore& store);
+
+    // decoder state, may be read from another context than the one decoding
+    unsigned int getEpochCount() { return mEpochCount.load(std::memory_order_relaxed); }
+    unsigned int getLengthErrorCount() { return mLengthErrorCount.load(std::memory_order_relaxed); } // payloads too short
+    uint8_t getNumChannels() { return mNumChannels.load(std::memory_order_relaxed); } // of the last NAV-SVINFO
+    uint8_t getFixType() { return mFixType.load(std::memory_order_relaxed); } // of the last NAV-SOL (0: no fix, 3: 3D...)
+    uint8_t getNumSatsUsed() { return mNumSatsUsed.load(std::memory_order_relaxed); }
+
+    // gpsFix of NAV-SOL/NAV-STATUS as 2 (2D), 3 (3D or w/ dead reckoning) or 0 (none, dead reckoning or time only)
+    static uint8_t getFixDimension(uint8_t fixType);
+
+    // highest epoch rate (up to `maxHz`) whose NAV-SVINFO w/ `numChannels` fits into `baudRate` (8N1), after
+    // NAV-TIMEUTC and NAV-SOL at 1 Hz
+    static uint8_t getMaxRateHz(long baudRate, uint8_t numChannels, uint8_t maxHz);
+
+    // configuration, each step queues its requests with `engine`, returns their ids (at most MAX_CONFIG_REQUESTS) in
+    // `pIds` and their number (less when the engine ran full):
+    // 1. NAV-SVINFO, NAV-TIMEUTC and NAV-SOL every epoch (at the module's current rate, usually 1 Hz)
+    // 2. the standard NMEA sentences off
+    // 3. epochs at `rateHz` (once the number of channels is known, see getMaxRateHz()), NAV-TIMEUTC and NAV-SOL
+    //    every `rateHz`th epoch only
+    static uint8_t submitNavOutput(UbxEngine& engine, uint8_t* pIds);
+    static uint8_t submitNmeaOff(UbxEngine& engine, uint8_t* pIds);
+    static uint8_t submitRate(UbxEngine& engine, uint8_t rateHz, uint8_t* pIds);
+  private:
+    static bool mapSvId(uint8_t svId, uint8_t* pSystem, uint8_t* pPrn);
+    void setEpochTime(uint32_t iTow, SatStore& store);
+
+    // latest NAV-TIMEUTC: UTC time of day at its time of week
+    bool mTimeValid;
+    uint32_t mTimeItow; // ms
+    int32_t mTimeOfDayMs; // may be off by the nanoseconds field, i.e. slightly negative or beyond midnight
+    std::atomic<unsigned int> mEpochCount;
+    std::atomic<unsigned int> mLengthErrorCount;
+    std::atomic<uint8_t> mNumChannels;
+    std::atomic<uint8_t> mFixType;
+    std::atomic<uint8_t> mNumSatsUsed;
+};
+
+#endif
@@ -0,0 +1,21 @@
+/**
+   GpsBench.cpp
+   Host-side micro-benchmarks: runs the sketch's benchmark suite (GPS_BENCHMARK_MODE) natively on Linux, with the
+   framebuffer stand-in for the display. Durations are nanoseconds instead of CPU cycles.
+   for details: see README.md
+*/
+
+#include "HostHal.h"
+#include "../ObsGpsTest.ino"
+
+int main(int argc, char** argv)
+{
+  // the benchmarks run once everything has been initialized, at the end of the startup phase (there is no GPS input,
+  // so it simply waits out its virtual two seconds)
+  setup();
+  while (testPhase == PHASE_STARTUP)
+  {
+    loop();
+  }
+  return benchmarkChecksOk ? 0 : 1; // the kernel check failed (see runBenchmarks())
+}
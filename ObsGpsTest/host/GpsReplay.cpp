@@ -0,0 +1,180 @@
+/**
+   GpsReplay.cpp
+   Host-side capture replay: runs the unmodified ObsGpsTest sketch natively on Linux and feeds a recorded NMEA/UBX
+   capture into the GPS serial port (a second one into the second module's port when built for several modules, see
+   GPS_NUM_MODULES). The capture arrives at the selected baudrate on a virtual clock, so the sketch
+   sees the same byte timing as on the device, but the replay runs as fast as the host can process it.
+   for details: see README.md
+*/
+
+#include "HostHal.h"
+#include "../ObsGpsTest.ino"
+#include "SketchReport.h"
+
+#include <chrono>
+
+static void printUsage(const char* pName)
+{
+  fprintf(stderr,
+          "usage: %s [options] <capture file>\n"
+          "  --fast           capture at the fast baudrate, button pressed during power-up (the first rate tried)\n"
+          "  --baud <rate>    baudrate the capture arrives at (default: 9600, 115200 with --fast)\n"
+          "  --frame-us <us>  simulated transfer time of a full display frame (default: 0)\n"
+          "  --press <ms>[:<hold ms>]  press the button at the given (virtual) time, for 100 ms by default; repeatable\n"
+          "  --pbm <file>     write the last display frame as portable bitmap\n"
+#if GPS_NUM_MODULES > 1
+          "  --module2 <file> capture for the second module (at the same baudrate)\n"
+#endif
+          "  -q               do not print the sketch's debug output\n",
+          pName);
+}
+
+typedef struct
+{
+  uint32_t atMs;
+  uint32_t holdMs;
+  bool pressed;
+  bool released;
+} button_press_t;
+
+static const int MaxPresses = 16;
+static button_press_t presses[MaxPresses];
+static int numPresses = 0;
+
+static void simulatePresses()
+{
+  // the button pin follows the --press times (without bouncing, the debouncing has nothing to do)
+  for (int i = 0; i < numPresses; i++)
+  {
+    button_press_t& press = presses[i];
+    if (!press.pressed && millis() >= press.atMs)
+    {
+      press.pressed = true;
+      hostSetPinLevel(ButtonPin, HIGH);
+    }
+    if (press.pressed && !press.released && millis() >= press.atMs + press.holdMs)
+    {
+      press.released = true;
+      hostSetPinLevel(ButtonPin, LOW);
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  const char* pCapturePath = nullptr;
+  const char* pCapture2Path = nullptr;
+  const char* pPbmPath = nullptr;
+  bool quiet = false;
+  unsigned long lineBaud = 0;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--fast"))
+    {
+      hostSetPinLevel(ButtonPin, HIGH);
+      lineBaud = (lineBaud == 0) ? GpsSerialBaudFast : lineBaud;
+    }
+    else if (!strcmp(argv[i], "--baud") && i + 1 < argc)
+    {
+      lineBaud = strtoul(argv[++i], nullptr, 10);
+    }
+    else if (!strcmp(argv[i], "--frame-us") && i + 1 < argc)
+    {
+      u8g2.setFrameTransferMicros(strtoul(argv[++i], nullptr, 10));
+    }
+    else if (!strcmp(argv[i], "--press") && i + 1 < argc && numPresses < MaxPresses)
+    {
+      char* pEnd;
+      button_press_t& press = presses[numPresses++];
+      press.atMs = strtoul(argv[++i], &pEnd, 10);
+      press.holdMs = (*pEnd == ':') ? strtoul(pEnd + 1, nullptr, 10) : 100;
+      press.pressed = false;
+      press.released = false;
+    }
+    else if (!strcmp(argv[i], "--pbm") && i + 1 < argc)
+    {
+      pPbmPath = argv[++i];
+    }
+#if GPS_NUM_MODULES > 1
+    else if (!strcmp(argv[i], "--module2") && i + 1 < argc)
+    {
+      pCapture2Path = argv[++i];
+    }
+#endif
+    else if (!strcmp(argv[i], "-q"))
+    {
+      quiet = true;
+    }
+    else if (argv[i][0] != '-' && pCapturePath == nullptr)
+    {
+      pCapturePath = argv[i];
+    }
+    else
+    {
+      printUsage(argv[0]);
+      return 2;
+    }
+  }
+  if (pCapturePath == nullptr)
+  {
+    printUsage(argv[0]);
+    return 2;
+  }
+
+  if (!hostLoadCapture(Serial2, pCapturePath) || Serial2.getInputLen() == 0)
+  {
+    fprintf(stderr, "Unable to load capture '%s'.\n", pCapturePath);
+    return 1;
+  }
+  if (pCapture2Path != nullptr && !hostLoadCapture(Serial1, pCapture2Path))
+  {
+    fprintf(stderr, "Unable to load capture '%s'.\n", pCapture2Path);
+    return 1;
+  }
+  Serial.setOutput(quiet ? nullptr : stdout);
+  Serial2.setLineBaud((lineBaud != 0) ? lineBaud : GpsSerialBaudSlow);
+  Serial1.setLineBaud((lineBaud != 0) ? lineBaud : GpsSerialBaudSlow);
+
+  std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now();
+  try
+  {
+    setup();
+    while (!Serial2.inputExhausted())
+    {
+      simulatePresses();
+      loop();
+    }
+  }
+  catch (const HostReplayEnd&)
+  {
+    // the sketch waited for more data after the capture had been consumed
+  }
+  hostJoinTasks();
+  double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  double virtualSec = hostMicros() / 1e6;
+
+  size_t numBytes = Serial2.getInputLen();
+  unsigned int numCycles = modules[0].gsvCycleCount;
+  printf("\n");
+  printf("Replayed %zu bytes at %lu baud: %.1f s of GPS time in %.3f s (x%.0f)\n", numBytes, Serial2.getLineBaud(),
+         virtualSec, wallSec, (wallSec > 0) ? virtualSec / wallSec : 0.0);
+  printf("Throughput: %.0f bytes/s, %.1f GSV cycles/s (%u cycles)\n", (wallSec > 0) ? numBytes / wallSec : 0.0,
+         (wallSec > 0) ? numCycles / wallSec : 0.0, numCycles);
+  printf("Display: %u frames, %zu bytes sent in %u transfers (%lu bytes/frame of %zu)\n", displayDiff.getFrameCount(),
+         u8g2.getBytesSent(), u8g2.getTransferCount(),
+         displayDiff.getFrameCount() ? displayDiff.getBytesSent() / displayDiff.getFrameCount() : 0UL,
+         displayDiff.getFrameSize());
+  printModuleStats(modules[0], Serial2);
+#if GPS_NUM_MODULES > 1
+  printf("\nSecond module:\n");
+  printModuleStats(modules[1], Serial1);
+#endif
+
+  if (pPbmPath != nullptr && !u8g2.writePbm(pPbmPath))
+  {
+    fprintf(stderr, "Unable to write '%s'.\n", pPbmPath);
+    return 1;
+  }
+  return 0;
+}
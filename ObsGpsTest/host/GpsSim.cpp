@@ -0,0 +1,967 @@
+/**
+   GpsSim.cpp
+   Simulated GPS module for the host tools, see GpsSim.h
+*/
+
+#include "GpsSim.h"
+
+namespace
+{
+  const uint8_t UBX_SYNC_1 = 0xB5;
+  const uint8_t UBX_SYNC_2 = 0x62;
+  const uint8_t UBX_CLASS_NAV = 0x01;
+  const uint8_t UBX_CLASS_ACK = 0x05;
+  const uint8_t UBX_CLASS_CFG = 0x06;
+  const uint8_t UBX_ID_ACK_NAK = 0x00;
+  const uint8_t UBX_ID_ACK_ACK = 0x01;
+  const uint8_t UBX_ID_CFG_PRT = 0x00;
+  const uint8_t UBX_ID_CFG_MSG = 0x01;
+  const uint8_t UBX_ID_CFG_INF = 0x02;
+  const uint8_t UBX_ID_CFG_DAT = 0x06;
+  const uint8_t UBX_ID_CFG_TP = 0x07;
+  const uint8_t UBX_ID_CFG_RATE = 0x08;
+  const uint8_t UBX_ID_CFG_FXN = 0x0E;
+  const uint8_t UBX_ID_CFG_RXM = 0x11;
+  const uint8_t UBX_ID_CFG_RST = 0x04;
+  const uint8_t UBX_ID_NAV_STATUS = 0x03;
+  const uint8_t UBX_ID_NAV_SOL = 0x06;
+  const uint8_t UBX_ID_NAV_TIMEUTC = 0x21;
+  const uint8_t UBX_ID_NAV_SVINFO = 0x30;
+  const uint8_t NMEA_STD_CLASS = 0xF0; // CFG-MSG class of the standard NMEA sentences, IDs 0..5: GGA GLL GSA GSV RMC VTG
+  const uint8_t UART_PORT_ID = 1;
+  const uint16_t CFG_PRT_LEN = 20;
+  const uint16_t MIN_MEAS_RATE_MS = 50;
+
+  enum NmeaMsg { NMEA_GGA, NMEA_GLL, NMEA_GSA, NMEA_GSV, NMEA_RMC, NMEA_VTG };
+  const uint8_t NAV_IDS[] = {UBX_ID_NAV_STATUS, UBX_ID_NAV_SOL, UBX_ID_NAV_TIMEUTC, UBX_ID_NAV_SVINFO};
+
+  // the NAV messages that are only answered to polls: (ID, payload length), the payload is all zeros but the time of week
+  const uint8_t NAV_POLL_ONLY[][2] = {
+    {0x01, 20}, {0x02, 28}, {0x04, 18}, {0x11, 20}, {0x12, 36}, {0x20, 16}, {0x22, 20}, {0x31, 16}, {0x32, 12},
+    {0x60, 20}
+  };
+
+  const char* const TALKER_IDS[GpsSim::TALKER_NUM] = {"GP", "GL", "GA", "GB"};
+  // NMEA satellite IDs per talker: first ID, number of satellites
+  const uint8_t TALKER_ID_RANGES[GpsSim::TALKER_NUM][2] = {{1, 32}, {65, 24}, {1, 36}, {1, 37}};
+
+  // the receiver's position and the simulated date: Saturday, 2024-06-01 (GPS week 2317), from 12:00:00 UTC on
+  const char* const LATITUDE = "5230.86421";
+  const char* const LONGITUDE = "01324.15873";
+  const uint16_t GPS_WEEK = 2317;
+  const uint8_t START_DAY_OF_WEEK = 6;
+  const uint32_t START_TIME_OF_DAY_MS = 12UL * 3600000UL;
+  const uint32_t LEAP_SECONDS_MS = 18000;
+  const uint32_t MS_PER_DAY = 86400000UL;
+  const uint32_t MS_PER_WEEK = 604800000UL;
+
+  void writeU2(uint8_t* p, uint16_t value)
+  {
+    p[0] = value & 0xFF;
+    p[1] = value >> 8;
+  }
+
+  void writeU4(uint8_t* p, uint32_t value)
+  {
+    for (int i = 0; i < 4; i++)
+    {
+      p[i] = (value >> (8 * i)) & 0xFF;
+    }
+  }
+
+  bool isPoll(uint8_t msgClass, uint8_t msgId, uint16_t len)
+  {
+    // polls w/ a payload: CFG-MSG (class and ID), CFG-INF (protocol ID), CFG-PRT (port ID, optional)
+    if (msgClass == UBX_CLASS_CFG && msgId == UBX_ID_CFG_MSG)
+    {
+      return len == 2;
+    }
+    if (msgClass == UBX_CLASS_CFG && msgId == UBX_ID_CFG_INF)
+    {
+      return len == 1;
+    }
+    if (msgClass == UBX_CLASS_CFG && msgId == UBX_ID_CFG_PRT)
+    {
+      return len <= 1;
+    }
+    return len == 0;
+  }
+}
+
+const GpsSim::sim_config_t GpsSim::DEFAULT_CONFIG = {
+  /*model=*/MODEL_UBLOX,
+  /*baud=*/9600,
+  /*measRateMs=*/1000,
+  /*numSats=*/{10, 6, 0, 0},
+  /*nmeaOn=*/true,
+  /*ubxNavOn=*/false,
+  /*powerUpStart=*/START_HOT,
+  /*ttffMs=*/{27000, 22000, 1000}, // NEO-6M data sheet: 27 s cold, 1 s hot
+  /*bootMs=*/300,
+  /*answerMs=*/20,
+  /*corruptPpm=*/0,
+  /*burstEveryMs=*/0,
+  /*burstEpochs=*/3,
+  /*gapEveryMs=*/0,
+  /*gapMs=*/0,
+  /*seed=*/1
+};
+
+GpsSim::GpsSim(const sim_config_t& config) :
+    mConfig(config),
+    mBaud(config.baud),
+    mMeasRateMs(config.measRateMs),
+    mNumSats(0),
+    mStartType(config.powerUpStart),
+    mStartUs(0),
+    mNextEpochUs((uint64_t)config.bootMs * 1000),
+    mEpochNumber(0),
+    mNextBurstUs((uint64_t)config.burstEveryMs * 1000),
+    mNextGapUs((uint64_t)config.gapEveryMs * 1000),
+    mGapEndUs(0),
+    mRandomState((config.seed != 0) ? config.seed : 1),
+    mLineFreeNs(0),
+    mRxState(RX_SYNC_1),
+    mRxPos(0),
+    mRxCkA(0),
+    mRxCkB(0)
+{
+  memset(&mStats, 0, sizeof(mStats));
+  memset(&mRx, 0, sizeof(mRx));
+  for (int i = 0; i < NUM_NMEA_MSGS; i++)
+  {
+    mNmeaRates[i] = (config.nmeaOn && config.model != MODEL_TECHTOTOP) ? 1 : 0;
+  }
+  if (config.model == MODEL_TECHTOTOP && config.nmeaOn)
+  {
+    // the usual set of a Techtotop module: no GLL, VTG
+    mNmeaRates[NMEA_GGA] = 1;
+    mNmeaRates[NMEA_GSA] = 1;
+    mNmeaRates[NMEA_GSV] = 1;
+    mNmeaRates[NMEA_RMC] = 1;
+  }
+  for (int i = 0; i < NUM_NAV_MSGS; i++)
+  {
+    mNavRates[i] = (config.ubxNavOn && config.model == MODEL_UBLOX && NAV_IDS[i] != UBX_ID_NAV_STATUS) ? 1 : 0;
+  }
+
+  // the sky: distinct satellites per constellation at random positions, acquired one after the other
+  for (int t = 0; t < TALKER_NUM; t++)
+  {
+    uint8_t firstId = TALKER_ID_RANGES[t][0];
+    uint8_t numIds = TALKER_ID_RANGES[t][1];
+    bool used[64] = {false};
+    for (int i = 0; i < config.numSats[t] && i < numIds && mNumSats < MAX_SATS; i++)
+    {
+      uint8_t index;
+      do
+      {
+        index = random(numIds);
+      } while (used[index]);
+      used[index] = true;
+
+      sim_sat_t& sat = mSats[mNumSats++];
+      sat.talker = t;
+      sat.nmeaId = firstId + index;
+      switch (t)
+      {
+        case TALKER_GP:
+        case TALKER_GL:
+          sat.svId = sat.nmeaId;
+          break;
+        case TALKER_GA:
+          sat.svId = 210 + sat.nmeaId;
+          break;
+        default:
+          sat.svId = (sat.nmeaId <= 5) ? 158 + sat.nmeaId : 27 + sat.nmeaId;
+          break;
+      }
+      sat.elevation = 5 + random(81);
+      sat.azimuth = random(360);
+      sat.cno = 20 + random(29);
+      sat.acquirePermille = 100 + random(800);
+    }
+  }
+}
+
+bool GpsSim::parseSats(const char* pSpec, uint8_t* pNumSats)
+{
+  for (int t = 0; t < TALKER_NUM; t++)
+  {
+    pNumSats[t] = 0;
+  }
+  unsigned int total = 0;
+  const char* p = pSpec;
+  while (*p != '\0')
+  {
+    int talker = -1;
+    for (int t = 0; t < TALKER_NUM; t++)
+    {
+      if (!strncmp(p, TALKER_IDS[t], 2) || (t == TALKER_GB && !strncmp(p, "BD", 2)))
+      {
+        talker = t;
+      }
+    }
+    if (talker < 0 || p[2] != ':')
+    {
+      return false;
+    }
+    char* pEnd;
+    unsigned long num = strtoul(p + 3, &pEnd, 10);
+    if (pEnd == p + 3 || num > TALKER_ID_RANGES[talker][1] || (*pEnd != ',' && *pEnd != '\0'))
+    {
+      return false;
+    }
+    pNumSats[talker] = num;
+    total += num;
+    p = (*pEnd == ',') ? pEnd + 1 : pEnd;
+  }
+  return total <= MAX_SATS;
+}
+
+bool GpsSim::parseModel(const char* pName, Model* pModel)
+{
+  if (!strcmp(pName, "ublox"))
+  {
+    *pModel = MODEL_UBLOX;
+  }
+  else if (!strcmp(pName, "techtotop"))
+  {
+    *pModel = MODEL_TECHTOTOP;
+  }
+  else if (!strcmp(pName, "nmea"))
+  {
+    *pModel = MODEL_NMEA;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+bool GpsSim::receive(uint64_t nowUs, uint8_t* pByte, unsigned long* pBaud)
+{
+  advance(nowUs);
+  if (mLine.empty() || mLine.front().doneUs > nowUs)
+  {
+    return false;
+  }
+  *pByte = mLine.front().value;
+  *pBaud = mLine.front().baud;
+  mLine.pop_front();
+  return true;
+}
+
+uint64_t GpsSim::getNextByteUs()
+{
+  if (!mLine.empty())
+  {
+    return mLine.front().doneUs;
+  }
+  // whatever comes next starts when it is due (an epoch in a gap sends nothing, the caller asks again then)
+  return getNextEventUs() + (10 * 1000000UL + mBaud - 1) / mBaud;
+}
+
+uint64_t GpsSim::getNextEventUs()
+{
+  uint64_t nextUs = mNextEpochUs;
+  if (!mRequests.empty() && mRequests.front().dueUs < nextUs)
+  {
+    nextUs = mRequests.front().dueUs;
+  }
+  return nextUs;
+}
+
+void GpsSim::advance(uint64_t nowUs)
+{
+  // epochs and answers in the order they are due
+  for (;;)
+  {
+    bool request = !mRequests.empty() && mRequests.front().dueUs < mNextEpochUs;
+    uint64_t dueUs = request ? mRequests.front().dueUs : mNextEpochUs;
+    if (dueUs > nowUs)
+    {
+      break;
+    }
+    if (request)
+    {
+      request_t req = mRequests.front();
+      mRequests.pop_front();
+      handleRequest(req, dueUs);
+    }
+    else
+    {
+      sendEpoch(dueUs);
+      mNextEpochUs += (uint64_t)mMeasRateMs * 1000;
+      ++mEpochNumber;
+    }
+  }
+}
+
+void GpsSim::transmit(uint8_t b, unsigned long baud, uint64_t nowUs)
+{
+  ++mStats.bytesReceived;
+  if (baud != mBaud)
+  {
+    // framing errors at the module's UART
+    ++mStats.bytesGarbled;
+    mRxState = RX_SYNC_1;
+    return;
+  }
+
+  switch (mRxState)
+  {
+    case RX_SYNC_1:
+      mRxState = (b == UBX_SYNC_1) ? RX_SYNC_2 : RX_SYNC_1;
+      break;
+    case RX_SYNC_2:
+      mRxState = (b == UBX_SYNC_2) ? RX_HEADER : ((b == UBX_SYNC_1) ? RX_SYNC_2 : RX_SYNC_1);
+      mRxPos = 0;
+      mRxCkA = 0;
+      mRxCkB = 0;
+      break;
+    case RX_HEADER:
+      mRxHeader[mRxPos++] = b;
+      mRxCkA += b;
+      mRxCkB += mRxCkA;
+      if (mRxPos == sizeof(mRxHeader))
+      {
+        mRx.msgClass = mRxHeader[0];
+        mRx.msgId = mRxHeader[1];
+        mRx.len = mRxHeader[2] | (mRxHeader[3] << 8);
+        mRxPos = 0;
+        mRxState = (mRx.len > RX_MAX_PAYLOAD_LEN) ? RX_SYNC_1 : ((mRx.len > 0) ? RX_PAYLOAD : RX_CHECKSUM);
+      }
+      break;
+    case RX_PAYLOAD:
+      mRx.payload[mRxPos++] = b;
+      mRxCkA += b;
+      mRxCkB += mRxCkA;
+      if (mRxPos == mRx.len)
+      {
+        mRxPos = 0;
+        mRxState = RX_CHECKSUM;
+      }
+      break;
+    case RX_CHECKSUM:
+      if (mRxPos == 0)
+      {
+        mRxPos = (b == mRxCkA) ? 1 : 2;
+        break;
+      }
+      mRxState = RX_SYNC_1;
+      if (mRxPos == 1 && b == mRxCkB)
+      {
+        ++mStats.requests;
+        mRx.dueUs = nowUs + (uint64_t)mConfig.answerMs * 1000;
+        mRequests.push_back(mRx);
+      }
+      else
+      {
+        ++mStats.checksumErrors;
+      }
+      break;
+  }
+}
+
+void GpsSim::handleRequest(const request_t& req, uint64_t atUs)
+{
+  uint8_t payload[512];
+  uint16_t len = 0;
+  bool poll = isPoll(req.msgClass, req.msgId, req.len);
+
+  if (mConfig.model == MODEL_NMEA ||
+      (mConfig.model == MODEL_TECHTOTOP && !(poll && req.msgClass == UBX_CLASS_CFG && req.msgId == UBX_ID_CFG_PRT)))
+  {
+    ++mStats.ignored;
+    return;
+  }
+  if (poll)
+  {
+    if (buildPayload(req.msgClass, req.msgId, req.payload, req.len, atUs, payload, &len))
+    {
+      sendUbx(req.msgClass, req.msgId, payload, len, atUs);
+      ++mStats.answers;
+      if (req.msgClass == UBX_CLASS_CFG && mConfig.model == MODEL_UBLOX)
+      {
+        sendAck(true, req.msgClass, req.msgId, atUs);
+      }
+    }
+    else if (req.msgClass == UBX_CLASS_CFG)
+    {
+      sendAck(false, req.msgClass, req.msgId, atUs);
+    }
+    else
+    {
+      ++mStats.ignored; // unknown NAV messages etc. are not answered at all
+    }
+  }
+  else if (req.msgClass == UBX_CLASS_CFG)
+  {
+    applySetting(req, atUs);
+  }
+  else
+  {
+    ++mStats.ignored;
+  }
+}
+
+bool GpsSim::buildPayload(uint8_t msgClass, uint8_t msgId, const uint8_t* pPoll, uint16_t pollLen, uint64_t atUs,
+                          uint8_t* pPayload, uint16_t* pLen)
+{
+  if (msgClass == UBX_CLASS_NAV)
+  {
+    *pLen = buildNav(msgId, atUs, pPayload);
+    return *pLen > 0;
+  }
+  if (msgClass != UBX_CLASS_CFG)
+  {
+    return false;
+  }
+
+  memset(pPayload, 0, 64);
+  switch (msgId)
+  {
+    case UBX_ID_CFG_PRT:
+    {
+      uint8_t portId = (pollLen > 0) ? pPoll[0] : UART_PORT_ID;
+      pPayload[0] = portId;
+      if (portId == UART_PORT_ID)
+      {
+        writeU4(&pPayload[4], 0x000008D0); // 8N1
+        writeU4(&pPayload[8], mBaud);
+        writeU2(&pPayload[12], 0x0007); // in: UBX, NMEA, RTCM
+        writeU2(&pPayload[14], 0x0003); // out: UBX, NMEA
+      }
+      *pLen = CFG_PRT_LEN;
+      return true;
+    }
+    case UBX_ID_CFG_MSG:
+      // rates on the six I/O ports, the UART is the second one
+      pPayload[0] = pPoll[0];
+      pPayload[1] = pPoll[1];
+      if (pPoll[0] == NMEA_STD_CLASS && pPoll[1] < NUM_NMEA_MSGS)
+      {
+        pPayload[2 + UART_PORT_ID] = mNmeaRates[pPoll[1]];
+      }
+      for (int i = 0; i < NUM_NAV_MSGS; i++)
+      {
+        if (pPoll[0] == UBX_CLASS_NAV && pPoll[1] == NAV_IDS[i])
+        {
+          pPayload[2 + UART_PORT_ID] = mNavRates[i];
+        }
+      }
+      *pLen = 8;
+      return true;
+    case UBX_ID_CFG_INF:
+      pPayload[0] = pPoll[0];
+      pPayload[4 + UART_PORT_ID] = 0x07; // errors, warnings, notices
+      *pLen = 10;
+      return true;
+    case UBX_ID_CFG_DAT:
+      *pLen = 52;
+      return true;
+    case UBX_ID_CFG_TP:
+      writeU4(&pPayload[0], 1000000); // 1 Hz
+      writeU4(&pPayload[4], 100000);
+      pPayload[8] = 1;
+      *pLen = 20;
+      return true;
+    case UBX_ID_CFG_RATE:
+      writeU2(&pPayload[0], mMeasRateMs);
+      writeU2(&pPayload[2], 1);
+      writeU2(&pPayload[4], 1); // GPS time
+      *pLen = 6;
+      return true;
+    case UBX_ID_CFG_FXN:
+      *pLen = 36;
+      return true;
+    case UBX_ID_CFG_RXM:
+      pPayload[0] = 8;
+      *pLen = 2;
+      return true;
+    default:
+      return false; // e.g. CFG-EKF (dead reckoning modules only)
+  }
+}
+
+uint16_t GpsSim::buildNav(uint8_t msgId, uint64_t atUs, uint8_t* pPayload)
+{
+  uint32_t iTow = getTimeOfWeekMs(atUs);
+  uint8_t fixType = getFixType(atUs);
+  bool timeValid = isTimeValid(atUs);
+  uint8_t flags = ((fixType > 0) ? 0x01 : 0) | (timeValid ? 0x0C : 0); // gpsFixOk, week number and time of week set
+  uint8_t numUsed = 0;
+  for (int i = 0; i < mNumSats; i++)
+  {
+    numUsed += (fixType > 0 && getCno(mSats[i], atUs) > 0) ? 1 : 0;
+  }
+
+  switch (msgId)
+  {
+    case UBX_ID_NAV_STATUS:
+      memset(pPayload, 0, 16);
+      writeU4(&pPayload[0], iTow);
+      pPayload[4] = fixType;
+      pPayload[5] = flags;
+      writeU4(&pPayload[8], (fixType > 0) ? mConfig.ttffMs[mStartType] : 0);
+      writeU4(&pPayload[12], getSinceStartMs(atUs));
+      return 16;
+
+    case UBX_ID_NAV_SOL:
+      memset(pPayload, 0, 52);
+      writeU4(&pPayload[0], iTow);
+      writeU2(&pPayload[8], GPS_WEEK);
+      pPayload[10] = fixType;
+      pPayload[11] = flags;
+      writeU2(&pPayload[44], (fixType > 0) ? 150 : 9999); // pDOP * 100
+      pPayload[47] = numUsed;
+      return 52;
+
+    case UBX_ID_NAV_TIMEUTC:
+    {
+      uint8_t hour, minute, second;
+      uint16_t ms;
+      getUtc(atUs, &hour, &minute, &second, &ms);
+      memset(pPayload, 0, 20);
+      writeU4(&pPayload[0], iTow);
+      writeU4(&pPayload[4], timeValid ? 20 : 0xFFFFFFFF); // tAcc
+      writeU4(&pPayload[8], (uint32_t)ms * 1000000UL);
+      writeU2(&pPayload[12], 2024);
+      pPayload[14] = 6;
+      pPayload[15] = 1 + (START_TIME_OF_DAY_MS + atUs / 1000) / MS_PER_DAY;
+      pPayload[16] = hour;
+      pPayload[17] = minute;
+      pPayload[18] = second;
+      pPayload[19] = timeValid ? 0x07 : 0x00;
+      return 20;
+    }
+
+    case UBX_ID_NAV_SVINFO:
+      writeU4(&pPayload[0], iTow);
+      pPayload[4] = mNumSats;
+      pPayload[5] = 2; // u-blox 6
+      pPayload[6] = 0;
+      pPayload[7] = 0;
+      for (int i = 0; i < mNumSats; i++)
+      {
+        const sim_sat_t& sat = mSats[i];
+        uint8_t* pBlock = &pPayload[8 + i * 12];
+        uint8_t cno = getCno(sat, atUs);
+        memset(pBlock, 0, 12);
+        pBlock[0] = i;
+        pBlock[1] = sat.svId;
+        pBlock[2] = (fixType > 0 && cno > 0) ? 0x01 : 0; // svUsed
+        pBlock[3] = (cno > 0) ? 7 : 1; // code and carrier locked, or searching
+        pBlock[4] = cno;
+        pBlock[5] = sat.elevation;
+        writeU2(&pBlock[6], sat.azimuth);
+      }
+      return 8 + mNumSats * 12;
+
+    default:
+      for (size_t i = 0; i < sizeof(NAV_POLL_ONLY) / sizeof(NAV_POLL_ONLY[0]); i++)
+      {
+        if (NAV_POLL_ONLY[i][0] == msgId)
+        {
+          memset(pPayload, 0, NAV_POLL_ONLY[i][1]);
+          writeU4(&pPayload[0], iTow);
+          return NAV_POLL_ONLY[i][1];
+        }
+      }
+      return 0; // e.g. NAV-EKFSTATUS (dead reckoning modules only)
+  }
+}
+
+void GpsSim::applySetting(const request_t& req, uint64_t atUs)
+{
+  const uint8_t* p = req.payload;
+  switch (req.msgId)
+  {
+    case UBX_ID_CFG_PRT:
+      if (req.len < CFG_PRT_LEN)
+      {
+        sendAck(false, req.msgClass, req.msgId, atUs);
+        return;
+      }
+      // acknowledged at the old rate, everything after that goes out at the new one
+      sendAck(true, req.msgClass, req.msgId, atUs);
+      if (p[0] == UART_PORT_ID)
+      {
+        unsigned long baud = p[8] | (p[9] << 8) | ((unsigned long)p[10] << 16) | ((unsigned long)p[11] << 24);
+        if (baud >= 4800 && baud <= 921600 && baud != mBaud)
+        {
+          mBaud = baud;
+          ++mStats.baudChanges;
+        }
+      }
+      return;
+
+    case UBX_ID_CFG_MSG:
+    {
+      if (req.len != 3 && req.len != 8)
+      {
+        sendAck(false, req.msgClass, req.msgId, atUs);
+        return;
+      }
+      // w/ 3 bytes: the rate on the port the request came in on, w/ 8 bytes: on each port
+      uint8_t rate = (req.len == 3) ? p[2] : p[2 + UART_PORT_ID];
+      if (p[0] == NMEA_STD_CLASS && p[1] < NUM_NMEA_MSGS)
+      {
+        mNmeaRates[p[1]] = rate;
+      }
+      for (int i = 0; i < NUM_NAV_MSGS; i++)
+      {
+        if (p[0] == UBX_CLASS_NAV && p[1] == NAV_IDS[i])
+        {
+          mNavRates[i] = rate;
+        }
+      }
+      sendAck(true, req.msgClass, req.msgId, atUs);
+      return;
+    }
+
+    case UBX_ID_CFG_RATE:
+    {
+      uint16_t measRateMs = (req.len == 6) ? (p[0] | (p[1] << 8)) : 0;
+      if (measRateMs < MIN_MEAS_RATE_MS)
+      {
+        sendAck(false, req.msgClass, req.msgId, atUs);
+        return;
+      }
+      mMeasRateMs = measRateMs;
+      sendAck(true, req.msgClass, req.msgId, atUs);
+      return;
+    }
+
+    case UBX_ID_CFG_RST:
+      // never acknowledged; the hardware resets (resetMode 0, 4) are taken as GNSS restarts as well
+      if (req.len == 4)
+      {
+        uint16_t bbrMask = p[0] | (p[1] << 8);
+        restart((bbrMask == 0xFFFF) ? START_COLD : ((bbrMask == 0) ? START_HOT : START_WARM), atUs);
+      }
+      return;
+
+    default:
+      sendAck(true, req.msgClass, req.msgId, atUs);
+      return;
+  }
+}
+
+void GpsSim::restart(StartType type, uint64_t atUs)
+{
+  mStartType = type;
+  mStartUs = atUs;
+  ++mStats.resets;
+}
+
+void GpsSim::sendEpoch(uint64_t atUs)
+{
+  while (mConfig.gapEveryMs > 0 && atUs >= mNextGapUs)
+  {
+    mGapEndUs = mNextGapUs + (uint64_t)mConfig.gapMs * 1000;
+    mNextGapUs += (uint64_t)mConfig.gapEveryMs * 1000;
+    ++mStats.gaps;
+  }
+  if (atUs < mGapEndUs)
+  {
+    return;
+  }
+  int copies = 1;
+  while (mConfig.burstEveryMs > 0 && atUs >= mNextBurstUs)
+  {
+    copies = 1 + mConfig.burstEpochs;
+    mNextBurstUs += (uint64_t)mConfig.burstEveryMs * 1000;
+    ++mStats.bursts;
+  }
+
+  if (mEpochNumber == 0 && mConfig.model == MODEL_UBLOX && mNmeaRates[NMEA_RMC] > 0)
+  {
+    // the power-up banner
+    sendSentence("GPTXT,01,01,02,u-blox ag - www.u-blox.com", atUs);
+    sendSentence("GPTXT,01,01,02,HW  UBX-G60xx  00040007 FF7FFFFFo", atUs);
+    sendSentence("GPTXT,01,01,02,ROM CORE 7.03 (45969) Mar 17 2011 16:18:34", atUs);
+  }
+  for (int i = 0; i < copies; i++)
+  {
+    sendNmea(atUs);
+    sendUbxNav(atUs);
+  }
+  ++mStats.epochs;
+}
+
+void GpsSim::sendNmea(uint64_t atUs)
+{
+  char body[96];
+  char time[16] = "";
+  char date[8] = "";
+  uint8_t hour, minute, second;
+  uint16_t ms;
+  getUtc(atUs, &hour, &minute, &second, &ms);
+  if (isTimeValid(atUs))
+  {
+    snprintf(time, sizeof(time), "%02u%02u%02u.%02u", hour, minute, second, ms / 10);
+    // June 2024, the day wraps around after the 30th
+    snprintf(date, sizeof(date), "%02u0624", (unsigned int)(1 + (START_TIME_OF_DAY_MS + atUs / 1000) / MS_PER_DAY % 30));
+  }
+  uint8_t fixType = getFixType(atUs);
+  const char* pTalker = getFixTalker();
+  uint8_t cnos[MAX_SATS];
+  uint8_t numUsed = 0;
+  for (int i = 0; i < mNumSats; i++)
+  {
+    cnos[i] = getCno(mSats[i], atUs);
+    numUsed += (fixType > 0 && cnos[i] > 0) ? 1 : 0;
+  }
+
+  // in the order of a u-blox module: RMC, VTG, GGA, GSA, GSV (each constellation), GLL
+  if (mNmeaRates[NMEA_RMC] > 0 && mEpochNumber % mNmeaRates[NMEA_RMC] == 0)
+  {
+    if (fixType > 0)
+    {
+      snprintf(body, sizeof(body), "%sRMC,%s,A,%s,N,%s,E,0.012,,%s,,,A", pTalker, time, LATITUDE, LONGITUDE, date);
+    }
+    else
+    {
+      snprintf(body, sizeof(body), "%sRMC,%s,V,,,,,,,%s,,,N", pTalker, time, date);
+    }
+    sendSentence(body, atUs);
+  }
+  if (mNmeaRates[NMEA_VTG] > 0 && mEpochNumber % mNmeaRates[NMEA_VTG] == 0)
+  {
+    snprintf(body, sizeof(body), (fixType > 0) ? "%sVTG,,T,,M,0.012,N,0.022,K,A" : "%sVTG,,,,,,,,,N", pTalker);
+    sendSentence(body, atUs);
+  }
+  if (mNmeaRates[NMEA_GGA] > 0 && mEpochNumber % mNmeaRates[NMEA_GGA] == 0)
+  {
+    if (fixType > 0)
+    {
+      snprintf(body, sizeof(body), "%sGGA,%s,%s,N,%s,E,1,%02u,1.05,35.0,M,44.7,M,,", pTalker, time, LATITUDE,
+               LONGITUDE, (numUsed < 12) ? numUsed : 12);
+    }
+    else
+    {
+      snprintf(body, sizeof(body), "%sGGA,%s,,,,,0,00,99.99,,,,,,", pTalker, time);
+    }
+    sendSentence(body, atUs);
+  }
+  if (mNmeaRates[NMEA_GSA] > 0 && mEpochNumber % mNmeaRates[NMEA_GSA] == 0)
+  {
+    int len = snprintf(body, sizeof(body), "%sGSA,A,%u", pTalker, (fixType > 0) ? fixType : 1);
+    int numIds = 0;
+    for (int i = 0; i < mNumSats && numIds < 12; i++)
+    {
+      if (fixType > 0 && cnos[i] > 0)
+      {
+        len += snprintf(body + len, sizeof(body) - len, ",%02u", mSats[i].nmeaId);
+        numIds++;
+      }
+    }
+    for (; numIds < 12; numIds++)
+    {
+      len += snprintf(body + len, sizeof(body) - len, ",");
+    }
+    snprintf(body + len, sizeof(body) - len, (fixType > 0) ? ",1.50,1.05,1.07" : ",99.99,99.99,99.99");
+    sendSentence(body, atUs);
+  }
+  if (mNmeaRates[NMEA_GSV] > 0 && mEpochNumber % mNmeaRates[NMEA_GSV] == 0)
+  {
+    for (int t = 0; t < TALKER_NUM; t++)
+    {
+      uint8_t inView = 0;
+      for (int i = 0; i < mNumSats; i++)
+      {
+        inView += (mSats[i].talker == t) ? 1 : 0;
+      }
+      uint8_t numMsgs = (inView + 3) / 4;
+      int i = 0;
+      for (uint8_t msg = 1; msg <= numMsgs; msg++)
+      {
+        int len = snprintf(body, sizeof(body), "%sGSV,%u,%u,%02u", TALKER_IDS[t], numMsgs, msg, inView);
+        for (int n = 0; n < 4 && i < mNumSats; i++)
+        {
+          if (mSats[i].talker != t)
+          {
+            continue;
+          }
+          len += snprintf(body + len, sizeof(body) - len, ",%02u,%02u,%03u,", mSats[i].nmeaId, mSats[i].elevation,
+                          mSats[i].azimuth);
+          if (cnos[i] > 0)
+          {
+            len += snprintf(body + len, sizeof(body) - len, "%02u", cnos[i]);
+          }
+          n++;
+        }
+        sendSentence(body, atUs);
+      }
+    }
+  }
+  if (mNmeaRates[NMEA_GLL] > 0 && mEpochNumber % mNmeaRates[NMEA_GLL] == 0)
+  {
+    if (fixType > 0)
+    {
+      snprintf(body, sizeof(body), "%sGLL,%s,N,%s,E,%s,A,A", pTalker, LATITUDE, LONGITUDE, time);
+    }
+    else
+    {
+      snprintf(body, sizeof(body), "%sGLL,,,,,%s,V,N", pTalker, time);
+    }
+    sendSentence(body, atUs);
+  }
+}
+
+void GpsSim::sendUbxNav(uint64_t atUs)
+{
+  uint8_t payload[8 + MAX_SATS * 12];
+  for (int i = 0; i < NUM_NAV_MSGS; i++)
+  {
+    if (mNavRates[i] > 0 && mEpochNumber % mNavRates[i] == 0)
+    {
+      uint16_t len = buildNav(NAV_IDS[i], atUs, payload);
+      sendUbx(UBX_CLASS_NAV, NAV_IDS[i], payload, len, atUs);
+    }
+  }
+}
+
+void GpsSim::sendAck(bool ack, uint8_t msgClass, uint8_t msgId, uint64_t atUs)
+{
+  const uint8_t payload[2] = {msgClass, msgId};
+  sendUbx(UBX_CLASS_ACK, ack ? UBX_ID_ACK_ACK : UBX_ID_ACK_NAK, payload, sizeof(payload), atUs);
+  ++(ack ? mStats.acks : mStats.naks);
+}
+
+void GpsSim::sendUbx(uint8_t msgClass, uint8_t msgId, const uint8_t* pPayload, uint16_t len, uint64_t atUs)
+{
+  uint8_t frame[8 + 8 + MAX_SATS * 12];
+  if (len > sizeof(frame) - 8)
+  {
+    return;
+  }
+  frame[0] = UBX_SYNC_1;
+  frame[1] = UBX_SYNC_2;
+  frame[2] = msgClass;
+  frame[3] = msgId;
+  writeU2(&frame[4], len);
+  memcpy(&frame[6], pPayload, len);
+  uint8_t ckA = 0;
+  uint8_t ckB = 0;
+  for (uint16_t i = 2; i < 6 + len; i++)
+  {
+    ckA += frame[i];
+    ckB += ckA;
+  }
+  frame[6 + len] = ckA;
+  frame[7 + len] = ckB;
+  sendBytes(frame, 8 + len, atUs);
+  ++mStats.ubxFrames;
+}
+
+void GpsSim::sendSentence(const char* pBody, uint64_t atUs)
+{
+  char sentence[112];
+  uint8_t checksum = 0;
+  for (const char* p = pBody; *p != '\0'; p++)
+  {
+    checksum ^= *p;
+  }
+  int len = snprintf(sentence, sizeof(sentence), "$%s*%02X\r\n", pBody, checksum);
+  sendBytes((const uint8_t*)sentence, (len < (int)sizeof(sentence)) ? len : sizeof(sentence) - 1, atUs);
+  ++mStats.nmeaSentences;
+}
+
+void GpsSim::sendBytes(const uint8_t* pData, size_t len, uint64_t atUs)
+{
+  // back to back from `atUs` on, or after what is still on the line (10 bits per byte)
+  uint64_t byteNs = 10 * 1000000000ULL / mBaud;
+  if (mLineFreeNs < atUs * 1000)
+  {
+    mLineFreeNs = atUs * 1000;
+  }
+  for (size_t i = 0; i < len; i++)
+  {
+    line_byte_t lineByte;
+    lineByte.value = pData[i];
+    if (mConfig.corruptPpm > 0 && random(1000000) < mConfig.corruptPpm)
+    {
+      lineByte.value ^= 1 << random(8);
+      ++mStats.corrupted;
+    }
+    mLineFreeNs += byteNs;
+    lineByte.doneUs = (mLineFreeNs + 999) / 1000;
+    lineByte.baud = mBaud;
+    mLine.push_back(lineByte);
+  }
+  mStats.bytesSent += len;
+}
+
+uint8_t GpsSim::getFixType(uint64_t atUs)
+{
+  // 2D for the first second after the fix
+  uint32_t sinceStartMs = getSinceStartMs(atUs);
+  uint32_t ttffMs = mConfig.ttffMs[mStartType];
+  return (sinceStartMs < ttffMs) ? 0 : ((sinceStartMs < ttffMs + 1000) ? 2 : 3);
+}
+
+bool GpsSim::isTimeValid(uint64_t atUs)
+{
+  return getSinceStartMs(atUs) >= mConfig.ttffMs[mStartType] / 2;
+}
+
+uint8_t GpsSim::getCno(const sim_sat_t& sat, uint64_t atUs)
+{
+  if (getSinceStartMs(atUs) < (uint64_t)mConfig.ttffMs[mStartType] * sat.acquirePermille / 1000)
+  {
+    return 0;
+  }
+  return sat.cno - 2 + random(5);
+}
+
+uint32_t GpsSim::getTimeOfWeekMs(uint64_t atUs)
+{
+  return (uint32_t)((START_DAY_OF_WEEK * (uint64_t)MS_PER_DAY + START_TIME_OF_DAY_MS + LEAP_SECONDS_MS + atUs / 1000) %
+                    MS_PER_WEEK);
+}
+
+void GpsSim::getUtc(uint64_t atUs, uint8_t* pHour, uint8_t* pMinute, uint8_t* pSecond, uint16_t* pMs)
+{
+  uint32_t timeOfDayMs = (uint32_t)((START_TIME_OF_DAY_MS + atUs / 1000) % MS_PER_DAY);
+  *pHour = timeOfDayMs / 3600000;
+  *pMinute = (timeOfDayMs / 60000) % 60;
+  *pSecond = (timeOfDayMs / 1000) % 60;
+  *pMs = timeOfDayMs % 1000;
+}
+
+const char* GpsSim::getFixTalker()
+{
+  // GP w/ GPS only, GN for a combined fix
+  for (int t = TALKER_GL; t < TALKER_NUM; t++)
+  {
+    if (mConfig.numSats[t] > 0)
+    {
+      return "GN";
+    }
+  }
+  return "GP";
+}
+
+uint32_t GpsSim::random(uint32_t range)
+{
+  // xorshift32
+  mRandomState ^= mRandomState << 13;
+  mRandomState ^= mRandomState >> 17;
+  mRandomState ^= mRandomState << 5;
+  return mRandomState % range;
+}
+
+void GpsSim::printStats(FILE* pOut)
+{
+  fprintf(pOut, "Simulated module: %lu baud, %u ms epochs; sent %lu bytes: %u epochs, %u NMEA sentences, %u UBX frames\n",
+          mBaud, mMeasRateMs, mStats.bytesSent, mStats.epochs, mStats.nmeaSentences, mStats.ubxFrames);
+  fprintf(pOut, "  faults: %u bytes corrupted, %u bursts, %u gaps\n", mStats.corrupted, mStats.bursts, mStats.gaps);
+  fprintf(pOut, "  received %lu bytes (%lu at another baudrate): %u UBX requests, %u checksum errors\n",
+          mStats.bytesReceived, mStats.bytesGarbled, mStats.requests, mStats.checksumErrors);
+  fprintf(pOut, "  answered %u polls, %u ACK, %u NAK, %u ignored; %u baudrate changes, %u restarts\n", mStats.answers,
+          mStats.acks, mStats.naks, mStats.ignored, mStats.baudChanges, mStats.resets);
+}
@@ -0,0 +1,197 @@
+#ifndef GpsSim_h
+#define GpsSim_h
+
+#include "HostHal.h"
+
+#include <deque>
+
+// Simulated GPS module on the other end of a serial line, for load and soak tests without hardware: each epoch, it
+// sends NMEA (RMC, GGA, GSA, GSV of every constellation w/ its own talker, GLL, VTG) and/or the UBX navigation messages
+// (NAV-SVINFO, -TIMEUTC, -SOL, -STATUS) at its baudrate, each message at the output rate set w/ CFG-MSG. It answers the
+// UBX requests like a u-blox NEO-6M: polls w/ the message (and ACK-ACK for the CFG class), settings w/ ACK-ACK, and
+// ACK-NAK for what it does not support; CFG-PRT moves it to another baudrate (after the ACK), CFG-RATE changes the
+// epoch rate and CFG-RST restarts the receiver (time to fix depending on the start type). Other models: a Techtotop
+// module (answers the CFG-PRT poll and nothing else) and a plain NMEA module (no UBX at all).
+// Faults are injected on top: corrupted bytes (a bit flipped), bursts (the output of several epochs back to back, as
+// a module flushing a backlog) and gaps (no output for a while). Everything follows the line's time, from a seed, so
+// a run is reproducible.
+
+class GpsSim : public HostSerialSource {
+  public:
+    enum Model {
+      MODEL_UBLOX,
+      MODEL_TECHTOTOP,
+      MODEL_NMEA
+    };
+
+    enum Talker {
+      TALKER_GP, // GPS
+      TALKER_GL, // GLONASS
+      TALKER_GA, // Galileo
+      TALKER_GB, // BeiDou
+      TALKER_NUM
+    };
+
+    enum StartType {
+      START_COLD,
+      START_WARM,
+      START_HOT,
+      START_NUM
+    };
+
+    static const uint8_t MAX_SATS = 40; // in view, all constellations (NAV-SVINFO w/ 40 channels is 488 bytes)
+
+    typedef struct
+    {
+      Model model;
+      unsigned long baud;
+      uint16_t measRateMs; // epoch period (CFG-RATE)
+      uint8_t numSats[TALKER_NUM]; // in view per constellation
+      bool nmeaOn; // the standard NMEA sentences every epoch (CFG-MSG may change that)
+      bool ubxNavOn; // NAV-SVINFO, NAV-TIMEUTC and NAV-SOL every epoch
+      StartType powerUpStart; // how the module starts at power-up (hot: backup battery w/ recent ephemerides)
+      uint32_t ttffMs[START_NUM]; // from the (re)start to the first fix; the time is valid after half of it
+      uint32_t bootMs; // from power-up to the first output
+      uint32_t answerMs; // from a request to its answer
+      uint32_t corruptPpm; // bytes corrupted (one bit flipped) per million
+      uint32_t burstEveryMs; // 0: no bursts
+      uint8_t burstEpochs; // epochs sent back to back per burst
+      uint32_t gapEveryMs; // 0: no gaps
+      uint32_t gapMs;
+      uint32_t seed;
+    } sim_config_t;
+
+    typedef struct
+    {
+      unsigned long bytesSent;
+      unsigned int epochs; // w/ output (the ones in a gap are left out)
+      unsigned int nmeaSentences;
+      unsigned int ubxFrames; // sent
+      unsigned int corrupted; // bytes
+      unsigned int bursts;
+      unsigned int gaps;
+      unsigned long bytesReceived;
+      unsigned long bytesGarbled; // received while the sender's UART was set to another baudrate
+      unsigned int requests; // UBX frames received w/ a valid checksum
+      unsigned int checksumErrors;
+      unsigned int answers; // polls answered w/ the message
+      unsigned int acks;
+      unsigned int naks;
+      unsigned int ignored; // requests the model does not answer at all
+      unsigned int baudChanges;
+      unsigned int resets;
+    } sim_stats_t;
+
+    static const sim_config_t DEFAULT_CONFIG; // NEO-6M w/ 10 GPS and 6 GLONASS satellites at 9600 baud, 1 Hz
+
+    explicit GpsSim(const sim_config_t& config);
+
+    // HostSerialSource
+    bool receive(uint64_t nowUs, uint8_t* pByte, unsigned long* pBaud) override;
+    uint64_t getNextByteUs() override;
+    void transmit(uint8_t b, unsigned long baud, uint64_t nowUs) override;
+
+    unsigned long getBaud() { return mBaud; } // the module's current rate
+    const sim_stats_t& getStats() { return mStats; }
+    void printStats(FILE* pOut);
+
+    // "GP:12,GL:8" etc. into `pNumSats` (the others 0); false when malformed
+    static bool parseSats(const char* pSpec, uint8_t* pNumSats);
+    static bool parseModel(const char* pName, Model* pModel);
+  private:
+    static const uint16_t RX_MAX_PAYLOAD_LEN = 64;
+    static const uint8_t NUM_NMEA_MSGS = 6; // GGA GLL GSA GSV RMC VTG, in the order of their CFG-MSG IDs
+    static const uint8_t NUM_NAV_MSGS = 4; // STATUS SOL TIMEUTC SVINFO, in the order u-blox modules send them
+
+    enum RxState {
+      RX_SYNC_1,
+      RX_SYNC_2,
+      RX_HEADER,
+      RX_PAYLOAD,
+      RX_CHECKSUM
+    };
+
+    typedef struct
+    {
+      uint8_t talker;
+      uint8_t nmeaId; // as in $--GSV of its talker
+      uint8_t svId; // UBX numbering
+      uint8_t elevation;
+      uint16_t azimuth;
+      uint8_t cno; // dBHz when tracked
+      uint16_t acquirePermille; // tracked from this fraction of the time to fix on
+    } sim_sat_t;
+
+    typedef struct
+    {
+      uint64_t doneUs; // last bit on the line
+      unsigned long baud;
+      uint8_t value;
+    } line_byte_t;
+
+    typedef struct
+    {
+      uint64_t dueUs;
+      uint8_t msgClass;
+      uint8_t msgId;
+      uint16_t len;
+      uint8_t payload[RX_MAX_PAYLOAD_LEN];
+    } request_t;
+
+    void advance(uint64_t nowUs);
+    uint64_t getNextEventUs();
+    void sendEpoch(uint64_t atUs);
+    void sendNmea(uint64_t atUs);
+    void sendUbxNav(uint64_t atUs);
+    void handleRequest(const request_t& req, uint64_t atUs);
+    bool buildPayload(uint8_t msgClass, uint8_t msgId, const uint8_t* pPoll, uint16_t pollLen, uint64_t atUs,
+                      uint8_t* pPayload, uint16_t* pLen);
+    uint16_t buildNav(uint8_t msgId, uint64_t atUs, uint8_t* pPayload); // 0: not supported
+    void applySetting(const request_t& req, uint64_t atUs);
+    void sendAck(bool ack, uint8_t msgClass, uint8_t msgId, uint64_t atUs);
+    void sendUbx(uint8_t msgClass, uint8_t msgId, const uint8_t* pPayload, uint16_t len, uint64_t atUs);
+    void sendSentence(const char* pBody, uint64_t atUs);
+    void sendBytes(const uint8_t* pData, size_t len, uint64_t atUs);
+    void restart(StartType type, uint64_t atUs);
+
+    // state of the simulated receiver at `atUs`
+    uint32_t getSinceStartMs(uint64_t atUs) { return (uint32_t)((atUs - mStartUs) / 1000); }
+    uint8_t getFixType(uint64_t atUs); // 0: none, 2: 2D, 3: 3D
+    bool isTimeValid(uint64_t atUs);
+    uint8_t getCno(const sim_sat_t& sat, uint64_t atUs); // 0: not tracked
+    uint32_t getTimeOfWeekMs(uint64_t atUs);
+    void getUtc(uint64_t atUs, uint8_t* pHour, uint8_t* pMinute, uint8_t* pSecond, uint16_t* pMs);
+    const char* getFixTalker();
+    uint32_t random(uint32_t range);
+
+    sim_config_t mConfig;
+    unsigned long mBaud;
+    uint16_t mMeasRateMs;
+    uint8_t mNmeaRates[NUM_NMEA_MSGS]; // per epoch, 0: off
+    uint8_t mNavRates[NUM_NAV_MSGS];
+    sim_sat_t mSats[MAX_SATS];
+    uint8_t mNumSats;
+    StartType mStartType;
+    uint64_t mStartUs; // of the receiver (power-up or CFG-RST)
+    uint64_t mNextEpochUs;
+    uint32_t mEpochNumber;
+    uint64_t mNextBurstUs;
+    uint64_t mNextGapUs;
+    uint64_t mGapEndUs;
+    uint32_t mRandomState;
+    uint64_t mLineFreeNs; // the last byte sent is through by then
+    std::deque<line_byte_t> mLine; // sent, not yet received by the other end
+    std::deque<request_t> mRequests; // received, not yet answered
+
+    // UBX frames from the other end
+    RxState mRxState;
+    uint8_t mRxHeader[4];
+    uint16_t mRxPos;
+    request_t mRx;
+    uint8_t mRxCkA;
+    uint8_t mRxCkB;
+
+    sim_stats_t mStats;
+};
+
+#endif
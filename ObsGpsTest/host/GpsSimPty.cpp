@@ -0,0 +1,175 @@
+/**
+   GpsSimPty.cpp
+   Host-side GPS module on a pseudo-terminal: the simulated module (see GpsSim.h) in real time, for any program that
+   reads a serial port (gpsd, u-center under Wine, a terminal, ...). Its output is paced at the module's baudrate
+   (a pty has none of its own, the rate the other end sets is not checked); what the other end writes is taken as
+   requests. Runs until interrupted (Ctrl-C), then prints the module's statistics.
+   for details: see README.md
+*/
+
+#include "GpsSim.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+#include <chrono>
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int signal)
+{
+  stopRequested = 1;
+}
+
+static void printUsage(const char* pName)
+{
+  fprintf(stderr,
+          "usage: %s [options]\n"
+          "  --link <path>      symlink to the pty's device (e.g. /tmp/ttyGPS)\n"
+          "  --model <name>     ublox (default), techtotop (answers the CFG-PRT poll only) or nmea (no UBX)\n"
+          "  --baud <rate>      the module's baudrate at power-up, i.e. its pace (default: 9600)\n"
+          "  --rate <hz>        epochs per second (default: 1)\n"
+          "  --sats <spec>      satellites in view per talker, e.g. GP:12,GL:8,GA:6,GB:4 (default: GP:10,GL:6)\n"
+          "  --ubx              NAV-SVINFO/-TIMEUTC/-SOL from power-up on\n"
+          "  --corrupt <ppm>    bytes corrupted per million\n"
+          "  --seed <n>         of the simulation (default: 1)\n",
+          pName);
+}
+
+static uint64_t getElapsedUs(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+  GpsSim::sim_config_t config = GpsSim::DEFAULT_CONFIG;
+  const char* pLinkPath = nullptr;
+
+  for (int i = 1; i < argc; i++)
+  {
+    bool ok = true;
+    if (!strcmp(argv[i], "--link") && i + 1 < argc)
+    {
+      pLinkPath = argv[++i];
+    }
+    else if (!strcmp(argv[i], "--model") && i + 1 < argc)
+    {
+      ok = GpsSim::parseModel(argv[++i], &config.model);
+    }
+    else if (!strcmp(argv[i], "--baud") && i + 1 < argc)
+    {
+      config.baud = strtoul(argv[++i], nullptr, 10);
+      ok = config.baud >= 300;
+    }
+    else if (!strcmp(argv[i], "--rate") && i + 1 < argc)
+    {
+      unsigned long rateHz = strtoul(argv[++i], nullptr, 10);
+      ok = rateHz >= 1 && rateHz <= 20;
+      config.measRateMs = ok ? 1000 / rateHz : config.measRateMs;
+    }
+    else if (!strcmp(argv[i], "--sats") && i + 1 < argc)
+    {
+      ok = GpsSim::parseSats(argv[++i], config.numSats);
+    }
+    else if (!strcmp(argv[i], "--ubx"))
+    {
+      config.ubxNavOn = true;
+    }
+    else if (!strcmp(argv[i], "--corrupt") && i + 1 < argc)
+    {
+      config.corruptPpm = strtoul(argv[++i], nullptr, 10);
+    }
+    else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+    {
+      config.seed = strtoul(argv[++i], nullptr, 10);
+    }
+    else
+    {
+      ok = false;
+    }
+    if (!ok)
+    {
+      printUsage(argv[0]);
+      return 2;
+    }
+  }
+
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+  {
+    fprintf(stderr, "Unable to open a pty: %s\n", strerror(errno));
+    return 1;
+  }
+  fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK); // nobody listening: the output is dropped
+  const char* pSlavePath = ptsname(master);
+  // raw, and kept open here so that the pty stays up while the other end reopens it
+  int slave = open(pSlavePath, O_RDWR | O_NOCTTY);
+  struct termios tio;
+  if (slave < 0 || tcgetattr(slave, &tio) != 0)
+  {
+    fprintf(stderr, "Unable to set up '%s': %s\n", pSlavePath, strerror(errno));
+    return 1;
+  }
+  cfmakeraw(&tio);
+  tcsetattr(slave, TCSANOW, &tio);
+  if (pLinkPath != nullptr)
+  {
+    unlink(pLinkPath);
+    if (symlink(pSlavePath, pLinkPath) != 0)
+    {
+      fprintf(stderr, "Unable to link '%s': %s\n", pLinkPath, strerror(errno));
+      return 1;
+    }
+  }
+  printf("GPS module on %s%s%s\n", pSlavePath, (pLinkPath != nullptr) ? " -> " : "",
+         (pLinkPath != nullptr) ? pLinkPath : "");
+  fflush(stdout);
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  GpsSim sim(config);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  uint8_t buf[4096];
+  while (!stopRequested)
+  {
+    // what the module has sent by now, then wait for requests until the next byte is due (1 ms at most)
+    uint64_t nowUs = getElapsedUs(start);
+    size_t len = 0;
+    unsigned long baud;
+    while (len < sizeof(buf) && sim.receive(nowUs, &buf[len], &baud))
+    {
+      len++;
+    }
+    if (len > 0 && write(master, buf, len) < 0 && errno != EAGAIN)
+    {
+      break;
+    }
+
+    uint64_t nextUs = sim.getNextByteUs();
+    int timeoutMs = (nextUs > nowUs + 1000) ? 1 : 0;
+    struct pollfd pfd = {master, POLLIN, 0};
+    if (poll(&pfd, 1, timeoutMs) > 0 && (pfd.revents & POLLIN))
+    {
+      ssize_t rxLen = read(master, buf, sizeof(buf));
+      nowUs = getElapsedUs(start);
+      for (ssize_t i = 0; i < rxLen; i++)
+      {
+        sim.transmit(buf[i], sim.getBaud(), nowUs);
+      }
+    }
+  }
+
+  if (pLinkPath != nullptr)
+  {
+    unlink(pLinkPath);
+  }
+  printf("\n");
+  sim.printStats(stdout);
+  close(slave);
+  close(master);
+  return 0;
+}
@@ -0,0 +1,202 @@
+/**
+   GpsSimRun.cpp
+   Host-side soak test: runs the unmodified ObsGpsTest sketch natively on Linux against simulated GPS modules (see
+   GpsSim.h), one on the serial port of each module the sketch is built for. Unlike a replayed capture, the simulated
+   module answers the sketch's UBX requests, changes its baudrate and rate when told to and restarts on CFG-RST, so
+   the baudrate detection and upshift, the UBX polls and the UBX navigation mode configuration run as on the device,
+   at any baudrate and with faults injected. Time is virtual, the run takes as long as the host needs.
+   for details: see README.md
+*/
+
+#include "HostHal.h"
+#include "../ObsGpsTest.ino"
+#include "SketchReport.h"
+#include "GpsSim.h"
+
+#include <chrono>
+
+static void printUsage(const char* pName)
+{
+  fprintf(stderr,
+          "usage: %s [options]\n"
+          "  --model <name>     ublox (default), techtotop (answers the CFG-PRT poll only) or nmea (no UBX)\n"
+          "  --baud <rate>      the module's baudrate at power-up (default: 9600)\n"
+          "  --rate <hz>        epochs per second (default: 1)\n"
+          "  --sats <spec>      satellites in view per talker, e.g. GP:12,GL:8,GA:6,GB:4 (default: GP:10,GL:6)\n"
+          "  --ubx              NAV-SVINFO/-TIMEUTC/-SOL from power-up on\n"
+          "  --no-nmea          no NMEA sentences from power-up on\n"
+          "  --start <type>     cold, warm or hot (default) start at power-up\n"
+          "  --ttff <ms>:<ms>:<ms>  time to fix after a cold, warm and hot start (default: 27000:22000:1000)\n"
+          "  --corrupt <ppm>    bytes corrupted per million\n"
+          "  --burst <ms>[:<n>] every <ms>, n further epochs back to back (default: 3)\n"
+          "  --gap <ms>:<ms>    every <ms>, no output for the given time\n"
+          "  --seed <n>         of the simulation (default: 1)\n"
+          "  --duration <s>     virtual time to run (default: 60)\n"
+          "  --fast             button pressed during power-up (the fast baudrate is tried first)\n"
+          "  --pbm <file>       write the last display frame as portable bitmap\n"
+          "  -q                 do not print the sketch's debug output\n",
+          pName);
+}
+
+static bool parseStart(const char* pName, GpsSim::StartType* pType)
+{
+  static const char* const Names[GpsSim::START_NUM] = {"cold", "warm", "hot"};
+  for (int i = 0; i < GpsSim::START_NUM; i++)
+  {
+    if (!strcmp(pName, Names[i]))
+    {
+      *pType = (GpsSim::StartType)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+int main(int argc, char** argv)
+{
+  GpsSim::sim_config_t config = GpsSim::DEFAULT_CONFIG;
+  const char* pPbmPath = nullptr;
+  bool quiet = false;
+  unsigned long durationSec = 60;
+
+  for (int i = 1; i < argc; i++)
+  {
+    bool ok = true;
+    char* pEnd = nullptr;
+    if (!strcmp(argv[i], "--model") && i + 1 < argc)
+    {
+      ok = GpsSim::parseModel(argv[++i], &config.model);
+    }
+    else if (!strcmp(argv[i], "--baud") && i + 1 < argc)
+    {
+      config.baud = strtoul(argv[++i], nullptr, 10);
+      ok = config.baud >= 300;
+    }
+    else if (!strcmp(argv[i], "--rate") && i + 1 < argc)
+    {
+      unsigned long rateHz = strtoul(argv[++i], nullptr, 10);
+      ok = rateHz >= 1 && rateHz <= 20;
+      config.measRateMs = ok ? 1000 / rateHz : config.measRateMs;
+    }
+    else if (!strcmp(argv[i], "--sats") && i + 1 < argc)
+    {
+      ok = GpsSim::parseSats(argv[++i], config.numSats);
+    }
+    else if (!strcmp(argv[i], "--ubx"))
+    {
+      config.ubxNavOn = true;
+    }
+    else if (!strcmp(argv[i], "--no-nmea"))
+    {
+      config.nmeaOn = false;
+    }
+    else if (!strcmp(argv[i], "--start") && i + 1 < argc)
+    {
+      ok = parseStart(argv[++i], &config.powerUpStart);
+    }
+    else if (!strcmp(argv[i], "--ttff") && i + 1 < argc)
+    {
+      config.ttffMs[GpsSim::START_COLD] = strtoul(argv[++i], &pEnd, 10);
+      ok = (*pEnd == ':');
+      config.ttffMs[GpsSim::START_WARM] = ok ? strtoul(pEnd + 1, &pEnd, 10) : 0;
+      ok = ok && (*pEnd == ':');
+      config.ttffMs[GpsSim::START_HOT] = ok ? strtoul(pEnd + 1, &pEnd, 10) : 0;
+    }
+    else if (!strcmp(argv[i], "--corrupt") && i + 1 < argc)
+    {
+      config.corruptPpm = strtoul(argv[++i], nullptr, 10);
+    }
+    else if (!strcmp(argv[i], "--burst") && i + 1 < argc)
+    {
+      config.burstEveryMs = strtoul(argv[++i], &pEnd, 10);
+      config.burstEpochs = (*pEnd == ':') ? strtoul(pEnd + 1, nullptr, 10) : config.burstEpochs;
+    }
+    else if (!strcmp(argv[i], "--gap") && i + 1 < argc)
+    {
+      config.gapEveryMs = strtoul(argv[++i], &pEnd, 10);
+      ok = (*pEnd == ':');
+      config.gapMs = ok ? strtoul(pEnd + 1, nullptr, 10) : 0;
+    }
+    else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+    {
+      config.seed = strtoul(argv[++i], nullptr, 10);
+    }
+    else if (!strcmp(argv[i], "--duration") && i + 1 < argc)
+    {
+      durationSec = strtoul(argv[++i], nullptr, 10);
+    }
+    else if (!strcmp(argv[i], "--fast"))
+    {
+      hostSetPinLevel(ButtonPin, HIGH);
+    }
+    else if (!strcmp(argv[i], "--pbm") && i + 1 < argc)
+    {
+      pPbmPath = argv[++i];
+    }
+    else if (!strcmp(argv[i], "-q"))
+    {
+      quiet = true;
+    }
+    else
+    {
+      ok = false;
+    }
+    if (!ok)
+    {
+      printUsage(argv[0]);
+      return 2;
+    }
+  }
+
+  // a module of its own (w/ its own sky) on the port of each one the sketch tests
+  GpsSim* sims[GPS_NUM_MODULES];
+  for (uint8_t i = 0; i < GPS_NUM_MODULES; i++)
+  {
+    GpsSim::sim_config_t moduleConfig = config;
+    moduleConfig.seed = config.seed + i;
+    sims[i] = new GpsSim(moduleConfig);
+    GpsSoftwareSerial::getUart(GpsPorts[i].uartNum).setSource(sims[i]);
+  }
+  Serial.setOutput(quiet ? nullptr : stdout);
+
+  std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now();
+  try
+  {
+    setup();
+    while (hostMicros() < (uint64_t)durationSec * 1000000)
+    {
+      loop();
+    }
+  }
+  catch (const HostReplayEnd&)
+  {
+  }
+  hostRequestStop();
+  hostJoinTasks();
+  double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  double virtualSec = hostMicros() / 1e6;
+
+  printf("\n");
+  printf("Simulated %.1f s of GPS time in %.3f s (x%.0f)\n", virtualSec, wallSec,
+         (wallSec > 0) ? virtualSec / wallSec : 0.0);
+  for (uint8_t i = 0; i < GPS_NUM_MODULES; i++)
+  {
+    const GpsSim::sim_stats_t& stats = sims[i]->getStats();
+    if (GPS_NUM_MODULES > 1)
+    {
+      printf("\nModule %u:\n", i + 1);
+    }
+    printf("Throughput: %.0f bytes/s, %.1f GSV cycles/s (%u cycles)\n",
+           (wallSec > 0) ? stats.bytesSent / wallSec : 0.0, (wallSec > 0) ? modules[i].gsvCycleCount / wallSec : 0.0,
+           modules[i].gsvCycleCount.load());
+    sims[i]->printStats(stdout);
+    printModuleStats(modules[i], GpsSoftwareSerial::getUart(GpsPorts[i].uartNum));
+  }
+
+  if (pPbmPath != nullptr && !u8g2.writePbm(pPbmPath))
+  {
+    fprintf(stderr, "Unable to write '%s'.\n", pPbmPath);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,56 @@
+/**
+   MetricsDump.cpp
+   Host-side decoding of the binary metrics records that the GPS test sends on its debug serial with
+   GPS_METRICS_OUTPUT set to 2 (see Metrics.h): every record with a valid checksum is printed as the same CSV lines
+   as with GPS_METRICS_OUTPUT set to 1, the text in between is skipped.
+   for details: see README.md
+*/
+
+#include <stdio.h>
+#include <vector>
+#include "Metrics.h"
+
+int main(int argc, char** argv)
+{
+  if (argc != 2)
+  {
+    fprintf(stderr, "usage: %s <debug serial log>\n", argv[0]);
+    return 2;
+  }
+
+  FILE* pFile = fopen(argv[1], "rb");
+  if (pFile == nullptr)
+  {
+    fprintf(stderr, "Unable to open '%s'.\n", argv[1]);
+    return 1;
+  }
+  std::vector<uint8_t> log;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), pFile)) > 0)
+  {
+    log.insert(log.end(), buf, buf + n);
+  }
+  fclose(pFile);
+
+  Serial.setOutput(stdout);
+  GpsMetrics::printCsvHeader(Serial);
+  unsigned int numRecords = 0;
+  GpsMetrics::metrics_record_t record;
+  for (size_t pos = 0; pos + GpsMetrics::BINARY_LEN <= log.size(); pos++)
+  {
+    if (GpsMetrics::decodeBinary(&log[pos], log.size() - pos, &record))
+    {
+      GpsMetrics::printCsv(Serial, record);
+      numRecords++;
+      pos += GpsMetrics::BINARY_LEN - 1;
+    }
+  }
+
+  if (numRecords == 0)
+  {
+    fprintf(stderr, "No metrics record found in '%s'.\n", argv[1]);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,146 @@
+/**
+   RxDump.cpp
+   Host-side extraction of the raw RX captures that the GPS test prints on its debug serial (see dumpRxCapture() in
+   the sketch): each block between "-----BEGIN RX CAPTURE <length>-----" and "-----END RX CAPTURE-----" is written
+   as <base>.ubx (the bytes as received, for u-center and gps_replay) and <base>.nmea (only the NMEA sentences with
+   a valid checksum); further blocks of the same log go to <base>-2.*, <base>-3.* and so on.
+   for details: see README.md
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <string>
+#include "FrameScorer.h"
+
+static const char BeginMarker[] = "-----BEGIN RX CAPTURE ";
+
+static bool writeFile(const std::string& path, const uint8_t* pData, size_t len)
+{
+  FILE* pFile = fopen(path.c_str(), "wb");
+  if (pFile == nullptr)
+  {
+    return false;
+  }
+  bool ok = fwrite(pData, 1, len, pFile) == len;
+  return (fclose(pFile) == 0) && ok;
+}
+
+static int hexValue(uint8_t c)
+{
+  if (c >= '0' && c <= '9')
+  {
+    return c - '0';
+  }
+  if (c >= 'A' && c <= 'F')
+  {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+static std::vector<uint8_t> extractNmea(const uint8_t* pData, size_t len, unsigned int* pNumSentences)
+{
+  // '$', printable characters up to '*', two hex digits matching the XOR of the characters in between
+  std::vector<uint8_t> nmea;
+  *pNumSentences = 0;
+  for (size_t i = 0; i < len; i++)
+  {
+    if (pData[i] != '$')
+    {
+      continue;
+    }
+    uint8_t checksum = 0;
+    size_t j = i + 1;
+    while (j < len && j - i < FrameScorer::NMEA_MAX_LEN && pData[j] >= 0x20 && pData[j] <= 0x7E && pData[j] != '*' &&
+           pData[j] != '$')
+    {
+      checksum ^= pData[j++];
+    }
+    if (j + 2 < len && pData[j] == '*' && hexValue(pData[j + 1]) >= 0 && hexValue(pData[j + 2]) >= 0 &&
+        ((hexValue(pData[j + 1]) << 4) | hexValue(pData[j + 2])) == checksum)
+    {
+      nmea.insert(nmea.end(), &pData[i], &pData[j + 3]);
+      nmea.push_back('\r');
+      nmea.push_back('\n');
+      ++*pNumSentences;
+      i = j + 2;
+    }
+  }
+  return nmea;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc != 3)
+  {
+    fprintf(stderr, "usage: %s <debug serial log> <output base name>\n", argv[0]);
+    return 2;
+  }
+
+  FILE* pFile = fopen(argv[1], "rb");
+  if (pFile == nullptr)
+  {
+    fprintf(stderr, "Unable to open '%s'.\n", argv[1]);
+    return 1;
+  }
+  std::vector<uint8_t> log;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), pFile)) > 0)
+  {
+    log.insert(log.end(), buf, buf + n);
+  }
+  fclose(pFile);
+
+  unsigned int numCaptures = 0;
+  size_t markerLen = strlen(BeginMarker);
+  for (size_t pos = 0; pos + markerLen < log.size(); pos++)
+  {
+    if (memcmp(&log[pos], BeginMarker, markerLen) != 0)
+    {
+      continue;
+    }
+    // the length, then the rest of the marker line; the capture follows right after its line break
+    size_t len = strtoul((const char*)&log[pos + markerLen], nullptr, 10);
+    size_t start = pos + markerLen;
+    while (start < log.size() && log[start] != '\n')
+    {
+      start++;
+    }
+    start++;
+    if (start + len > log.size())
+    {
+      fprintf(stderr, "Capture at byte %zu of the log is truncated (%zu of %zu bytes).\n", pos,
+              (start < log.size()) ? log.size() - start : 0, len);
+      len = (start < log.size()) ? log.size() - start : 0;
+    }
+
+    numCaptures++;
+    std::string base = argv[2];
+    if (numCaptures > 1)
+    {
+      base += "-" + std::to_string(numCaptures);
+    }
+    unsigned int numSentences;
+    std::vector<uint8_t> nmea = extractNmea(&log[start], len, &numSentences);
+    FrameScorer scorer;
+    scorer.feed(&log[start], len);
+    if (!writeFile(base + ".ubx", &log[start], len) || !writeFile(base + ".nmea", nmea.data(), nmea.size()))
+    {
+      fprintf(stderr, "Unable to write '%s.ubx/.nmea'.\n", base.c_str());
+      return 1;
+    }
+    printf("%s.ubx: %zu bytes, %u UBX frames, %u NMEA sentences, %u errors; %s.nmea: %u sentences\n", base.c_str(), len,
+           scorer.getValidUbxCount(), scorer.getValidNmeaCount(), scorer.getErrorCount(), base.c_str(), numSentences);
+    pos = start + len - 1;
+  }
+
+  if (numCaptures == 0)
+  {
+    fprintf(stderr, "No RX capture found in '%s'.\n", argv[1]);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,45 @@
+#ifndef SketchReport_h
+#define SketchReport_h
+
+// End-of-run report of the host tools that run the sketch (include right after it): GPS serial and decoder statistics
+// and the final satellite table of a module
+
+static void printSatTable(const GpsModule& m)
+{
+  if (m.pEpoch == nullptr)
+  {
+    printf("No complete satellite table.\n");
+    return;
+  }
+  const sat_epoch_t& epoch = *m.pEpoch;
+
+  printf("Final satellite table (%d active, %d with azimuth/elevation):\n", epoch.numSats, epoch.numValidAzEls);
+  printf("  %3s %4s %5s %5s %4s\n", "sys", "no", "elev", "azim", "snr");
+  for (int i = 0; i < epoch.numSats; i++)
+  {
+    uint8_t slot = epoch.ranked[i];
+    printf("  %3c %4d %5d %5d %4d\n", GsvParser::getSystemLetter(epoch.system[slot]), epoch.prn[slot],
+           epoch.elevation[slot], epoch.azimuth[slot], epoch.snr[slot]);
+  }
+  if (epoch.timeValid)
+  {
+    printf("UTC time: %02d:%02d:%02d\n", epoch.hour, epoch.minute, epoch.second);
+  }
+}
+
+static void printModuleStats(GpsModule& m, HardwareSerial& port)
+{
+  GpsSoftwareSerial& gs = m.gs;
+  printf("GPS serial: %u bytes read, %zu dropped, %u overflows, high water %zu/%zu\n", gs.getRxCount(),
+         port.getDroppedCount(), gs.getRxOverflowCount(), gs.getRxHighWater(), gs.getRxBufferSize());
+  printf("UBX: %u frames, %u checksum errors, %u length errors; NMEA %sseen: %u sentences, %u checksum errors; "
+         "%u resyncs\n", gs.getUbxFrameCount(), gs.getUbxChecksumErrorCount(), gs.getUbxLengthErrorCount(),
+         gs.hasSeenNmea() ? "" : "not ", (unsigned int)gs.getNmeaSentenceCount(),
+         (unsigned int)gs.getNmeaChecksumErrorCount(), (unsigned int)gs.getResyncCount());
+#if GPS_PIPELINE_MODE
+  printf("GSV cycles dropped between RX task and UI: %u\n", m.satStore.getDropCount());
+#endif
+  printSatTable(m);
+}
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef HostArduino_h
+#define HostArduino_h
+
+// Minimal stand-in for the parts of the Arduino (ESP32) core used by the GPS test firmware, so that the sketch and its
+// modules compile natively on Linux. Time is simulated: millis()/micros() follow a virtual clock that is advanced by
+// delay() and by waiting for bytes of the replayed GPS capture (see HostHal.h).
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include <functional>
+#include <vector>
+#include <deque>
+
+#define ARDUINO_HOST_BUILD 1
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PROGMEM
+#define F(str) (str)
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define INPUT_PULLDOWN 0x09
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+#define IRAM_ATTR
+
+#define DEC 10
+#define HEX 16
+
+#define PI 3.1415926535897932384626433832795
+#define TWO_PI 6.283185307179586476925286766559
+#define radians(deg) ((deg) * (PI / 180.0))
+#define degrees(rad) ((rad) * (180.0 / PI))
+#define sq(x) ((x) * (x))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+static const uint8_t SDA = 21;
+static const uint8_t SCL = 22;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t val);
+char* itoa(int value, char* str, int base);
+char* ltoa(long value, char* str, int base); // values within the int range only
+#define digitalPinToInterrupt(pin) (pin)
+void attachInterruptArg(uint8_t pin, void (*pIsr)(void*), void* pArg, int mode); // called by hostSetPinLevel()
+void detachInterrupt(uint8_t pin);
+char* utoa(unsigned int value, char* str, int base);
+
+// ESP32 Arduino core version, so that version-dependent code takes the same path as with a current core
+#define ESP_ARDUINO_VERSION_VAL(major, minor, patch) ((major << 16) | (minor << 8) | (patch))
+#define ESP_ARDUINO_VERSION ESP_ARDUINO_VERSION_VAL(2, 0, 14)
+
+// FreeRTOS tasks are mapped to std::thread (a task returns when the replayed capture has been consumed)
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+#define configMAX_PRIORITIES 25
+#define pdPASS 1
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode, const char* pcName, uint32_t usStackDepth, void* pvParameters,
+                                   UBaseType_t uxPriority, TaskHandle_t* pvCreatedTask, BaseType_t xCoreID);
+void vTaskDelay(uint32_t ticks);
+
+#define SERIAL_8N1 0x800001c
+
+typedef enum {
+  UART_NO_ERROR,
+  UART_BREAK_ERROR,
+  UART_BUFFER_FULL_ERROR,
+  UART_FIFO_OVF_ERROR,
+  UART_FRAME_ERROR,
+  UART_PARITY_ERROR
+} hardwareSerial_error_t;
+
+typedef std::function<void(hardwareSerial_error_t)> OnReceiveErrorCb;
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t b) = 0;
+    size_t write(const uint8_t* pBuf, size_t len);
+    size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+
+    size_t print(const char* str) { return write(str); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(long long n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned long long n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(double n, int digits = 2);
+
+    size_t println() { return write("\r\n"); }
+    size_t println(const char* str) { return print(str) + println(); }
+    size_t println(char c) { return print(c) + println(); }
+    size_t println(unsigned char n, int base = DEC) { return print(n, base) + println(); }
+    size_t println(int n, int base = DEC) { return print(n, base) + println(); }
+    size_t println(unsigned int n, int base = DEC) { return print(n, base) + println(); }
+    size_t println(long n, int base = DEC) { return print(n, base) + println(); }
+    size_t println(unsigned long n, int base = DEC) { return print(n, base) + println(); }
+    size_t println(long long n, int base = DEC) { return print(n, base) + println(); }
+    size_t println(unsigned long long n, int base = DEC) { return print(n, base) + println(); }
+    size_t println(double n, int digits = 2) { return print(n, digits) + println(); }
+};
+
+// Serial port stand-in; the debug port (Serial) writes to a file, the GPS port (Serial2) replays a recorded capture
+class HostSerialSource; // see HostHal.h
+
+class HardwareSerial : public Print {
+  public:
+    HardwareSerial(int uartNum);
+
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1);
+    void end() {}
+    void updateBaudRate(unsigned long baud) { mBaud = baud; } // the input keeps arriving at the line's rate
+    unsigned long baudRate() { return mBaud; }
+    size_t setRxBufferSize(size_t size);
+    void onReceiveError(OnReceiveErrorCb function) { mOnReceiveError = function; }
+
+    int available();
+    int peek();
+    int read();
+    size_t read(uint8_t* pBuf, size_t len);
+    void flush() {}
+
+    using Print::write;
+    size_t write(uint8_t b) override;
+
+    // host side
+    void setOutput(FILE* pOut) { mOut = pOut; }
+    void setInput(const std::vector<uint8_t>& data);
+    void setLineBaud(unsigned long baud) { mLineBaud = baud; } // rate of the input (default: the one of begin())
+    unsigned long getLineBaud() { return mLineBaud; }
+    bool inputExhausted(); // all of the input has arrived and has been read
+    bool inputArrived(); // all of the input has arrived (some of it may still be waiting in the RX buffer)
+    size_t getInputLen() { return mInput.size(); }
+    size_t getDroppedCount() { return mDropped; }
+    size_t getTxCount() { return mTxCount; }
+    void onTransmit(std::function<void(uint8_t)> function) { mOnTransmit = function; }
+    void setSource(HostSerialSource* pSource) { mpSource = pSource; } // in place of the input (nullptr: input again)
+
+  private:
+    size_t pending();
+
+    int mUartNum;
+    unsigned long mBaud;
+    unsigned long mLineBaud; // the input arrives at this rate, it is garbage when the port is set to another one
+    size_t mRxBufferSize;
+    FILE* mOut;
+    std::vector<uint8_t> mInput;
+    uint64_t mStartUs; // virtual time of the first begin(), the capture starts arriving from then on
+    bool mStarted;
+    size_t mArrived; // number of capture bytes that have arrived at the UART so far (buffered or dropped)
+    std::deque<uint8_t> mRxBuffer;
+    size_t mDropped;
+    size_t mTxCount;
+    OnReceiveErrorCb mOnReceiveError;
+    std::function<void(uint8_t)> mOnTransmit;
+    HostSerialSource* mpSource;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+extern HardwareSerial Serial2;
+
+#endif
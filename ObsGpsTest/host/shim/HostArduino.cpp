@@ -0,0 +1,428 @@
+#include "HostHal.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+  std::recursive_mutex hostLock; // clock and serial ports are shared between the loop and the tasks (threads)
+  uint64_t virtualMicros = 0;
+  int pinLevels[64] = {LOW};
+  struct
+  {
+    void (*pIsr)(void*);
+    void* pArg;
+    int mode;
+  } pinInterrupts[64] = {};
+  std::vector<std::thread> tasks;
+  std::atomic<bool> stopRequested(false);
+}
+
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+HardwareSerial Serial2(2);
+
+uint64_t hostMicros()
+{
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  return virtualMicros;
+}
+
+void hostAdvanceMicros(uint64_t us)
+{
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  virtualMicros += us;
+}
+
+void hostSetPinLevel(uint8_t pin, int level)
+{
+  // like the GPIO interrupt: the handler runs right away (in the caller's thread) on a matching edge
+  int previous = pinLevels[pin % 64];
+  pinLevels[pin % 64] = level;
+  int mode = pinInterrupts[pin % 64].mode;
+  if(pinInterrupts[pin % 64].pIsr != nullptr && level != previous &&
+     (mode == CHANGE || (mode == RISING && level == HIGH) || (mode == FALLING && level == LOW)))
+  {
+    pinInterrupts[pin % 64].pIsr(pinInterrupts[pin % 64].pArg);
+  }
+}
+
+bool hostLoadCapture(HardwareSerial& port, const char* path)
+{
+  FILE* pFile = fopen(path, "rb");
+  if(pFile == nullptr)
+  {
+    return false;
+  }
+  std::vector<uint8_t> data;
+  uint8_t chunk[4096];
+  size_t len;
+  while((len = fread(chunk, 1, sizeof(chunk), pFile)) > 0)
+  {
+    data.insert(data.end(), chunk, chunk + len);
+  }
+  fclose(pFile);
+  port.setInput(data);
+  return true;
+}
+
+void hostRequestStop()
+{
+  stopRequested = true;
+}
+
+void hostJoinTasks()
+{
+  for(size_t i=0; i<tasks.size(); i++)
+  {
+    tasks[i].join();
+  }
+  tasks.clear();
+}
+
+unsigned long millis()
+{
+  return (unsigned long)(hostMicros() / 1000);
+}
+
+unsigned long micros()
+{
+  return (unsigned long)hostMicros();
+}
+
+void delay(unsigned long ms)
+{
+  hostAdvanceMicros((uint64_t)ms * 1000);
+  if(stopRequested || (Serial2.getInputLen() > 0 && Serial2.inputArrived()))
+  {
+    throw HostReplayEnd();
+  }
+  std::this_thread::yield(); // let the other "core" run
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  hostAdvanceMicros(us);
+}
+
+void yield()
+{
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+}
+
+void attachInterruptArg(uint8_t pin, void (*pIsr)(void*), void* pArg, int mode)
+{
+  pinInterrupts[pin % 64].pIsr = pIsr;
+  pinInterrupts[pin % 64].pArg = pArg;
+  pinInterrupts[pin % 64].mode = mode;
+}
+
+void detachInterrupt(uint8_t pin)
+{
+  pinInterrupts[pin % 64].pIsr = nullptr;
+}
+
+int digitalRead(uint8_t pin)
+{
+  return pinLevels[pin % 64];
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+  pinLevels[pin % 64] = val;
+}
+
+char* utoa(unsigned int value, char* str, int base)
+{
+  char digits[33];
+  int len = 0;
+  do
+  {
+    unsigned int digit = value % base;
+    digits[len++] = (digit < 10) ? ('0' + digit) : ('a' + digit - 10);
+    value /= base;
+  } while(value > 0);
+
+  for(int i=0; i<len; i++)
+  {
+    str[i] = digits[len - 1 - i];
+  }
+  str[len] = '\0';
+  return str;
+}
+
+char* itoa(int value, char* str, int base)
+{
+  if(value < 0 && base == 10)
+  {
+    str[0] = '-';
+    utoa((unsigned int)(-(long)value), str + 1, base);
+    return str;
+  }
+  return utoa((unsigned int)value, str, base);
+}
+
+char* ltoa(long value, char* str, int base)
+{
+  return itoa((int)value, str, base);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode, const char* pcName, uint32_t usStackDepth, void* pvParameters,
+                                   UBaseType_t uxPriority, TaskHandle_t* pvCreatedTask, BaseType_t xCoreID)
+{
+  tasks.push_back(std::thread([pvTaskCode, pvParameters]() {
+    try
+    {
+      pvTaskCode(pvParameters);
+    }
+    catch(const HostReplayEnd&)
+    {
+      // capture consumed: the task ends
+    }
+  }));
+  return pdPASS;
+}
+
+void vTaskDelay(uint32_t ticks)
+{
+  delay(ticks); // 1 tick = 1 ms
+}
+
+size_t Print::write(const uint8_t* pBuf, size_t len)
+{
+  size_t n = 0;
+  for(size_t i=0; i<len; i++)
+  {
+    n += write(pBuf[i]);
+  }
+  return n;
+}
+
+size_t Print::print(long n, int base)
+{
+  char buf[34];
+  if(base == DEC)
+  {
+    snprintf(buf, sizeof(buf), "%ld", n);
+    return write(buf);
+  }
+  return print((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+  char buf[34];
+  if(base == HEX)
+  {
+    snprintf(buf, sizeof(buf), "%lX", n);
+  }
+  else
+  {
+    snprintf(buf, sizeof(buf), "%lu", n);
+  }
+  return write(buf);
+}
+
+size_t Print::print(double n, int digits)
+{
+  char buf[48];
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write(buf);
+}
+
+HardwareSerial::HardwareSerial(int uartNum) :
+    mUartNum(uartNum),
+    mBaud(0),
+    mLineBaud(0),
+    mRxBufferSize(256),
+    mOut(uartNum == 0 ? stdout : nullptr),
+    mStartUs(0),
+    mStarted(false),
+    mArrived(0),
+    mDropped(0),
+    mTxCount(0),
+    mpSource(nullptr)
+{
+}
+
+void HardwareSerial::begin(unsigned long baud, uint32_t config, int8_t rxPin, int8_t txPin)
+{
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  // a later begin() only changes the port's rate (the input goes on where it is)
+  mBaud = baud;
+  if(!mStarted)
+  {
+    mStartUs = virtualMicros;
+    mStarted = true;
+  }
+  if(mLineBaud == 0)
+  {
+    mLineBaud = baud;
+  }
+}
+
+size_t HardwareSerial::setRxBufferSize(size_t size)
+{
+  mRxBufferSize = size;
+  return size;
+}
+
+void HardwareSerial::setInput(const std::vector<uint8_t>& data)
+{
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  mInput = data;
+  mArrived = 0;
+  mRxBuffer.clear();
+  mDropped = 0;
+}
+
+bool HardwareSerial::inputExhausted()
+{
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  return mArrived >= mInput.size() && mRxBuffer.empty();
+}
+
+bool HardwareSerial::inputArrived()
+{
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  pending();
+  return mArrived >= mInput.size();
+}
+
+size_t HardwareSerial::pending()
+{
+  // bytes of the capture arrive at the line's baudrate (10 bits per byte) from begin() on;
+  // what does not fit into the RX buffer any more is dropped, just like the UART driver would do;
+  // when the port is set to another rate, the UART samples garbage (a byte scrambled beyond any framing here)
+  if(mBaud == 0)
+  {
+    return 0;
+  }
+  bool overflow = false;
+  if(mpSource != nullptr)
+  {
+    // a live source: whatever it has sent by now, garbage when sent at another rate
+    uint8_t c;
+    unsigned long lineBaud;
+    while(mpSource->receive(virtualMicros, &c, &lineBaud))
+    {
+      if(mRxBuffer.size() < mRxBufferSize)
+      {
+        mRxBuffer.push_back((mBaud == lineBaud) ? c : (uint8_t)((c ^ 0xA5) * 0x9D + mArrived));
+      }
+      else
+      {
+        ++mDropped;
+        overflow = true;
+      }
+      ++mArrived;
+    }
+    if(overflow && mOnReceiveError)
+    {
+      mOnReceiveError(UART_BUFFER_FULL_ERROR);
+    }
+    return mRxBuffer.size();
+  }
+  uint64_t arrived = (virtualMicros - mStartUs) * mLineBaud / 10 / 1000000;
+  if(arrived > mInput.size())
+  {
+    arrived = mInput.size();
+  }
+  for(; mArrived < arrived; mArrived++)
+  {
+    if(mRxBuffer.size() < mRxBufferSize)
+    {
+      uint8_t c = mInput[mArrived];
+      mRxBuffer.push_back((mBaud == mLineBaud) ? c : (uint8_t)((c ^ 0xA5) * 0x9D + mArrived));
+    }
+    else
+    {
+      ++mDropped;
+      overflow = true;
+    }
+  }
+  if(overflow && mOnReceiveError)
+  {
+    mOnReceiveError(UART_BUFFER_FULL_ERROR);
+  }
+  return mRxBuffer.size();
+}
+
+int HardwareSerial::available()
+{
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  size_t waiting = pending();
+  if(waiting == 0 && mBaud > 0)
+  {
+    // nothing there yet: the time until the next byte arrives (or 1 ms when there's nothing left) passes by
+    if(mpSource != nullptr)
+    {
+      uint64_t arrivalUs = mpSource->getNextByteUs();
+      virtualMicros = (arrivalUs > virtualMicros && arrivalUs - virtualMicros < 1000) ? arrivalUs : virtualMicros + 1000;
+    }
+    else if(mArrived < mInput.size())
+    {
+      uint64_t arrivalUs = mStartUs + ((uint64_t)(mArrived + 1) * 10 * 1000000 + mLineBaud - 1) / mLineBaud;
+      if(arrivalUs > virtualMicros)
+      {
+        virtualMicros = arrivalUs;
+      }
+    }
+    else
+    {
+      virtualMicros += 1000;
+    }
+  }
+  return (int)waiting;
+}
+
+int HardwareSerial::peek()
+{
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  return (pending() > 0) ? mRxBuffer.front() : -1;
+}
+
+int HardwareSerial::read()
+{
+  uint8_t c;
+  return (read(&c, 1) == 1) ? c : -1;
+}
+
+size_t HardwareSerial::read(uint8_t* pBuf, size_t len)
+{
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  size_t n = pending();
+  if(n > len)
+  {
+    n = len;
+  }
+  for(size_t i=0; i<n; i++)
+  {
+    pBuf[i] = mRxBuffer.front();
+    mRxBuffer.pop_front();
+  }
+  return n;
+}
+
+size_t HardwareSerial::write(uint8_t b)
+{
+  std::lock_guard<std::recursive_mutex> lock(hostLock);
+  ++mTxCount;
+  if(mOut != nullptr)
+  {
+    fputc(b, mOut);
+  }
+  if(mOnTransmit)
+  {
+    mOnTransmit(b);
+  }
+  if(mpSource != nullptr)
+  {
+    mpSource->transmit(b, mBaud, virtualMicros);
+  }
+  return 1;
+}
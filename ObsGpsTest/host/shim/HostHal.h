@@ -0,0 +1,33 @@
+#ifndef HostHal_h
+#define HostHal_h
+
+// Host-only control of the simulated hardware behind the Arduino stand-in (used by the host tools, not by the sketch)
+
+#include "Arduino.h"
+
+// thrown from delay()/vTaskDelay() once the replayed capture has arrived completely, so that sketch code that
+// loops forever (e.g. the RX task) hands control back to the host tool
+struct HostReplayEnd {};
+
+// the other end of a serial line that sends as time goes by (e.g. a simulated GPS module), in place of a fixed input
+// (see HardwareSerial::setSource()); called w/ the host lock held, i.e. never concurrently
+class HostSerialSource {
+  public:
+    virtual ~HostSerialSource() {}
+
+    // the next byte complete on the line by `nowUs` and the baudrate it has been sent at; false when there is none
+    virtual bool receive(uint64_t nowUs, uint8_t* pByte, unsigned long* pBaud) = 0;
+    // when the next byte will be complete (UINT64_MAX: nothing on the way)
+    virtual uint64_t getNextByteUs() = 0;
+    // a byte sent to the other end, by a UART set to `baud`
+    virtual void transmit(uint8_t b, unsigned long baud, uint64_t nowUs) = 0;
+};
+
+uint64_t hostMicros();
+void hostAdvanceMicros(uint64_t us);
+void hostSetPinLevel(uint8_t pin, int level); // input pin level, runs an attached interrupt handler on a matching edge
+bool hostLoadCapture(HardwareSerial& port, const char* path);
+void hostRequestStop(); // delay()/vTaskDelay() throw HostReplayEnd from now on (ends the tasks of a live source)
+void hostJoinTasks(); // waits for all tasks created via xTaskCreatePinnedToCore() to return
+
+#endif
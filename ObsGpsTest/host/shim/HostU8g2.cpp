@@ -0,0 +1,307 @@
+#include "U8g2lib.h"
+#include "HostHal.h"
+
+const uint8_t u8g2_font_chikita_tn[] = {4, 6};
+const uint8_t u8g2_font_chikita_tf[] = {4, 6};
+const uint8_t u8g2_font_siji_t_6x10[] = {6, 10};
+const uint8_t u8g2_font_streamline_interface_essential_other_t[] = {21, 21};
+const uint8_t u8g2_font_streamline_map_navigation_t[] = {21, 21};
+const uint8_t u8g2_font_streamline_interface_essential_link_t[] = {21, 21};
+const uint8_t u8g2_font_unifont_t_animals[] = {16, 16};
+const uint8_t u8g2_font_unifont_t_symbols[] = {16, 16};
+const uint8_t u8g2_font_7x13_t_symbols[] = {7, 13};
+
+U8G2::U8G2() :
+    mDrawColor(1),
+    mBitmapTransparent(0),
+    mpFont(nullptr),
+    mTransferCount(0),
+    mBytesSent(0),
+    mFrameTransferUs(0)
+{
+  memset(mBuffer, 0, sizeof(mBuffer));
+  memset(mSentBuffer, 0, sizeof(mSentBuffer));
+}
+
+void U8G2::sendBuffer()
+{
+  memcpy(mSentBuffer, mBuffer, sizeof(mBuffer));
+  mBytesSent += sizeof(mBuffer);
+  ++mTransferCount;
+  hostAdvanceMicros(mFrameTransferUs);
+}
+
+void U8G2::updateDisplayArea(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th)
+{
+  // tiles are 8x8 pixels, i.e. 8 bytes of one page
+  for(uint8_t row=ty; row<ty+th && row<getBufferTileHeight(); row++)
+  {
+    for(uint8_t col=tx; col<tx+tw && col<getBufferTileWidth(); col++)
+    {
+      size_t offs = (size_t)row * WIDTH + (size_t)col * 8;
+      memcpy(&mSentBuffer[offs], &mBuffer[offs], 8);
+      mBytesSent += 8;
+    }
+  }
+  ++mTransferCount;
+  hostAdvanceMicros((uint64_t)mFrameTransferUs * tw * th / (getBufferTileWidth() * getBufferTileHeight()));
+}
+
+void U8G2::drawPixel(u8g2_int_t x, u8g2_int_t y)
+{
+  if(x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT)
+  {
+    return;
+  }
+  uint8_t& b = mBuffer[(y >> 3) * WIDTH + x];
+  uint8_t mask = 1 << (y & 7);
+  switch(mDrawColor)
+  {
+    case 0:
+      b &= ~mask;
+      break;
+    case 1:
+      b |= mask;
+      break;
+    default:
+      b ^= mask;
+      break;
+  }
+}
+
+void U8G2::drawHLine(u8g2_int_t x, u8g2_int_t y, u8g2_int_t w)
+{
+  for(u8g2_int_t i=0; i<w; i++)
+  {
+    drawPixel(x + i, y);
+  }
+}
+
+void U8G2::drawVLine(u8g2_int_t x, u8g2_int_t y, u8g2_int_t h)
+{
+  for(u8g2_int_t i=0; i<h; i++)
+  {
+    drawPixel(x, y + i);
+  }
+}
+
+void U8G2::drawLine(u8g2_int_t x1, u8g2_int_t y1, u8g2_int_t x2, u8g2_int_t y2)
+{
+  // Bresenham
+  int dx = abs(x2 - x1);
+  int dy = -abs(y2 - y1);
+  int sx = (x1 < x2) ? 1 : -1;
+  int sy = (y1 < y2) ? 1 : -1;
+  int err = dx + dy;
+  while(true)
+  {
+    drawPixel(x1, y1);
+    if(x1 == x2 && y1 == y2)
+    {
+      break;
+    }
+    int e2 = 2 * err;
+    if(e2 >= dy)
+    {
+      err += dy;
+      x1 += sx;
+    }
+    if(e2 <= dx)
+    {
+      err += dx;
+      y1 += sy;
+    }
+  }
+}
+
+void U8G2::drawBox(u8g2_int_t x, u8g2_int_t y, u8g2_int_t w, u8g2_int_t h)
+{
+  for(u8g2_int_t i=0; i<h; i++)
+  {
+    drawHLine(x, y + i, w);
+  }
+}
+
+void U8G2::drawFrame(u8g2_int_t x, u8g2_int_t y, u8g2_int_t w, u8g2_int_t h)
+{
+  if(w <= 0 || h <= 0)
+  {
+    return;
+  }
+  drawHLine(x, y, w);
+  if(h > 1)
+  {
+    drawHLine(x, y + h - 1, w);
+  }
+  if(h > 2)
+  {
+    drawVLine(x, y + 1, h - 2);
+    if(w > 1)
+    {
+      drawVLine(x + w - 1, y + 1, h - 2);
+    }
+  }
+}
+
+void U8G2::drawCircleSection(u8g2_int_t x, u8g2_int_t y, u8g2_int_t x0, u8g2_int_t y0, uint8_t option)
+{
+  if(option & U8G2_DRAW_UPPER_RIGHT)
+  {
+    drawPixel(x0 + x, y0 - y);
+    drawPixel(x0 + y, y0 - x);
+  }
+  if(option & U8G2_DRAW_UPPER_LEFT)
+  {
+    drawPixel(x0 - x, y0 - y);
+    drawPixel(x0 - y, y0 - x);
+  }
+  if(option & U8G2_DRAW_LOWER_RIGHT)
+  {
+    drawPixel(x0 + x, y0 + y);
+    drawPixel(x0 + y, y0 + x);
+  }
+  if(option & U8G2_DRAW_LOWER_LEFT)
+  {
+    drawPixel(x0 - x, y0 + y);
+    drawPixel(x0 - y, y0 + x);
+  }
+}
+
+void U8G2::drawCircle(u8g2_int_t x0, u8g2_int_t y0, u8g2_int_t rad, uint8_t option)
+{
+  // same midpoint algorithm as U8g2
+  int f = 1 - rad;
+  int ddFx = 1;
+  int ddFy = -2 * rad;
+  u8g2_int_t x = 0;
+  u8g2_int_t y = rad;
+
+  drawCircleSection(x, y, x0, y0, option);
+  while(x < y)
+  {
+    if(f >= 0)
+    {
+      y--;
+      ddFy += 2;
+      f += ddFy;
+    }
+    x++;
+    ddFx += 2;
+    f += ddFx;
+    drawCircleSection(x, y, x0, y0, option);
+  }
+}
+
+void U8G2::drawDisc(u8g2_int_t x0, u8g2_int_t y0, u8g2_int_t rad, uint8_t option)
+{
+  for(u8g2_int_t dy=-rad; dy<=rad; dy++)
+  {
+    for(u8g2_int_t dx=-rad; dx<=rad; dx++)
+    {
+      if(dx * dx + dy * dy <= rad * rad)
+      {
+        drawPixel(x0 + dx, y0 + dy);
+      }
+    }
+  }
+}
+
+void U8G2::drawXBMP(u8g2_int_t x, u8g2_int_t y, u8g2_int_t w, u8g2_int_t h, const uint8_t* pBitmap)
+{
+  // XBM: rows of (w + 7) / 8 bytes, LSB is the leftmost pixel; in solid bitmap mode the background is drawn as well
+  u8g2_int_t bytesPerRow = (w + 7) / 8;
+  uint8_t color = mDrawColor;
+  for(u8g2_int_t row=0; row<h; row++)
+  {
+    for(u8g2_int_t col=0; col<w; col++)
+    {
+      bool set = pBitmap[row * bytesPerRow + col / 8] & (1 << (col & 7));
+      if(set)
+      {
+        drawPixel(x + col, y + row);
+      }
+      else if(!mBitmapTransparent && color < 2)
+      {
+        mDrawColor = !color;
+        drawPixel(x + col, y + row);
+        mDrawColor = color;
+      }
+    }
+  }
+}
+
+u8g2_uint_t U8G2::getStrWidth(const char* str)
+{
+  return strlen(str) * glyphWidth();
+}
+
+u8g2_uint_t U8G2::drawStr(u8g2_int_t x, u8g2_int_t y, const char* str)
+{
+  // placeholder: one box per character, standing on the baseline `y`
+  u8g2_int_t w = glyphWidth();
+  u8g2_int_t h = glyphHeight();
+  for(size_t i=0; str[i] != '\0'; i++)
+  {
+    if(str[i] != ' ')
+    {
+      drawBox(x + i * w, y - h + 1, w - 1, h);
+    }
+  }
+  return getStrWidth(str);
+}
+
+u8g2_uint_t U8G2::drawGlyph(u8g2_int_t x, u8g2_int_t y, uint16_t encoding)
+{
+  u8g2_int_t w = glyphWidth();
+  u8g2_int_t h = glyphHeight();
+  drawFrame(x, y - h + 1, w, h);
+  drawPixel(x + (encoding % (w - 2)) + 1, y - h / 2); // make different glyphs distinguishable
+  return w;
+}
+
+void U8G2::drawButtonUTF8(u8g2_int_t x, u8g2_int_t y, uint8_t flags, u8g2_int_t width, u8g2_int_t paddingH, u8g2_int_t paddingV, const char* text)
+{
+  u8g2_int_t textWidth = getStrWidth(text);
+  u8g2_int_t h = glyphHeight();
+  if(width < textWidth)
+  {
+    width = textWidth;
+  }
+  drawStr(x, y, text);
+
+  u8g2_int_t bx = x - paddingH;
+  u8g2_int_t by = y - h + 1 - paddingV;
+  u8g2_int_t bw = width + 2 * paddingH;
+  u8g2_int_t bh = h + 2 * paddingV;
+  if(flags & U8G2_BTN_INV)
+  {
+    uint8_t color = mDrawColor;
+    mDrawColor = 2;
+    drawBox(bx, by, bw, bh);
+    mDrawColor = color;
+  }
+  for(uint8_t i=0; i<(flags & 0x0F); i++)
+  {
+    drawFrame(bx - 1 - i, by - 1 - i, bw + 2 + 2 * i, bh + 2 + 2 * i);
+  }
+}
+
+bool U8G2::writePbm(const char* path)
+{
+  FILE* pFile = fopen(path, "w");
+  if(pFile == nullptr)
+  {
+    return false;
+  }
+  fprintf(pFile, "P1\n%d %d\n", WIDTH, HEIGHT);
+  for(int y=0; y<HEIGHT; y++)
+  {
+    for(int x=0; x<WIDTH; x++)
+    {
+      fputc((mSentBuffer[(y >> 3) * WIDTH + x] & (1 << (y & 7))) ? '1' : '0', pFile);
+    }
+    fputc('\n', pFile);
+  }
+  fclose(pFile);
+  return true;
+}
@@ -0,0 +1,117 @@
+#ifndef HostU8g2lib_h
+#define HostU8g2lib_h
+
+// Framebuffer stand-in for the parts of the U8g2 API used by the firmware: a 128x64 monochrome full frame buffer with the
+// SSD1306/U8g2 memory layout (8 pages of 128 bytes, one bit per pixel row within a page). Lines, circles, boxes and
+// XBM bitmaps are rasterized; as there are no font files on the host, text and glyphs are drawn as placeholder boxes
+// of the font's nominal glyph size. "Sending" a frame counts frames and bytes and lets the simulated bus time pass.
+
+#include "Arduino.h"
+
+typedef int16_t u8g2_int_t;
+typedef uint16_t u8g2_uint_t;
+
+#define U8G2_R0 0
+#define U8G2_R2 2
+#define U8X8_PIN_NONE 255
+
+#define U8G2_DRAW_UPPER_RIGHT 0x01
+#define U8G2_DRAW_UPPER_LEFT 0x02
+#define U8G2_DRAW_LOWER_LEFT 0x04
+#define U8G2_DRAW_LOWER_RIGHT 0x08
+#define U8G2_DRAW_ALL (U8G2_DRAW_UPPER_RIGHT | U8G2_DRAW_UPPER_LEFT | U8G2_DRAW_LOWER_RIGHT | U8G2_DRAW_LOWER_LEFT)
+
+#define U8G2_BTN_BW1 0x01
+#define U8G2_BTN_BW2 0x02
+#define U8G2_BTN_SHADOW1 0x10
+#define U8G2_BTN_INV 0x20
+#define U8G2_BTN_HCENTER 0x40
+
+// placeholder fonts: {glyph width, glyph height}
+extern const uint8_t u8g2_font_chikita_tn[];
+extern const uint8_t u8g2_font_chikita_tf[];
+extern const uint8_t u8g2_font_siji_t_6x10[];
+extern const uint8_t u8g2_font_streamline_interface_essential_other_t[];
+extern const uint8_t u8g2_font_streamline_map_navigation_t[];
+extern const uint8_t u8g2_font_streamline_interface_essential_link_t[];
+extern const uint8_t u8g2_font_unifont_t_animals[];
+extern const uint8_t u8g2_font_unifont_t_symbols[];
+extern const uint8_t u8g2_font_7x13_t_symbols[];
+
+class U8G2 {
+  public:
+    static const uint8_t WIDTH = 128;
+    static const uint8_t HEIGHT = 64;
+    static const size_t BUFFER_SIZE = WIDTH * HEIGHT / 8;
+
+    U8G2();
+
+    bool begin() { clearBuffer(); return true; }
+    void clearBuffer() { memset(mBuffer, 0, sizeof(mBuffer)); }
+    void clearDisplay() { clearBuffer(); sendBuffer(); }
+    void sendBuffer();
+    void updateDisplay() { sendBuffer(); }
+    void updateDisplayArea(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th);
+    uint8_t* getBufferPtr() { return mBuffer; }
+    uint8_t getBufferTileWidth() { return WIDTH / 8; }
+    uint8_t getBufferTileHeight() { return HEIGHT / 8; }
+    u8g2_uint_t getDisplayWidth() { return WIDTH; }
+    u8g2_uint_t getDisplayHeight() { return HEIGHT; }
+    void setBusClock(uint32_t clockSpeed) {}
+
+    void setDrawColor(uint8_t color) { mDrawColor = color; }
+    void setBitmapMode(uint8_t isTransparent) { mBitmapTransparent = isTransparent; }
+    void setFlipMode(uint8_t isEnable) {}
+    void setFont(const uint8_t* pFont) { mpFont = pFont; }
+    void setFontMode(uint8_t isTransparent) {}
+
+    void drawPixel(u8g2_int_t x, u8g2_int_t y);
+    void drawHLine(u8g2_int_t x, u8g2_int_t y, u8g2_int_t w);
+    void drawVLine(u8g2_int_t x, u8g2_int_t y, u8g2_int_t h);
+    void drawLine(u8g2_int_t x1, u8g2_int_t y1, u8g2_int_t x2, u8g2_int_t y2);
+    void drawBox(u8g2_int_t x, u8g2_int_t y, u8g2_int_t w, u8g2_int_t h);
+    void drawFrame(u8g2_int_t x, u8g2_int_t y, u8g2_int_t w, u8g2_int_t h);
+    void drawCircle(u8g2_int_t x0, u8g2_int_t y0, u8g2_int_t rad, uint8_t option = U8G2_DRAW_ALL);
+    void drawDisc(u8g2_int_t x0, u8g2_int_t y0, u8g2_int_t rad, uint8_t option = U8G2_DRAW_ALL);
+    void drawXBMP(u8g2_int_t x, u8g2_int_t y, u8g2_int_t w, u8g2_int_t h, const uint8_t* pBitmap);
+    void drawXBM(u8g2_int_t x, u8g2_int_t y, u8g2_int_t w, u8g2_int_t h, const uint8_t* pBitmap) { drawXBMP(x, y, w, h, pBitmap); }
+    u8g2_uint_t drawStr(u8g2_int_t x, u8g2_int_t y, const char* str);
+    u8g2_uint_t drawUTF8(u8g2_int_t x, u8g2_int_t y, const char* str) { return drawStr(x, y, str); }
+    u8g2_uint_t drawGlyph(u8g2_int_t x, u8g2_int_t y, uint16_t encoding);
+    void drawButtonUTF8(u8g2_int_t x, u8g2_int_t y, uint8_t flags, u8g2_int_t width, u8g2_int_t paddingH, u8g2_int_t paddingV, const char* text);
+    u8g2_uint_t getStrWidth(const char* str);
+    u8g2_uint_t getUTF8Width(const char* str) { return getStrWidth(str); }
+
+    // host side
+    unsigned int getTransferCount() { return mTransferCount; } // sendBuffer() and updateDisplayArea() calls
+    size_t getBytesSent() { return mBytesSent; }
+    const uint8_t* getSentBuffer() { return mSentBuffer; }
+    bool writePbm(const char* path); // writes the last sent frame as portable bitmap
+    void setFrameTransferMicros(uint32_t us) { mFrameTransferUs = us; } // simulated bus time of a full frame
+
+  private:
+    uint8_t glyphWidth() { return mpFont ? mpFont[0] : 5; }
+    uint8_t glyphHeight() { return mpFont ? mpFont[1] : 7; }
+    void drawCircleSection(u8g2_int_t x, u8g2_int_t y, u8g2_int_t x0, u8g2_int_t y0, uint8_t option);
+
+    uint8_t mBuffer[BUFFER_SIZE];
+    uint8_t mSentBuffer[BUFFER_SIZE]; // what the display would show
+    uint8_t mDrawColor;
+    uint8_t mBitmapTransparent;
+    const uint8_t* mpFont;
+    unsigned int mTransferCount;
+    size_t mBytesSent;
+    uint32_t mFrameTransferUs;
+};
+
+class U8G2_SSD1306_128X64_NONAME_F_SW_I2C : public U8G2 {
+  public:
+    U8G2_SSD1306_128X64_NONAME_F_SW_I2C(int rotation, uint8_t clock, uint8_t data, uint8_t reset = U8X8_PIN_NONE) {}
+};
+
+class U8G2_SSD1306_128X64_NONAME_F_HW_I2C : public U8G2 {
+  public:
+    U8G2_SSD1306_128X64_NONAME_F_HW_I2C(int rotation, uint8_t reset = U8X8_PIN_NONE, uint8_t clock = U8X8_PIN_NONE, uint8_t data = U8X8_PIN_NONE) {}
+};
+
+#endif